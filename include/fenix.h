@@ -89,8 +89,10 @@ extern "C" {
 #define FENIX_ERROR_NODATA_FOUND            -30
 #define FENIX_ERROR_INTERN                  -40
 #define FENIX_ERROR_CANCELLED               -50
+#define FENIX_ERROR_CORRUPTED_DATA          -60
 #define FENIX_WARNING_SPARE_RANKS_DEPLETED  100
 #define FENIX_WARNING_PARTIAL_RESTORE       101
+#define FENIX_WARNING_SDC_DETECTED          102
 
 #define FENIX_DATA_GROUP_WORLD_ID            10
 #define FENIX_GROUP_ID_MAX                   11
@@ -100,23 +102,60 @@ extern "C" {
 #define FENIX_DATA_MEMBER_ATTRIBUTE_COUNT    12
 #define FENIX_DATA_MEMBER_ATTRIBUTE_DATATYPE 13
 #define FENIX_DATA_MEMBER_ATTRIBUTE_SIZE     14
+#define FENIX_DATA_MEMBER_ATTRIBUTE_COUNT_C  17
+//int elements per deduplication block, 0 (default) disables. Must match on all ranks.
+//Blocks the partner already holds are not sent, which saves bandwidth only: the
+//partner still keeps a full copy.
+#define FENIX_DATA_MEMBER_ATTRIBUTE_DEDUP_BLOCK 18
+//double absolute error an MPI_FLOAT or MPI_DOUBLE member of an in-memory RAID-1
+//group may be restored with, 0 (default) keeps it exact. Must match on all ranks.
+#define FENIX_DATA_MEMBER_ATTRIBUTE_ERROR_BOUND 19
 #define FENIX_DATA_SNAPSHOT_LATEST           -1
 #define FENIX_DATA_SNAPSHOT_ALL              16
 #define FENIX_DATA_SUBSET_CREATED             2
 
 #define FENIX_DATA_POLICY_IN_MEMORY_RAID 13
 
+//RAID mode for FENIX_DATA_POLICY_IN_MEMORY_RAID: RAID-1 which keeps only the
+//partner's copy of each snapshot. Own data is fetched back from the partner
+//on restore, so it is lost if the partner fails.
+#define FENIX_DATA_POLICY_IMR_PARTNER_ONLY 11
+
+//Snapshot retention for Fenix_Data_group_set_retention, deciding which
+//snapshot a commit gives up once a group already holds depth+1 of them.
+//  SLIDING:     the oldest one (default).
+//  EVERY_NTH:   the oldest one whose timestamp is not a multiple of interval.
+//  EXPONENTIAL: the one whose loss least disturbs a spacing that grows with
+//               age. The oldest snapshot is always kept.
+//Both of the latter never give up the newest keep_last snapshots.
+#define FENIX_DATA_RETENTION_SLIDING     0
+#define FENIX_DATA_RETENTION_EVERY_NTH   1
+#define FENIX_DATA_RETENTION_EXPONENTIAL 2
+
+//Region kinds for Fenix_Data_member_sdc_region. Both are checked by every store,
+//which returns FENIX_WARNING_SDC_DETECTED after reporting a mismatch to the
+//callback given to Fenix_Data_sdc_callback_register.
+//  REPLICATED: must hold the same values on the rank and its redundancy partners.
+//  IMMUTABLE:  must not change from one store to the next.
+#define FENIX_DATA_SDC_REPLICATED 1
+#define FENIX_DATA_SDC_IMMUTABLE  2
+
 typedef enum {
     FENIX_ROLE_INITIAL_RANK = 0,
     FENIX_ROLE_RECOVERED_RANK = 1,
     FENIX_ROLE_SURVIVOR_RANK = 2
 } Fenix_Rank_role;
 
+//Handle to a non-blocking data operation. Its fields are Fenix's own, a
+//request is only passed to Fenix_Data_wait and the other completion calls,
+//after which it refers to nothing and completes right away if used again.
 typedef struct {
-    MPI_Request mpi_send_req;
-    MPI_Request mpi_recv_req;
+    int slot;
+    unsigned int generation;
 } Fenix_Request;
 
+extern const Fenix_Request FENIX_REQUEST_NULL;
+
 extern const Fenix_Data_subset  FENIX_DATA_SUBSET_FULL;
 extern const Fenix_Data_subset  FENIX_DATA_SUBSET_EMPTY;
 
@@ -151,6 +190,9 @@ int Fenix_Data_group_create(int group_id, MPI_Comm, int start_time_stamp,
 int Fenix_Data_member_create(int group_id, int member_id, void *buffer,
                              int count, MPI_Datatype datatype);
 
+int Fenix_Data_member_create_c(int group_id, int member_id, void *buffer,
+                               MPI_Count count, MPI_Datatype datatype);
+
 int Fenix_Data_group_get_redundancy_policy(int group_id, int* policy_name,
                                            void *policy_value, int *flag);
 
@@ -158,6 +200,16 @@ int Fenix_Data_wait(Fenix_Request request);
 
 int Fenix_Data_test(Fenix_Request request, int *flag);
 
+//Completion of several requests at once, as MPI_Waitall, MPI_Testany and
+//MPI_Testsome. Completed requests are set to FENIX_REQUEST_NULL, and index or
+//outcount is MPI_UNDEFINED when none is left to complete. Waitall advances
+//every request in turn, so each one's next step starts as soon as it can.
+int Fenix_Data_waitall(int count, Fenix_Request *requests);
+
+int Fenix_Data_testany(int count, Fenix_Request *requests, int *index, int *flag);
+
+int Fenix_Data_testsome(int count, Fenix_Request *requests, int *outcount, int *indices);
+
 int Fenix_Data_member_store(int group_id, int member_id,
                             Fenix_Data_subset subset_specifier);
 
@@ -172,15 +224,40 @@ int Fenix_Data_member_istorev(int member_id, int group_id,
                               Fenix_Data_subset subset_specifier,
                               Fenix_Request *request);
 
+//Stores all of a member from *buffer, which Fenix keeps as the snapshot
+//instead of copying it, and sets *buffer to a buffer of the same size for the
+//app to fill next. The buffer handed over may still be read, but not written,
+//until the member's next store_swap. A buffer that didn't come from Fenix is
+//copied and stays the app's, so double-buffered codes can start from their
+//own buffer. Buffers from Fenix are freed with the member. One lent out before
+//the member is resized stays valid until it is handed back, when it is copied
+//like the app's own and a buffer of the new size is lent instead. Returns
+//FENIX_ERROR_INVALID_LOGIC_CALL without storing if the member's snapshots
+//can't be laid out like its buffer, e.g. for non-contiguous datatypes or
+//partner-only and one-sided in-memory RAID, or if the member has grown past
+//the lent buffer handed back.
+int Fenix_Data_member_store_swap(int group_id, int member_id, void **buffer);
+
 int Fenix_Data_commit(int group_id, int *time_stamp);
 
 int Fenix_Data_commit_barrier(int group_id, int *time_stamp);
 
+//Non-blocking commit and commit_barrier. The snapshot becomes the restore
+//target, and *time_stamp is set, only once every rank has agreed to the commit
+//and the request has completed in Fenix_Data_wait or Fenix_Data_test. Storing
+//to the group, or committing it again, completes the request first.
+int Fenix_Data_icommit(int group_id, int *time_stamp, Fenix_Request *request);
+
+int Fenix_Data_icommit_barrier(int group_id, int *time_stamp, Fenix_Request *request);
+
 int Fenix_Data_barrier(int group_id);
 
 int Fenix_Data_member_restore(int group_id, int member_id, void *target_buffer,
                               int max_count, int time_stamp, Fenix_Data_subset* found_data);
 
+int Fenix_Data_member_restore_c(int group_id, int member_id, void *target_buffer,
+                                MPI_Count max_count, int time_stamp, Fenix_Data_subset* found_data);
+
 int Fenix_Data_member_restore_from_rank(int member_id, void *data, int max_count,
                                         int time_stamp, int group_id,
                                         int source_rank);
@@ -192,6 +269,14 @@ int Fenix_Data_subset_createv(int num_blocks, int *array_start_offsets,
                               int *array_end_offsets,
                               Fenix_Data_subset *subset_specifier);
 
+int Fenix_Data_subset_create_c(MPI_Count num_blocks, MPI_Count start_offset,
+                               MPI_Count end_offset, MPI_Count stride,
+                               Fenix_Data_subset *subset_specifier);
+
+int Fenix_Data_subset_createv_c(int num_blocks, MPI_Count *array_start_offsets,
+                                MPI_Count *array_end_offsets,
+                                Fenix_Data_subset *subset_specifier);
+
 int Fenix_Data_subset_delete(Fenix_Data_subset *subset_specifier);
 
 int Fenix_Data_group_get_number_of_members(int group_id, int *number_of_members);
@@ -215,6 +300,40 @@ int Fenix_Data_snapshot_delete(int group_id, int time_stamp);
 
 int Fenix_Data_group_delete(int group_id);
 
+int Fenix_Data_group_should_checkpoint(int group_id, int *flag);
+
+//Called by every active rank where each member's buffer holds consistent
+//data. If a health monitor warned any rank of an imminent failure since the
+//last call, every group is stored in full and committed at once, and
+//*checkpointed is set to 1. Warnings are a signal (FENIX_WARNING_SIGNAL info
+//key: SIGUSR1, SIGUSR2 or a number) or the creation or touch of a file
+//(FENIX_WARNING_FILE). With FENIX_WARNING_REBALANCE and FENIX_HOT_STANDBY
+//ON, a warned rank returns only once its spare holds the new snapshots.
+//Warnings also make Fenix_Data_group_should_checkpoint advise a checkpoint.
+int Fenix_Data_safe_point(int *checkpointed);
+
+int Fenix_Data_group_set_memory_budget(int group_id, size_t budget);
+
+int Fenix_Data_group_get_memory_usage(int group_id, size_t *usage, size_t *high_water);
+
+//After a repair, each commit rebuilds the redundancy of members the app
+//hasn't restored, FENIX_REPROTECT_BYTES worth at a time. If a member can't be
+//rebuilt, the commit returns the error without committing and the member
+//stays pending until a later commit, or the app restoring or deleting it.
+//Sets num_members to how many are left, 0 once the group is fully protected
+//again.
+int Fenix_Data_group_get_reprotect_pending(int group_id, int *num_members);
+
+int Fenix_Data_group_set_retention(int group_id, int policy, int keep_last, int interval);
+
+int Fenix_Data_group_scrub(int group_id, int *num_repaired);
+
+int Fenix_Data_member_sdc_region(int group_id, int member_id, int kind,
+                                 Fenix_Data_subset subset_specifier);
+
+int Fenix_Data_sdc_callback_register(void (*detected)(int, int, int, void *),
+                                     void *callback_data);
+
 int Fenix_Data_member_delete(int group_id, int member_id);
 
 int Fenix_Process_fail_list(int** fail_list);
@@ -57,14 +57,20 @@
 #define __FENIX_DATA_GROUP_H__
 
 #include <mpi.h>
+#include <pthread.h>
 #include "fenix.h"
 #include "fenix_data_member.h"
 #include "fenix_data_packet.h"
 #include "fenix_util.h"
 #include "fenix_data_subset.h"
+#include "fenix_progress.h"
 
 #define __FENIX_DEFAULT_GROUP_SIZE 32
 
+//Snapshot bytes a commit rebuilds the redundancy of after a repair, unless
+//set with FENIX_REPROTECT_BYTES. At least one member is rebuilt per commit.
+#define __FENIX_DEFAULT_REPROTECT_BYTES ((size_t)64 << 20)
+
 typedef struct __fenix_group_vtbl fenix_group_vtbl_t;
 typedef struct __fenix_group fenix_group_t;
 
@@ -85,6 +91,11 @@ typedef struct __fenix_group_vtbl {
    int (*member_storev)(fenix_group_t* group, int member_id, 
            Fenix_Data_subset subset_specifier);
 
+   //Stores all of a member from *buffer, taking the buffer as the snapshot
+   //and setting *buffer to one the app may fill next.
+   int (*member_store_swap)(fenix_group_t* group, int member_id, void** buffer);
+
+   //Pushes whatever it leaves in flight onto request as stages that complete it.
    int (*member_istore)(fenix_group_t* group, int member_id, 
            Fenix_Data_subset subset_specifier, Fenix_Request *request);
 
@@ -98,7 +109,7 @@ typedef struct __fenix_group_vtbl {
    int (*barrier)(fenix_group_t* group);
 
    int (*member_restore)(fenix_group_t* group, int member_id,
-           void* target_buffer, int max_count, int time_stamp,
+           void* target_buffer, size_t max_count, int time_stamp,
            Fenix_Data_subset* data_found);
 
    int (*member_restore_from_rank)(fenix_group_t* group, int member_id,
@@ -119,6 +130,12 @@ typedef struct __fenix_group_vtbl {
    int (*member_set_attribute)(fenix_group_t* group, fenix_member_entry_t* mentry, 
            int attributename, void* attributevalue, int* flag);
 
+   int (*scrub)(fenix_group_t* group, int* num_repaired);
+
+   //Rebuilds a member's redundancy after a repair, as a restore would without
+   //handing the data to the app. Called on every rank of the group.
+   int (*member_reprotect)(fenix_group_t* group, int member_id);
+
 } fenix_group_vtbl_t;
 
 //We keep basic bookkeeping info here, policy specific
@@ -134,6 +151,40 @@ typedef struct __fenix_group {
     int depth;
     int policy_name;
     fenix_member_t *member;
+
+    //Measured checkpoint cost, used for checkpoint interval advice.
+    double store_time;   // Seconds spent storing since the last commit
+    double ckpt_cost;    // Smoothed seconds per store+commit cycle, 0 if unmeasured
+    double last_commit;  // MPI_Wtime() of the last commit (or group creation)
+
+    //Guards the statistics concurrent stores of different members update.
+    pthread_mutex_t stats_lock;
+
+    //A commit started by icommit, applied once its agreement completes. Until
+    //then the group's newest snapshot stays the restore target.
+    int commit_pending;
+    int commit_barrier;        // Check for revocations first, as commit_barrier does
+    int commit_flag;           // Agreement value
+    int *commit_timestamp;     // Where the app wants the new timestamp, or NULL
+    MPI_Request commit_request;
+    fenix_progress_op_t commit_op;
+    pthread_mutex_t commit_lock;
+
+    //Bytes of snapshot storage, as reported by the policy.
+    size_t memory_budget;     // Limit the policy keeps to by dropping old snapshots, 0 for none
+    size_t memory_usage;      // Currently allocated
+    size_t memory_high_water; // Largest memory_usage seen
+
+    //Which snapshot a full policy gives up on commit, see FENIX_DATA_RETENTION_*.
+    int retention_policy;
+    int retention_keep;       // Newest snapshots never given up
+    int retention_interval;   // Timestamp spacing kept by EVERY_NTH
+
+    //Members some rank lost in a failure and that the app hasn't restored
+    //yet. Commits rebuild their redundancy a few at a time.
+    int *reprotect_ids;
+    size_t *reprotect_bytes;  // Size of each member, to pace the rebuild
+    int reprotect_count;
 } fenix_group_t;
 
 typedef struct __fenix_data_recovery {
@@ -153,6 +204,12 @@ fenix_data_recovery_t * __fenix_data_recovery_init();
 
 int __fenix_group_delete(int groupid);
 
+void __fenix_group_memory_add(fenix_group_t *group, size_t bytes);
+
+void __fenix_group_memory_remove(fenix_group_t *group, size_t bytes);
+
+int __fenix_group_retention_victim(fenix_group_t *group, const int *timestamps, int count);
+
 int __fenix_member_delete(int groupid, int memberid);
 
 void __fenix_data_recovery_destroy( fenix_data_recovery_t *fx_data_recovery );
@@ -0,0 +1,90 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#ifndef __FENIX_DATA_LAYOUT_H__
+#define __FENIX_DATA_LAYOUT_H__
+
+#include <mpi.h>
+#include <stddef.h>
+
+//One contiguous run of bytes in an element of a member's datatype.
+typedef struct {
+    MPI_Aint displacement;
+    size_t length;
+} fenix_data_span_t;
+
+//Flattened type map of a member's datatype, computed once when the datatype is set.
+//Spans are in type map order, so copying them in sequence produces the same packed
+//bytes that MPI_Pack would. Element i of a user buffer starts at i*extent.
+typedef struct {
+    int num_spans;
+    int contiguous;
+    size_t size;
+    MPI_Aint extent;
+    fenix_data_span_t *spans;
+} fenix_data_layout_t;
+
+int __fenix_data_layout_init(fenix_data_layout_t *layout, MPI_Datatype datatype);
+int __fenix_data_layout_init_from_spans(fenix_data_layout_t *layout, int num_spans,
+        fenix_data_span_t *spans, MPI_Aint extent);
+int __fenix_data_layout_build_datatype(fenix_data_layout_t *layout, MPI_Datatype *datatype);
+void __fenix_data_layout_free(fenix_data_layout_t *layout);
+
+void __fenix_data_layout_pack(fenix_data_layout_t *layout, void *dest, const void *src,
+        size_t first, size_t count);
+void __fenix_data_layout_unpack(fenix_data_layout_t *layout, void *dest, const void *src,
+        size_t first, size_t count);
+
+#endif // __FENIX_DATA_LAYOUT_H__
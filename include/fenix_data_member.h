@@ -57,8 +57,12 @@
 #define __FENIX_DATA_MEMBER_H__
 
 #include <mpi.h>
+#include <pthread.h>
 #include "fenix_data_packet.h"
 #include "fenix_util.h"
+#include "fenix_data_layout.h"
+#include "fenix_data_subset.h"
+#include "fenix_dirty.h"
 
 
 #define __FENIX_DEFAULT_MEMBER_SIZE 512
@@ -69,7 +73,19 @@ typedef struct __fenix_member_entry {
     void *user_data;
     MPI_Datatype current_datatype;
     int datatype_size;
-    int current_count;
+    size_t current_count;
+    fenix_data_layout_t layout;
+    int owns_datatype;
+    //Regions checked for silent data corruption on every store.
+    Fenix_Data_subset sdc_replicated;
+    Fenix_Data_subset sdc_immutable;
+    int sdc_has_reference;
+    uint32_t sdc_reference;
+    //Pages written since the member's last store, NULL until it is tracked.
+    fenix_dirty_t *dirty;
+    //Serializes threads working on this member. Allocated separately so that
+    //growing the entry array doesn't move a mutex.
+    pthread_mutex_t *lock;
 } fenix_member_entry_t;
 
 typedef struct __fenix_member {
@@ -82,7 +98,13 @@ typedef struct __member_entry_packet {
     int memberid;
     MPI_Datatype current_datatype;
     int datatype_size;
-    int current_count;
+    size_t current_count;
+    //Derived datatype handles mean nothing on another rank, so their
+    //flattened spans follow the packet and the receiver rebuilds the type.
+    int named_datatype;
+    int num_spans;
+    MPI_Aint extent;
+    int rebuilt_datatype;
 } fenix_member_entry_packet_t;
 
 fenix_member_t *__fenix_data_member_init( );
@@ -92,7 +114,12 @@ void __fenix_ensure_member_capacity( fenix_member_t *m );
 void __fenix_ensure_version_capacity_from_member( fenix_member_t *m );
 
 fenix_member_entry_t* __fenix_data_member_add_entry(fenix_member_t* member, 
-        int memberid, void* data, int count, MPI_Datatype datatype);
+        int memberid, void* data, size_t count, MPI_Datatype datatype);
+
+int __fenix_data_member_set_datatype(fenix_member_entry_t* mentry, MPI_Datatype datatype);
+void __fenix_data_member_free_entry(fenix_member_entry_t* mentry);
+void __fenix_data_member_clear_sdc(fenix_member_entry_t* mentry);
+void __fenix_data_member_release_entry(fenix_member_entry_t* mentry);
 
 int __fenix_data_member_send_metadata(int groupid, int memberid, int dest_rank);
 int __fenix_data_member_recv_metadata(int groupid, int src_rank, 
@@ -74,6 +74,9 @@
 #define __NUM_MEMBER_ATTR_SIZE  3
 #define __GRP_MEMBER_LENTRY_ATTR_SIZE 11
 
+//Weight given to the newest sample of a group's checkpoint cost.
+#define __FENIX_CKPT_COST_SMOOTHING 0.25
+
 
 
 
@@ -111,17 +114,19 @@ int store_counter;
 
 int __fenix_group_create(int, MPI_Comm, int, int, int, void*, int*);
 int __fenix_group_get_redundancy_policy(int, int*, int*, int*);
-int __fenix_member_create(int, int, void *, int, MPI_Datatype);
-int __fenix_data_wait(Fenix_Request);
-int __fenix_data_test(Fenix_Request, int *);
+int __fenix_member_create(int, int, void *, size_t, MPI_Datatype);
 int __fenix_member_store(int, int, Fenix_Data_subset);
 int __fenix_member_storev(int, int, Fenix_Data_subset);
+int __fenix_member_store_swap(int, int, void **);
 int __fenix_member_istore(int, int, Fenix_Data_subset, Fenix_Request *);
 int __fenix_member_istorev(int, int, Fenix_Data_subset, Fenix_Request *);
 int __fenix_data_commit(int, int *);
 int __fenix_data_commit_barrier(int, int *);
+int __fenix_data_icommit(int, int *, Fenix_Request *, int);
+int __fenix_data_commit_complete(fenix_group_t *, int, int *);
+int __fenix_data_commit_settle(fenix_group_t *);
 int __fenix_data_barrier(int);
-int __fenix_member_restore(int, int, void *, int, int, Fenix_Data_subset*);
+int __fenix_member_restore(int, int, void *, size_t, int, Fenix_Data_subset*);
 int __fenix_member_restore_from_rank(int, int, void *, int, int, int);
 int __fenix_get_number_of_members(int, int *);
 int __fenix_get_member_at_position(int, int *, int);
@@ -130,10 +135,27 @@ int __fenix_get_snapshot_at_position(int, int, int *);
 int __fenix_member_get_attribute(int, int, int, void *, int *, int);
 int __fenix_member_set_attribute(int, int, int, void *, int *);
 int __fenix_snapshot_delete(int groupid, int timestamp);
+int __fenix_group_should_checkpoint(int, int *);
+int __fenix_data_safe_point(int *);
+int __fenix_group_set_memory_budget(int, size_t);
+int __fenix_group_get_memory_usage(int, size_t *, size_t *);
+int __fenix_group_get_reprotect_pending(int, int *);
+int __fenix_group_set_retention(int, int, int, int);
+int __fenix_group_scrub(int, int *);
+int __fenix_member_sdc_region(int, int, int, Fenix_Data_subset);
+int __fenix_sdc_callback_register(void (*)(int, int, int, void *), void *);
+void __fenix_sdc_report(int, int, int);
 
 int __fenix_group_delete(int);
 int __fenix_member_delete(int, int);
 
+void __fenix_data_lock(int exclusive);
+void __fenix_data_unlock();
+void __fenix_data_member_lock(fenix_group_t *group, int memberid);
+void __fenix_data_member_unlock();
+void __fenix_data_release_held();
+void __fenix_data_reprotect_drop(fenix_group_t *group, int memberid);
+
 void __fenix_init_data_recovery();
 void __fenix_init_partner_copy_recovery();
 
@@ -0,0 +1,102 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#ifndef __FENIX_DATA_REQUEST_H__
+#define __FENIX_DATA_REQUEST_H__
+
+#include "fenix.h"
+#include "fenix_data_group.h"
+
+typedef struct __fenix_request_stage fenix_request_stage_t;
+
+//Advances one stage of a request, setting flag once the stage has completed.
+//With wait it blocks until then. Returns a Fenix error code, which ends the
+//request without running its later stages.
+typedef int (*fenix_request_advance_t)(fenix_group_t *group, fenix_request_stage_t *stage,
+                                       int wait, int *flag);
+
+//One step of a non-blocking operation. A request runs its stages in the
+//order they were pushed, each one starting once the one before completes.
+struct __fenix_request_stage {
+    fenix_request_advance_t advance;
+    int member_id;                // Member locked while the stage advances, or __FENIX_REQUEST_GROUP
+    void *data;                   // Left to the stage
+};
+
+//Member id of a stage that works on the whole group.
+#define __FENIX_REQUEST_GROUP -1
+
+Fenix_Request __fenix_request_create(int group_id);
+
+void __fenix_request_push(Fenix_Request request, fenix_request_advance_t advance,
+                          int member_id, void *data);
+
+int __fenix_request_is_null(Fenix_Request request);
+
+void __fenix_request_finish_empty(Fenix_Request *request);
+
+void __fenix_request_finalize();
+
+int __fenix_data_wait(Fenix_Request request);
+
+int __fenix_data_test(Fenix_Request request, int *flag);
+
+int __fenix_data_waitall(int count, Fenix_Request *requests);
+
+int __fenix_data_testany(int count, Fenix_Request *requests, int *index, int *flag);
+
+int __fenix_data_testsome(int count, Fenix_Request *requests, int *outcount, int *indices);
+
+#endif // __FENIX_DATA_REQUEST_H__
@@ -56,6 +56,8 @@
 #ifndef __FENIX_DATA_SUBSET_H__
 #define __FENIX_DATA_SUBSET_H__
 #include <mpi.h>
+#include <stdint.h>
+#include "fenix_data_layout.h"
 
 #define __FENIX_SUBSET_EMPTY   1
 #define __FENIX_SUBSET_FULL    2
@@ -70,16 +72,17 @@
 //FULL/EMPTY.
 typedef struct {
     int num_blocks;
-    int* start_offsets;
-    int* end_offsets;
-    int* num_repeats;
-    int stride;
+    MPI_Count* start_offsets;
+    MPI_Count* end_offsets;
+    MPI_Count* num_repeats;
+    MPI_Count stride;
     int specifier;
 } Fenix_Data_subset;
 
 int __fenix_data_subset_init(int num_blocks, Fenix_Data_subset* subset);
-int __fenix_data_subset_create(int, int, int, int, Fenix_Data_subset *);
+int __fenix_data_subset_create(MPI_Count, MPI_Count, MPI_Count, MPI_Count, Fenix_Data_subset *);
 int __fenix_data_subset_createv(int, int *, int *, Fenix_Data_subset *);
+int __fenix_data_subset_createv_c(int, MPI_Count *, MPI_Count *, Fenix_Data_subset *);
 void __fenix_data_subset_deep_copy(Fenix_Data_subset* from, Fenix_Data_subset* to);
 void __fenix_data_subset_merge(Fenix_Data_subset* first_subset, 
       Fenix_Data_subset* second_subset, Fenix_Data_subset* output);
@@ -87,14 +90,32 @@ void __fenix_data_subset_merge_inplace(Fenix_Data_subset* first_subset,
       Fenix_Data_subset* second_subset);
 void __fenix_data_subset_copy_data(Fenix_Data_subset* ss, void* dest,
       void* src, size_t data_type_size, size_t max_size);
-int __fenix_data_subset_data_size(Fenix_Data_subset* ss, size_t max_size);
+size_t __fenix_data_subset_data_size(Fenix_Data_subset* ss, size_t max_size);
 void* __fenix_data_subset_serialize(Fenix_Data_subset* ss, void* src, 
       size_t type_size, size_t max_size, size_t* output_size);
+void __fenix_data_subset_serialize_into(Fenix_Data_subset* ss, void* src, void* dest,
+      size_t type_size, size_t max_size);
 void __fenix_data_subset_deserialize(Fenix_Data_subset* ss, void* src, 
       void* dest, size_t max_size, size_t type_size);
+void __fenix_data_subset_put(Fenix_Data_subset* ss, void* src, size_t type_size,
+      size_t max_size, int target, MPI_Aint target_base, MPI_Win win);
+void __fenix_data_subset_copy_from_user(Fenix_Data_subset* ss, void* dest,
+      void* src, fenix_data_layout_t* layout, size_t max_size);
+void __fenix_data_subset_copy_to_user(Fenix_Data_subset* ss, void* dest,
+      void* src, fenix_data_layout_t* layout, size_t max_size);
+void* __fenix_data_subset_serialize_user(Fenix_Data_subset* ss, void* src,
+      fenix_data_layout_t* layout, size_t max_size, size_t* output_size);
+void __fenix_data_subset_serialize_user_into(Fenix_Data_subset* ss, void* src, void* dest,
+      fenix_data_layout_t* layout, size_t max_size);
+void __fenix_data_subset_deserialize_user(Fenix_Data_subset* ss, void* src,
+      void* dest, fenix_data_layout_t* layout, size_t max_size);
+uint32_t __fenix_data_subset_checksum_user(Fenix_Data_subset* ss, void* src,
+      fenix_data_layout_t* layout, size_t max_size);
 void __fenix_data_subset_send(Fenix_Data_subset* ss, int dest, int tag, MPI_Comm comm);
 void __fenix_data_subset_recv(Fenix_Data_subset* ss, int src, int tag, MPI_Comm comm);
+void __fenix_data_subset_clip(Fenix_Data_subset* ss, size_t max_size);
 int __fenix_data_subset_is_full(Fenix_Data_subset* ss, size_t data_length);
+int __fenix_data_subset_equal(Fenix_Data_subset* a, Fenix_Data_subset* b);
 int __fenix_data_subset_free(Fenix_Data_subset *);
 int __fenix_data_subset_delete(Fenix_Data_subset *);
 
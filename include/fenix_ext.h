@@ -62,6 +62,7 @@
 #include "fenix_opt.h"
 #include "fenix_data_group.h"
 #include "fenix_process_recovery.h"
+#include "fenix_failure_stats.h"
 
 typedef struct {
     int num_inital_ranks;     // Keeps the global MPI rank ID at Fenix_init
@@ -97,14 +98,30 @@ typedef struct {
     
     
     MPI_Errhandler mpi_errhandler;  // This stores callback info for our custom error handler
-    int ignore_errs;                // Set this to return errors instead of using the error handler normally. (Don't forget to unset!)
     int print_unhandled;            // Set this to print the error string for MPI errors of an unhandled return type.
 
+    fenix_failure_stats_t failure_stats; // Observed failure history, used for checkpoint interval advice
+    size_t memory_budget;           // Default snapshot memory budget for new data groups, 0 for none
+    size_t reprotect_bytes;         // Snapshot bytes each commit re-protects after a repair, 0 to leave it to restores
+    int imr_rma;                    // New in-memory RAID-1 groups store with one-sided RMA
+    int hot_standby;                // Committed snapshots are trickled to the spare ranks
+    int dirty_tracking;             // Full in-memory RAID-1 stores only store the pages written since the last one
+    int warning_rebalance;          // A warned rank makes sure its spare holds its newest snapshots
+    int thread_multiple;            // MPI_THREAD_MULTIPLE is provided, so the data API may be called from several threads
+
+    void (*sdc_callback)(int, int, int, void *); // Told of silent data corruption found by a store
+    void *sdc_callback_data;
+
 
 
     fenix_data_recovery_t *data_recovery;   // Global pointer for Fenix Data Recovery Data Structure
 } fenix_t;
 
 extern fenix_t fenix;
+
+//Whether the calling thread returns MPI errors instead of using the error
+//handler normally. Setting it returns the old value (don't forget to restore!)
+int __fenix_ignore_errs();
+int __fenix_set_ignore_errs(int ignore);
 #endif // __FENIX_EXT_H__
 
@@ -0,0 +1,90 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#ifndef __FENIX_FAILURE_STATS_H__
+#define __FENIX_FAILURE_STATS_H__
+
+#include <mpi.h>
+
+//Prior MTBF (seconds) used before enough failures have been observed.
+//Can be overridden with the FENIX_MTBF info key.
+#define __FENIX_DEFAULT_MTBF 86400.0
+
+//Failure history used to estimate the mean time between failures.
+//Values prefixed with prior_ were loaded from the stats file and
+//describe earlier runs; the rest describe the current run.
+typedef struct {
+    double run_start;         // MPI_Wtime() at Fenix_Init
+    double last_failure;      // MPI_Wtime() of the last repair, or run_start
+    double interarrival_sum;  // Sum of observed failure inter-arrival times
+    int    failures;          // Failures repaired during this run
+    double prior_exposure;    // Seconds of runtime recorded by earlier runs
+    int    prior_failures;    // Failures recorded by earlier runs
+    double default_mtbf;      // Pseudo-observation used until failures are seen
+    char  *path;              // Stats file, or NULL to keep history in memory only
+} fenix_failure_stats_t;
+
+void __fenix_failure_stats_init(fenix_failure_stats_t *stats, const char *path,
+                                double default_mtbf, MPI_Comm comm);
+
+void __fenix_failure_stats_record(fenix_failure_stats_t *stats);
+
+double __fenix_failure_stats_mtbf(fenix_failure_stats_t *stats);
+
+void __fenix_failure_stats_save(fenix_failure_stats_t *stats);
+
+void __fenix_failure_stats_destroy(fenix_failure_stats_t *stats);
+
+#endif // __FENIX_FAILURE_STATS_H__
@@ -0,0 +1,100 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#ifndef __FENIX_PROGRESS_H__
+#define __FENIX_PROGRESS_H__
+
+#include <mpi.h>
+
+//A set of started requests that Fenix drives to completion on the app's
+//behalf. Policies embed one per non-blocking operation and post it once its
+//requests are started; the engine then advances it from the progress thread,
+//if there is one, or from Fenix's own calls otherwise.
+typedef struct __fenix_progress_op {
+    MPI_Request *requests;
+    int count;
+    int posted;                        // On the engine's list
+    int done;                          // Every request has completed
+    int error;                         // Error class of a failed request, or MPI_SUCCESS
+    MPI_Comm comm;                     // Whose error handler sees failures
+    struct __fenix_progress_op *next;
+} fenix_progress_op_t;
+
+//No progress thread, or a thread that is not bound to a core.
+#define __FENIX_PROGRESS_OFF      -2
+#define __FENIX_PROGRESS_UNPINNED -1
+
+void __fenix_progress_init(int core);
+
+void __fenix_progress_finalize();
+
+int __fenix_progress_on_thread();
+
+void __fenix_progress_post(fenix_progress_op_t *op, MPI_Request *requests, int count,
+                           MPI_Comm comm);
+
+int __fenix_progress_test(fenix_progress_op_t *op, int *flag);
+
+int __fenix_progress_wait(fenix_progress_op_t *op);
+
+void __fenix_progress_abandon(fenix_progress_op_t *op);
+
+void __fenix_progress_abandon_all();
+
+int __fenix_progress_idle();
+
+void __fenix_progress_poll();
+
+#endif // __FENIX_PROGRESS_H__
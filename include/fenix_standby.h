@@ -0,0 +1,100 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef __FENIX_STANDBY_H__
+#define __FENIX_STANDBY_H__
+
+#include <mpi.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//Tag of the snapshot copies active ranks trickle to spare ranks on the world
+//communicator. The spares' finalize message uses tag 1.
+#define __FENIX_STANDBY_TAG 2011
+
+//Each copy is one of these followed by the parts' bytes. A snapshot is sent
+//as the parts its restore would receive, in the same order.
+typedef struct {
+    int groupid;
+    int memberid;
+    int timestamp;
+    int keep;          // Snapshots the sender's group retains
+    size_t bytes[2];
+} fenix_standby_header_t;
+
+int __fenix_standby_target();
+
+int __fenix_standby_ready(int groupid, int memberid);
+
+void __fenix_standby_send(fenix_standby_header_t *header, void *parts[2]);
+
+int __fenix_standby_recv(MPI_Status *status);
+
+int __fenix_standby_find(int groupid, int memberid, int timestamp, size_t bytes[2],
+                         void *parts[2], uint64_t fingerprints[2], uint32_t crcs[2]);
+
+void __fenix_standby_drop(int groupid, int memberid);
+
+int __fenix_standby_assign(int rank_offset, int *fail_world, int fail_world_size,
+                           int spare_ranks);
+
+void __fenix_standby_abandon();
+
+void __fenix_standby_flush();
+
+void __fenix_standby_finalize();
+
+#endif // __FENIX_STANDBY_H__
@@ -59,6 +59,7 @@
 
 #include "fenix_process_recovery.h"
 #include <mpi.h>
+#include <stdint.h>
 #include <syslog.h>
 #include <sys/types.h>
 #include <sys/times.h>
@@ -105,6 +106,28 @@ int __fenix_mpi_wait(MPI_Request *);
 
 int __fenix_mpi_test(MPI_Request *);
 
+//Largest single message used when splitting up large transfers.
+#define __FENIX_MAX_MSG_BYTES ((size_t)1 << 30)
+
+int __fenix_mpi_send_bytes(const void *, size_t, int, int, MPI_Comm);
+
+int __fenix_mpi_recv_bytes(void *, size_t, int, int, MPI_Comm);
+
+int __fenix_mpi_sendrecv_bytes(const void *, size_t, int, int, void *, size_t, int, int, MPI_Comm);
+
+int __fenix_mpi_sendrecv_init_count(size_t, size_t);
+
+int __fenix_mpi_sendrecv_init_bytes(const void *, size_t, int, int, void *, size_t, int, int,
+                                    MPI_Comm, MPI_Request *);
+
+int __fenix_mpi_reduce_bytes(const void *, void *, size_t, MPI_Op, int, MPI_Comm);
+
+int __fenix_mpi_reduce_local_bytes(const void *, void *, size_t, MPI_Op);
+
+uint64_t __fenix_fingerprint(const void *, size_t);
+
+uint32_t __fenix_crc32c(uint32_t, const void *, size_t);
+
 
 
 void *s_calloc(int count, size_t size);
@@ -55,6 +55,7 @@
 */
 
 #include "fenix_data_recovery.h"
+#include "fenix_data_request.h"
 #include "fenix_process_recovery.h"
 #include "fenix_util.h"
 #include "fenix_ext.h"
@@ -62,6 +63,7 @@
 
 const Fenix_Data_subset  FENIX_DATA_SUBSET_FULL = {0, NULL, NULL, NULL, 0, __FENIX_SUBSET_FULL};
 const Fenix_Data_subset  FENIX_DATA_SUBSET_EMPTY = {0, NULL, NULL, NULL, 0, __FENIX_SUBSET_EMPTY};
+const Fenix_Request        FENIX_REQUEST_NULL = {-1, 0};
 
 int Fenix_Callback_register(void (*recover)(MPI_Comm, int, void *), void *callback_data) {
     return __fenix_callback_register(recover, callback_data);
@@ -77,29 +79,84 @@ int Fenix_Finalize() {
     return FENIX_SUCCESS;
 }
 
+//Data calls hold the data lock, shared for stores and lookups and exclusive
+//for everything else, see __fenix_data_lock.
 int Fenix_Data_group_create( int group_id, MPI_Comm comm, int start_time_stamp, int depth, int policy_name, 
         void* policy_value, int* flag) {
-    return __fenix_group_create(group_id, comm, start_time_stamp, depth, policy_name, policy_value, flag);
+    __fenix_data_lock(1);
+    int ret = __fenix_group_create(group_id, comm, start_time_stamp, depth, policy_name, policy_value, flag);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_create( int group_id, int member_id, void *buffer, int count, MPI_Datatype datatype ) {
-    return __fenix_member_create(group_id, member_id, buffer, count, datatype);
+    __fenix_data_lock(1);
+    int ret = __fenix_member_create(group_id, member_id, buffer, count, datatype);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_member_create_c( int group_id, int member_id, void *buffer, MPI_Count count, MPI_Datatype datatype ) {
+    __fenix_data_lock(1);
+    int ret = __fenix_member_create(group_id, member_id, buffer, count, datatype);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_group_get_redundancy_policy( int group_id, int* policy_name, void *policy_value, int *flag ) {
-    return __fenix_group_get_redundancy_policy( group_id, policy_name, policy_value, flag );
+    __fenix_data_lock(0);
+    int ret = __fenix_group_get_redundancy_policy( group_id, policy_name, policy_value, flag );
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_wait(Fenix_Request request) {
-    return __fenix_data_wait(request);
+    __fenix_data_lock(0);
+    int ret = __fenix_data_wait(request);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_test(Fenix_Request request, int *flag) {
-    return __fenix_data_test(request, flag);
+    __fenix_data_lock(0);
+    int ret = __fenix_data_test(request, flag);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_waitall(int count, Fenix_Request *requests) {
+    __fenix_data_lock(0);
+    int ret = __fenix_data_waitall(count, requests);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_testany(int count, Fenix_Request *requests, int *index, int *flag) {
+    __fenix_data_lock(0);
+    int ret = __fenix_data_testany(count, requests, index, flag);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_testsome(int count, Fenix_Request *requests, int *outcount, int *indices) {
+    __fenix_data_lock(0);
+    int ret = __fenix_data_testsome(count, requests, outcount, indices);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_store(int group_id, int member_id, Fenix_Data_subset subset_specifier) {
-    return __fenix_member_store(group_id, member_id, subset_specifier);
+    __fenix_data_lock(0);
+    int ret = __fenix_member_store(group_id, member_id, subset_specifier);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_member_store_swap(int group_id, int member_id, void **buffer) {
+    __fenix_data_lock(0);
+    int ret = __fenix_member_store_swap(group_id, member_id, buffer);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_storev(int group_id, int member_id, Fenix_Data_subset subset_specifier) {
@@ -107,7 +164,10 @@ int Fenix_Data_member_storev(int group_id, int member_id, Fenix_Data_subset subs
 }
 
 int Fenix_Data_member_istore(int group_id, int member_id, Fenix_Data_subset subset_specifier, Fenix_Request *request) {
-    return 0;
+    __fenix_data_lock(0);
+    int ret = __fenix_member_istore(group_id, member_id, subset_specifier, request);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_istorev(int group_id, int member_id, Fenix_Data_subset subset_specifier, Fenix_Request *request) {
@@ -115,19 +175,52 @@ int Fenix_Data_member_istorev(int group_id, int member_id, Fenix_Data_subset sub
 }
 
 int Fenix_Data_commit(int group_id, int *time_stamp) {
-    return __fenix_data_commit(group_id, time_stamp);
+    __fenix_data_lock(1);
+    int ret = __fenix_data_commit(group_id, time_stamp);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_commit_barrier(int group_id, int *time_stamp) {
-    return __fenix_data_commit_barrier(group_id, time_stamp);
+    __fenix_data_lock(1);
+    int ret = __fenix_data_commit_barrier(group_id, time_stamp);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_icommit(int group_id, int *time_stamp, Fenix_Request *request) {
+    __fenix_data_lock(1);
+    int ret = __fenix_data_icommit(group_id, time_stamp, request, 0);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_icommit_barrier(int group_id, int *time_stamp, Fenix_Request *request) {
+    __fenix_data_lock(1);
+    int ret = __fenix_data_icommit(group_id, time_stamp, request, 1);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_barrier(int group_id) {
-    return 0;
+    __fenix_data_lock(1);
+    int ret = __fenix_data_barrier(group_id);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_restore(int group_id, int member_id, void *target_buffer, int max_count, int time_stamp, Fenix_Data_subset* data_found) {
-    return __fenix_member_restore(group_id, member_id, target_buffer, max_count, time_stamp, data_found);
+    __fenix_data_lock(1);
+    int ret = __fenix_member_restore(group_id, member_id, target_buffer, max_count, time_stamp, data_found);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_member_restore_c(int group_id, int member_id, void *target_buffer, MPI_Count max_count, int time_stamp, Fenix_Data_subset* data_found) {
+    __fenix_data_lock(1);
+    int ret = __fenix_member_restore(group_id, member_id, target_buffer, max_count, time_stamp, data_found);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_resore_from_rank(int group_id, int member_id, void *target_buffer, int max_count, int time_stamp, int source_rank) {
@@ -142,6 +235,14 @@ int Fenix_Data_subset_createv(int num_blocks, int *array_start_offsets, int *arr
     return __fenix_data_subset_createv(num_blocks, array_start_offsets, array_end_offsets, subset_specifier);
 }
 
+int Fenix_Data_subset_create_c(MPI_Count num_blocks, MPI_Count start_offset, MPI_Count end_offset, MPI_Count stride, Fenix_Data_subset *subset_specifier) {
+    return __fenix_data_subset_create(num_blocks, start_offset, end_offset, stride, subset_specifier);
+}
+
+int Fenix_Data_subset_createv_c(int num_blocks, MPI_Count *array_start_offsets, MPI_Count *array_end_offsets, Fenix_Data_subset *subset_specifier) {
+    return __fenix_data_subset_createv_c(num_blocks, array_start_offsets, array_end_offsets, subset_specifier);
+}
+
 int Fenix_Data_subset_delete(Fenix_Data_subset *subset_specifier) {
     return __fenix_data_subset_free(subset_specifier);
 }
@@ -155,31 +256,117 @@ int Fenix_Data_group_get_member_at_position(int group_id, int *member_id, int po
 }
 
 int Fenix_Data_group_get_number_of_snapshots(int group_id, int *number_of_snapshots) {
-    return __fenix_get_number_of_snapshots(group_id, number_of_snapshots);
+    __fenix_data_lock(0);
+    int ret = __fenix_get_number_of_snapshots(group_id, number_of_snapshots);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_group_get_snapshot_at_position(int group_id, int position, int *time_stamp) {
-    return __fenix_get_snapshot_at_position(group_id, position, time_stamp);
+    __fenix_data_lock(0);
+    int ret = __fenix_get_snapshot_at_position(group_id, position, time_stamp);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_attr_get(int group_id, int member_id, int attributename, void *attributevalue, int *flag, int source_rank) {
-    return __fenix_member_get_attribute(group_id, member_id, attributename, attributevalue, flag, source_rank);
+    __fenix_data_lock(0);
+    int ret = __fenix_member_get_attribute(group_id, member_id, attributename, attributevalue, flag, source_rank);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_attr_set(int group_id, int member_id, int attribute_name, void *attribute_value, int *flag) {
-    return __fenix_member_set_attribute(group_id, member_id, attribute_name, attribute_value, flag);
+    __fenix_data_lock(1);
+    int ret = __fenix_member_set_attribute(group_id, member_id, attribute_name, attribute_value, flag);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_snapshot_delete(int group_id, int time_stamp) {
-    return __fenix_snapshot_delete(group_id, time_stamp);
+    __fenix_data_lock(1);
+    int ret = __fenix_snapshot_delete(group_id, time_stamp);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_group_delete(int group_id) {
-    return __fenix_group_delete(group_id);
+    __fenix_data_lock(1);
+    int ret = __fenix_group_delete(group_id);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_should_checkpoint(int group_id, int *flag) {
+    __fenix_data_lock(0);
+    int ret = __fenix_group_should_checkpoint(group_id, flag);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_safe_point(int *checkpointed) {
+    __fenix_data_lock(1);
+    int ret = __fenix_data_safe_point(checkpointed);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_set_memory_budget(int group_id, size_t budget) {
+    __fenix_data_lock(1);
+    int ret = __fenix_group_set_memory_budget(group_id, budget);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_get_memory_usage(int group_id, size_t *usage, size_t *high_water) {
+    __fenix_data_lock(0);
+    int ret = __fenix_group_get_memory_usage(group_id, usage, high_water);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_get_reprotect_pending(int group_id, int *num_members) {
+    __fenix_data_lock(0);
+    int ret = __fenix_group_get_reprotect_pending(group_id, num_members);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_set_retention(int group_id, int policy, int keep_last, int interval) {
+    __fenix_data_lock(1);
+    int ret = __fenix_group_set_retention(group_id, policy, keep_last, interval);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_group_scrub(int group_id, int *num_repaired) {
+    __fenix_data_lock(1);
+    int ret = __fenix_group_scrub(group_id, num_repaired);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_member_sdc_region(int group_id, int member_id, int kind,
+                                 Fenix_Data_subset subset_specifier) {
+    __fenix_data_lock(1);
+    int ret = __fenix_member_sdc_region(group_id, member_id, kind, subset_specifier);
+    __fenix_data_unlock();
+    return ret;
+}
+
+int Fenix_Data_sdc_callback_register(void (*detected)(int, int, int, void *),
+                                     void *callback_data) {
+    __fenix_data_lock(1);
+    int ret = __fenix_sdc_callback_register(detected, callback_data);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Data_member_delete(int group_id, int member_id) {
-    return __fenix_member_delete(group_id, member_id);
+    __fenix_data_lock(1);
+    int ret = __fenix_member_delete(group_id, member_id);
+    __fenix_data_unlock();
+    return ret;
 }
 
 int Fenix_Process_fail_list(int** fail_list){
@@ -190,13 +377,12 @@ int Fenix_Process_fail_list(int** fail_list){
 int Fenix_check_cancelled(MPI_Request *request, MPI_Status *status){
    
     //We know this may return as "COMM_REVOKED", but we know the error was already handled
-    int old_ignore_setting = fenix.ignore_errs;
-    fenix.ignore_errs = 1;
+    int old_ignore_setting = __fenix_set_ignore_errs(1);
 
     int flag;
     int ret = PMPI_Test(request, &flag, status);
     
-    fenix.ignore_errs = old_ignore_setting;
+    __fenix_set_ignore_errs(old_ignore_setting);
     
     //Request was (potentially) cancelled if ret is MPI_ERR_PROC_FAILED
     return ret == MPI_ERR_PROC_FAILED || ret == MPI_ERR_REVOKED;
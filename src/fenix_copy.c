@@ -0,0 +1,294 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix_copy.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include <pthread.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define __FENIX_COPY_STREAM_X86 1
+#endif
+
+//Large copies are split into one share per pool thread, the caller taking the
+//first. A buffer is always split the same way, so each part of a snapshot is
+//written by the same thread every time and its pages stay on the NUMA node
+//that first touched them.
+static struct {
+    int size;                 // Threads sharing a copy, the caller included
+    pthread_t *threads;
+    pthread_mutex_t busy;     // Held by the caller of a parallel copy
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finish;
+    unsigned long generation;
+    int remaining;
+    int stopping;
+    void (*body)(int share, int shares, void *arg);
+    void *arg;
+} __fenix_copy_pool = { 1, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+                        PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, NULL, NULL };
+
+#if defined(__FENIX_COPY_STREAM_X86)
+//Non-temporal stores bypass the cache, so snapshot writes do not evict the
+//app's working set. Only the 16 byte aligned middle of dest is streamed.
+static void __fenix_copy_stream(void *dest, const void *src, size_t bytes)
+{
+    uint8_t *out = (uint8_t *) dest;
+    const uint8_t *in = (const uint8_t *) src;
+    size_t head = (16 - ((uintptr_t) out & 15)) & 15;
+    if (head > bytes) head = bytes;
+    memcpy(out, in, head);
+    out += head;
+    in += head;
+    bytes -= head;
+
+    for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *) in);
+        __m128i b = _mm_loadu_si128((const __m128i *) (in + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *) (in + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *) (in + 48));
+        _mm_stream_si128((__m128i *) out, a);
+        _mm_stream_si128((__m128i *) (out + 16), b);
+        _mm_stream_si128((__m128i *) (out + 32), c);
+        _mm_stream_si128((__m128i *) (out + 48), d);
+    }
+    memcpy(out, in, bytes);
+    _mm_sfence();
+}
+#else
+static void __fenix_copy_stream(void *dest, const void *src, size_t bytes)
+{
+    memcpy(dest, src, bytes);
+}
+#endif
+
+static void __fenix_copy_serial(void *dest, const void *src, size_t bytes, int streaming)
+{
+    if (streaming && bytes >= __FENIX_COPY_STREAM_BYTES) {
+        __fenix_copy_stream(dest, src, bytes);
+    } else {
+        memcpy(dest, src, bytes);
+    }
+}
+
+static void *__fenix_copy_worker(void *arg)
+{
+    int share = (int) (intptr_t) arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&__fenix_copy_pool.lock);
+    while (1) {
+        while (!__fenix_copy_pool.stopping && __fenix_copy_pool.generation == seen) {
+            pthread_cond_wait(&__fenix_copy_pool.start, &__fenix_copy_pool.lock);
+        }
+        if (__fenix_copy_pool.stopping) break;
+        seen = __fenix_copy_pool.generation;
+        pthread_mutex_unlock(&__fenix_copy_pool.lock);
+
+        __fenix_copy_pool.body(share, __fenix_copy_pool.size, __fenix_copy_pool.arg);
+
+        pthread_mutex_lock(&__fenix_copy_pool.lock);
+        if (--__fenix_copy_pool.remaining == 0) pthread_cond_signal(&__fenix_copy_pool.finish);
+    }
+    pthread_mutex_unlock(&__fenix_copy_pool.lock);
+    return NULL;
+}
+
+//Runs body once per share, in parallel if the pool is free. Another thread
+//already using the pool just gets its shares run one after another.
+static void __fenix_copy_run(void (*body)(int, int, void *), void *arg)
+{
+    int shares = __fenix_copy_pool.size;
+    if (shares == 1 || pthread_mutex_trylock(&__fenix_copy_pool.busy) != 0) {
+        for (int share = 0; share < shares; share++) body(share, shares, arg);
+        return;
+    }
+
+    pthread_mutex_lock(&__fenix_copy_pool.lock);
+    __fenix_copy_pool.body = body;
+    __fenix_copy_pool.arg = arg;
+    __fenix_copy_pool.remaining = shares - 1;
+    __fenix_copy_pool.generation++;
+    pthread_cond_broadcast(&__fenix_copy_pool.start);
+    pthread_mutex_unlock(&__fenix_copy_pool.lock);
+
+    body(0, shares, arg);
+
+    pthread_mutex_lock(&__fenix_copy_pool.lock);
+    while (__fenix_copy_pool.remaining > 0) {
+        pthread_cond_wait(&__fenix_copy_pool.finish, &__fenix_copy_pool.lock);
+    }
+    pthread_mutex_unlock(&__fenix_copy_pool.lock);
+    pthread_mutex_unlock(&__fenix_copy_pool.busy);
+}
+
+/**
+ * @brief Starts threads-1 helper threads for large copies. One thread, the
+ *        default, keeps every copy on the calling thread.
+ * @param threads
+ */
+void __fenix_copy_init(int threads)
+{
+    if (threads <= 1 || __fenix_copy_pool.size > 1) return;
+
+    __fenix_copy_pool.threads = (pthread_t *) s_malloc(threads * sizeof(pthread_t));
+    __fenix_copy_pool.stopping = 0;
+    __fenix_copy_pool.generation = 0;
+    for (int share = 1; share < threads; share++) {
+        if (pthread_create(__fenix_copy_pool.threads + share, NULL, __fenix_copy_worker,
+                           (void *) (intptr_t) share) != 0) {
+            debug_print("Unable to start Fenix copy thread %d, using %d\n", share, share);
+            threads = share;
+            break;
+        }
+    }
+    __fenix_copy_pool.size = threads;
+}
+
+/**
+ * @brief Stops the helper threads.
+ */
+void __fenix_copy_finalize()
+{
+    if (__fenix_copy_pool.size == 1) return;
+
+    pthread_mutex_lock(&__fenix_copy_pool.lock);
+    __fenix_copy_pool.stopping = 1;
+    pthread_cond_broadcast(&__fenix_copy_pool.start);
+    pthread_mutex_unlock(&__fenix_copy_pool.lock);
+
+    for (int share = 1; share < __fenix_copy_pool.size; share++) {
+        pthread_join(__fenix_copy_pool.threads[share], NULL);
+    }
+    free(__fenix_copy_pool.threads);
+    __fenix_copy_pool.threads = NULL;
+    __fenix_copy_pool.size = 1;
+}
+
+/**
+ * @brief Whether a copy of this many bytes is split across threads.
+ * @param bytes
+ */
+int __fenix_copy_is_parallel(size_t bytes)
+{
+    return __fenix_copy_pool.size > 1 && bytes >= __FENIX_COPY_PARALLEL_BYTES;
+}
+
+typedef struct {
+    fenix_copy_segment_t *segments;
+    int count;
+    size_t total;
+    int streaming;
+} fenix_copy_job_t;
+
+//Each share copies its page aligned slice of the concatenated segments.
+static void __fenix_copy_share(int share, int shares, void *arg)
+{
+    fenix_copy_job_t *job = (fenix_copy_job_t *) arg;
+    size_t first = (job->total / shares * share) & ~(size_t) 4095;
+    size_t last = share == shares - 1 ? job->total
+                                      : (job->total / shares * (share + 1)) & ~(size_t) 4095;
+
+    size_t offset = 0;
+    for (int i = 0; i < job->count && offset < last; i++) {
+        fenix_copy_segment_t *segment = job->segments + i;
+        size_t begin = first > offset ? first - offset : 0;
+        size_t end = last - offset < segment->bytes ? last - offset : segment->bytes;
+        if (begin < end) {
+            __fenix_copy_serial((uint8_t *) segment->dest + begin,
+                                (const uint8_t *) segment->src + begin, end - begin,
+                                job->streaming);
+        }
+        offset += segment->bytes;
+    }
+}
+
+/**
+ * @brief Copies a list of segments, split across the copy threads when large.
+ * @param segments
+ * @param count
+ * @param streaming Set for snapshot writes not read back soon.
+ */
+void __fenix_copy_segments(fenix_copy_segment_t *segments, int count, int streaming)
+{
+    fenix_copy_job_t job = { segments, count, 0, streaming };
+    for (int i = 0; i < count; i++) job.total += segments[i].bytes;
+
+    if (__fenix_copy_is_parallel(job.total)) {
+        __fenix_copy_run(__fenix_copy_share, &job);
+    } else {
+        for (int i = 0; i < count; i++) {
+            __fenix_copy_serial(segments[i].dest, segments[i].src, segments[i].bytes, streaming);
+        }
+    }
+}
+
+/**
+ * @brief memcpy for member data, split across the copy threads when large.
+ * @param dest
+ * @param src
+ * @param bytes
+ * @param streaming Set for snapshot writes not read back soon.
+ */
+void __fenix_copy(void *dest, const void *src, size_t bytes, int streaming)
+{
+    fenix_copy_segment_t segment = { dest, src, bytes };
+    __fenix_copy_segments(&segment, 1, streaming);
+}
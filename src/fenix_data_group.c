@@ -58,6 +58,7 @@
 #include "fenix-config.h"
 #include "fenix_ext.h"
 #include "fenix_data_group.h"
+#include "fenix_data_recovery.h"
 #include "fenix_data_member.h"
 #include "fenix_data_packet.h"
 
@@ -84,6 +85,68 @@ fenix_data_recovery_t * __fenix_data_recovery_init() {
   return data_recovery;
 }
 
+/**
+ * @brief Charges bytes of policy storage to the group.
+ * @param group
+ * @param bytes
+ */
+void __fenix_group_memory_add(fenix_group_t *group, size_t bytes) {
+  pthread_mutex_lock(&(group->stats_lock));
+  group->memory_usage += bytes;
+  if (group->memory_usage > group->memory_high_water) {
+    group->memory_high_water = group->memory_usage;
+  }
+  pthread_mutex_unlock(&(group->stats_lock));
+}
+
+/**
+ * @brief Returns bytes of policy storage from the group.
+ * @param group
+ * @param bytes
+ */
+void __fenix_group_memory_remove(fenix_group_t *group, size_t bytes) {
+  pthread_mutex_lock(&(group->stats_lock));
+  group->memory_usage -= bytes;
+  pthread_mutex_unlock(&(group->stats_lock));
+}
+
+/**
+ * @brief            Picks the snapshot a full group gives up on commit. Only
+ *                   timestamps are used, so every rank picks the same one.
+ * @param group
+ * @param timestamps Timestamps of the snapshots, oldest first. The last one
+ *                   is the snapshot being committed and is never picked.
+ * @param count      Number of timestamps, at least 2.
+ * @return           Index of the snapshot to give up.
+ */
+int __fenix_group_retention_victim(fenix_group_t *group, const int *timestamps, int count) {
+  //Snapshots past last_candidate are among the newest keep_last.
+  int last_candidate = count - 1 - group->retention_keep;
+  int victim = 0;
+
+  if (group->retention_policy == FENIX_DATA_RETENTION_EVERY_NTH) {
+    for (int i = 0; i <= last_candidate; i++) {
+      if (timestamps[i] % group->retention_interval != 0) {
+        victim = i;
+        break;
+      }
+    }
+  } else if (group->retention_policy == FENIX_DATA_RETENTION_EXPONENTIAL && last_candidate >= 1) {
+    //Drop the snapshot whose neighbours are closest together relative to its
+    //age, which keeps spacing roughly proportional to age. Ties go to the older.
+    int now = timestamps[count - 1];
+    double best = 0;
+    for (int i = 1; i <= last_candidate; i++) {
+      double score = (double)(timestamps[i + 1] - timestamps[i - 1]) / (now - timestamps[i]);
+      if (i == 1 || score < best) {
+        best = score;
+        victim = i;
+      }
+    }
+  }
+  return victim;
+}
+
 int __fenix_member_delete(int groupid, int memberid) {
   int retval = -1;
   int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
@@ -98,6 +161,11 @@ int __fenix_member_delete(int groupid, int memberid) {
                   member_index);
   }
 
+  //A member some rank lost needn't be re-protected, even where it's missing.
+  if (group_index != -1) {
+    __fenix_data_reprotect_drop(fenix.data_recovery->group[group_index], memberid);
+  }
+
   if (group_index == -1) {
     debug_print("ERROR Fenix_Data_member_delete: group_id <%d> does not exist\n",
                 groupid);
@@ -109,6 +177,7 @@ int __fenix_member_delete(int groupid, int memberid) {
   } else {
     fenix_data_recovery_t *data_recovery = fenix.data_recovery;
     fenix_group_t *group = (data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
     
     retval = group->vtbl.member_delete(group, memberid);
     
@@ -116,6 +185,7 @@ int __fenix_member_delete(int groupid, int memberid) {
       fenix_member_t *member = group->member;
       member->count--;
       fenix_member_entry_t *mentry = &(member->member_entry[member_index]);
+      __fenix_data_member_release_entry(mentry);
       mentry->state = DELETED;
     }
 
@@ -146,6 +216,11 @@ int __fenix_group_delete_direct(fenix_group_t* group){
     //to the policy, as it may be using that as a reference for
     //knowing how many members there are during its own deletion
     //process.
+    __fenix_progress_abandon(&(group->commit_op));
+    free(group->reprotect_ids);
+    free(group->reprotect_bytes);
+    pthread_mutex_destroy(&(group->stats_lock));
+    pthread_mutex_destroy(&(group->commit_lock));
     
     return group->vtbl.group_delete(group);
 }
@@ -182,6 +257,7 @@ int __fenix_group_delete(int groupid) {
     /* Delete Process */
     fenix_data_recovery_t *data_recovery = fenix.data_recovery;
     fenix_group_t *group = (data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
     retval = __fenix_group_delete_direct(group);
     
     if(retval == FENIX_SUCCESS){ 
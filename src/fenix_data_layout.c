@@ -0,0 +1,262 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "fenix.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include "fenix_data_layout.h"
+
+//Works out where each packed byte of one element comes from by packing a probe
+//buffer whose bytes hold (one byte at a time) their own offset. This gives the
+//flattened type map of any committed datatype without walking its constructors.
+static int __fenix_data_layout_probe(fenix_data_layout_t *layout, MPI_Datatype datatype,
+        MPI_Aint true_lb, MPI_Aint true_extent){
+  int pack_size;
+  MPI_Pack_size(1, datatype, MPI_COMM_SELF, &pack_size);
+
+  unsigned char *probe = (unsigned char *) s_malloc(true_extent);
+  unsigned char *packed = (unsigned char *) s_malloc(pack_size);
+  MPI_Aint *source = (MPI_Aint *) s_calloc(layout->size, sizeof(MPI_Aint));
+  int retval = FENIX_SUCCESS;
+
+  int shift = 0;
+  do {
+    for(MPI_Aint byte = 0; byte < true_extent; byte++){
+      probe[byte] = (unsigned char)(byte >> shift);
+    }
+    int position = 0;
+    MPI_Pack(probe - true_lb, 1, datatype, packed, pack_size, &position, MPI_COMM_SELF);
+    if((size_t)position != layout->size){
+      //Packing is not a plain byte copy, so the type map can't be recovered this way.
+      retval = FENIX_ERROR_INVALID_ATTRIBUTE_NAME;
+      break;
+    }
+    for(size_t byte = 0; byte < layout->size; byte++){
+      source[byte] |= (MPI_Aint)packed[byte] << shift;
+    }
+    shift += 8;
+  } while(shift < 8*(int)sizeof(MPI_Aint) && ((true_extent - 1) >> shift) != 0);
+
+  if(retval == FENIX_SUCCESS){
+    layout->num_spans = 1;
+    for(size_t byte = 1; byte < layout->size; byte++){
+      if(source[byte] != source[byte-1] + 1) layout->num_spans++;
+    }
+
+    layout->spans = (fenix_data_span_t *) s_malloc(layout->num_spans * sizeof(fenix_data_span_t));
+    int span = 0;
+    layout->spans[0].displacement = true_lb + source[0];
+    layout->spans[0].length = 1;
+    for(size_t byte = 1; byte < layout->size; byte++){
+      if(source[byte] != source[byte-1] + 1){
+        span++;
+        layout->spans[span].displacement = true_lb + source[byte];
+        layout->spans[span].length = 0;
+      }
+      layout->spans[span].length++;
+    }
+  }
+
+  free(source);
+  free(packed);
+  free(probe);
+  return retval;
+}
+
+/**
+ * @brief Flattens datatype into a list of contiguous spans per element.
+ * @param layout
+ * @param datatype
+ */
+int __fenix_data_layout_init(fenix_data_layout_t *layout, MPI_Datatype datatype){
+  int size;
+  MPI_Aint lb, extent, true_lb, true_extent;
+  MPI_Type_size(datatype, &size);
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  MPI_Type_get_true_extent(datatype, &true_lb, &true_extent);
+
+  layout->size = size;
+  layout->extent = extent;
+  layout->spans = NULL;
+  layout->num_spans = 0;
+  layout->contiguous = 1;
+
+  int retval = FENIX_SUCCESS;
+  if(size == 0){
+    //Nothing to copy.
+  } else if(true_lb == 0 && true_extent == size && extent == size){
+    layout->num_spans = 1;
+    layout->spans = (fenix_data_span_t *) s_malloc(sizeof(fenix_data_span_t));
+    layout->spans[0].displacement = 0;
+    layout->spans[0].length = size;
+  } else {
+    retval = __fenix_data_layout_probe(layout, datatype, true_lb, true_extent);
+    if(retval == FENIX_SUCCESS){
+      layout->contiguous = layout->num_spans == 1 && layout->spans[0].displacement == 0
+          && extent == size;
+    } else {
+      debug_print("ERROR Fenix_Data_member: unable to flatten datatype, treating it as %d contiguous bytes\n",
+                  size);
+      layout->extent = size;
+    }
+  }
+
+  return retval;
+}
+
+/**
+ * @brief Builds a layout from spans received from another rank.
+ * @param layout
+ * @param num_spans
+ * @param spans
+ * @param extent
+ */
+int __fenix_data_layout_init_from_spans(fenix_data_layout_t *layout, int num_spans,
+        fenix_data_span_t *spans, MPI_Aint extent){
+  layout->num_spans = num_spans;
+  layout->extent = extent;
+  layout->size = 0;
+  layout->spans = (fenix_data_span_t *) s_malloc(num_spans * sizeof(fenix_data_span_t));
+  memcpy(layout->spans, spans, num_spans * sizeof(fenix_data_span_t));
+  for(int span = 0; span < num_spans; span++){
+    layout->size += spans[span].length;
+  }
+  layout->contiguous = num_spans <= 1 && (num_spans == 0 || spans[0].displacement == 0)
+      && extent == (MPI_Aint)layout->size;
+  return FENIX_SUCCESS;
+}
+
+/**
+ * @brief Makes an equivalent committed datatype of MPI_BYTE spans, owned by the caller.
+ * @param layout
+ * @param datatype
+ */
+int __fenix_data_layout_build_datatype(fenix_data_layout_t *layout, MPI_Datatype *datatype){
+  int *lengths = (int *) s_malloc((layout->num_spans + 1) * sizeof(int));
+  MPI_Aint *displacements = (MPI_Aint *) s_malloc((layout->num_spans + 1) * sizeof(MPI_Aint));
+  for(int span = 0; span < layout->num_spans; span++){
+    lengths[span] = (int) layout->spans[span].length;
+    displacements[span] = layout->spans[span].displacement;
+  }
+
+  MPI_Datatype spans_type;
+  MPI_Type_create_hindexed(layout->num_spans, lengths, displacements, MPI_BYTE, &spans_type);
+  MPI_Type_create_resized(spans_type, 0, layout->extent, datatype);
+  MPI_Type_commit(datatype);
+  MPI_Type_free(&spans_type);
+
+  free(displacements);
+  free(lengths);
+  return FENIX_SUCCESS;
+}
+
+void __fenix_data_layout_free(fenix_data_layout_t *layout){
+  free(layout->spans);
+  layout->spans = NULL;
+  layout->num_spans = 0;
+}
+
+/**
+ * @brief Copies elements [first, first+count) of a user buffer into packed dest.
+ * @param layout
+ * @param dest
+ * @param src
+ * @param first
+ * @param count
+ */
+void __fenix_data_layout_pack(fenix_data_layout_t *layout, void *dest, const void *src,
+        size_t first, size_t count){
+  if(layout->contiguous){
+    memcpy(dest, (const uint8_t *)src + first*layout->size, count*layout->size);
+    return;
+  }
+
+  uint8_t *out = (uint8_t *) dest;
+  const uint8_t *element = (const uint8_t *)src + first*layout->extent;
+  for(size_t i = 0; i < count; i++, element += layout->extent){
+    for(int span = 0; span < layout->num_spans; span++){
+      memcpy(out, element + layout->spans[span].displacement, layout->spans[span].length);
+      out += layout->spans[span].length;
+    }
+  }
+}
+
+/**
+ * @brief Copies count packed elements from src into elements [first, first+count) of a user buffer.
+ * @param layout
+ * @param dest
+ * @param src
+ * @param first
+ * @param count
+ */
+void __fenix_data_layout_unpack(fenix_data_layout_t *layout, void *dest, const void *src,
+        size_t first, size_t count){
+  if(layout->contiguous){
+    memcpy((uint8_t *)dest + first*layout->size, src, count*layout->size);
+    return;
+  }
+
+  const uint8_t *in = (const uint8_t *) src;
+  uint8_t *element = (uint8_t *)dest + first*layout->extent;
+  for(size_t i = 0; i < count; i++, element += layout->extent){
+    for(int span = 0; span < layout->num_spans; span++){
+      memcpy(element + layout->spans[span].displacement, in, layout->spans[span].length);
+      in += layout->spans[span].length;
+    }
+  }
+}
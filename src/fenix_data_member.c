@@ -96,6 +96,12 @@ fenix_member_t *__fenix_data_member_init() {
 }
 
 void __fenix_data_member_destroy( fenix_member_t *member ) {
+  for (size_t member_index = 0; member_index < member->total_size; member_index++) {
+    fenix_member_entry_t *mentry = &(member->member_entry[member_index]);
+    if (mentry->state != EMPTY && mentry->state != DELETED) {
+      __fenix_data_member_release_entry(mentry);
+    }
+  }
   free( member->member_entry );
   free( member );
 }
@@ -141,7 +147,7 @@ int __fenix_find_next_member_position(fenix_member_t *member) {
 }
 
 fenix_member_entry_t* __fenix_data_member_add_entry(fenix_member_t* member, 
-        int memberid, void* data, int count, MPI_Datatype datatype){
+        int memberid, void* data, size_t count, MPI_Datatype datatype){
     
     int member_index = __fenix_find_next_member_position(member);
     fenix_member_entry_t* mentry = member->member_entry + member_index;
@@ -150,17 +156,81 @@ fenix_member_entry_t* __fenix_data_member_add_entry(fenix_member_t* member,
     mentry->state = OCCUPIED;
     mentry->user_data = data;
     mentry->current_count = count;
-    mentry->current_datatype = datatype;
-    
-    int dsize;
-    MPI_Type_size(datatype, &dsize);
-    mentry->datatype_size = dsize;
+    mentry->owns_datatype = 0;
+    mentry->current_datatype = MPI_DATATYPE_NULL;
+    __fenix_data_member_set_datatype(mentry, datatype);
+
+    __fenix_data_subset_init(1, &(mentry->sdc_replicated));
+    mentry->sdc_replicated.specifier = __FENIX_SUBSET_EMPTY;
+    __fenix_data_subset_init(1, &(mentry->sdc_immutable));
+    mentry->sdc_immutable.specifier = __FENIX_SUBSET_EMPTY;
+    mentry->sdc_has_reference = 0;
+    mentry->dirty = NULL;
+
+    mentry->lock = (pthread_mutex_t*) s_malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mentry->lock, NULL);
 
     member->count++;
 
     return mentry;
 }
 
+/**
+ * @brief Sets the member's datatype and caches its flattened layout.
+ * @param mentry
+ * @param datatype
+ */
+int __fenix_data_member_set_datatype(fenix_member_entry_t* mentry, MPI_Datatype datatype){
+    int dsize;
+    int retval = MPI_Type_size(datatype, &dsize);
+    if(retval != MPI_SUCCESS) return retval;
+
+    if(mentry->current_datatype != MPI_DATATYPE_NULL){
+        __fenix_data_member_free_entry(mentry);
+    }
+    mentry->current_datatype = datatype;
+    mentry->datatype_size = dsize;
+    __fenix_data_layout_init(&(mentry->layout), datatype);
+
+    return MPI_SUCCESS;
+}
+
+/**
+ * @brief Releases what the entry owns, leaving its metadata in place.
+ * @param mentry
+ */
+void __fenix_data_member_free_entry(fenix_member_entry_t* mentry){
+    __fenix_data_layout_free(&(mentry->layout));
+    if(mentry->owns_datatype){
+        MPI_Type_free(&(mentry->current_datatype));
+        mentry->owns_datatype = 0;
+    }
+    mentry->current_datatype = MPI_DATATYPE_NULL;
+}
+
+/**
+ * @brief Releases everything the entry owns, once its member is deleted.
+ * @param mentry
+ */
+void __fenix_data_member_release_entry(fenix_member_entry_t* mentry){
+    __fenix_data_member_free_entry(mentry);
+    __fenix_data_member_clear_sdc(mentry);
+    __fenix_dirty_release(&(mentry->dirty));
+    pthread_mutex_destroy(mentry->lock);
+    free(mentry->lock);
+    mentry->lock = NULL;
+}
+
+/**
+ * @brief Releases the entry's silent data corruption regions.
+ * @param mentry
+ */
+void __fenix_data_member_clear_sdc(fenix_member_entry_t* mentry){
+    __fenix_data_subset_free(&(mentry->sdc_replicated));
+    __fenix_data_subset_free(&(mentry->sdc_immutable));
+    mentry->sdc_has_reference = 0;
+}
+
 /**
  * @brief
  * @param
@@ -225,9 +295,21 @@ int __fenix_data_member_send_metadata(int groupid, int memberid, int dest_rank){
         packet.current_datatype = mentry.current_datatype;
         packet.datatype_size = mentry.datatype_size;
         packet.current_count = mentry.current_count;
+        packet.num_spans = mentry.layout.num_spans;
+        packet.extent = mentry.layout.extent;
+        packet.rebuilt_datatype = 0;
+
+        int num_integers, num_addresses, num_datatypes, combiner;
+        MPI_Type_get_envelope(mentry.current_datatype, &num_integers, &num_addresses,
+                &num_datatypes, &combiner);
+        packet.named_datatype = combiner == MPI_COMBINER_NAMED;
 
         MPI_Send(&packet, sizeof(packet), MPI_BYTE, dest_rank, RECOVER_MEMBER_ENTRY_TAG^groupid,
                 group->comm);
+        if(!packet.named_datatype){
+            MPI_Send(mentry.layout.spans, packet.num_spans*sizeof(fenix_data_span_t), MPI_BYTE,
+                    dest_rank, RECOVER_MEMBER_ENTRY_TAG^groupid, group->comm);
+        }
 
         retval = FENIX_SUCCESS;
     }
@@ -252,6 +334,22 @@ int __fenix_data_member_recv_metadata(int groupid, int src_rank,
         MPI_Recv((void*)packet, sizeof(fenix_member_entry_packet_t), MPI_BYTE, src_rank, 
                 RECOVER_MEMBER_ENTRY_TAG^groupid, group->comm, NULL);
 
+        if(!packet->named_datatype){
+            //Rebuild an equivalent type; the member that uses it takes ownership.
+            fenix_data_span_t* spans = (fenix_data_span_t*) s_malloc(
+                    packet->num_spans*sizeof(fenix_data_span_t));
+            MPI_Recv(spans, packet->num_spans*sizeof(fenix_data_span_t), MPI_BYTE, src_rank,
+                    RECOVER_MEMBER_ENTRY_TAG^groupid, group->comm, NULL);
+
+            fenix_data_layout_t layout;
+            __fenix_data_layout_init_from_spans(&layout, packet->num_spans, spans, packet->extent);
+            __fenix_data_layout_build_datatype(&layout, &(packet->current_datatype));
+            packet->rebuilt_datatype = 1;
+
+            __fenix_data_layout_free(&layout);
+            free(spans);
+        }
+
         retval = FENIX_SUCCESS;
     }
     
@@ -59,15 +59,51 @@
 #include "fenix_opt.h"
 #include "fenix_data_subset.h"
 #include "fenix_data_recovery.h"
+#include "fenix_data_request.h"
 #include "fenix_data_policy.h"
 #include "fenix_data_group.h"
 #include "fenix_data_member.h"
+#include "fenix_ext.h"
+#include "fenix_progress.h"
+#include "fenix_standby.h"
+#include "fenix_lossy.h"
+#include <math.h>
+#include <sched.h>
+#include <time.h>
 
 #define __FENIX_IMR_DEFAULT_MENTRY_NUM 10
 #define __FENIX_IMR_NO_MEMBERS 16000
 #define __IMR_RECOVER_DATA_REGION_TAG 97854
 
 #define STORE_PAYLOAD_TAG 2004
+#define STORE_FINGERPRINT_TAG 2005
+#define SCRUB_STATUS_TAG 2006
+#define SCRUB_DATA_TAG 2007
+#define SDC_FINGERPRINT_TAG 2008
+#define RMA_CONTROL_TAG 2009
+#define BARRIER_TOKEN_TAG 2010
+#define STANDBY_CHECK_TAG 2012
+#define STORE_LOSSY_SIZE_TAG 2013
+
+//Control block each rank exposes next to its head snapshot for one-sided
+//stores: where the partner slot is, the timestamp it belongs to, how many
+//stores the partner has put into it, and whether one is under way.
+#define __IMR_RMA_SLOT 0
+#define __IMR_RMA_TIMESTAMP 1
+#define __IMR_RMA_STORES 2
+#define __IMR_RMA_BUSY 3
+//Spins on a control block yield the core this many times before sleeping,
+//then sleep twice as long each time up to the cap, in nanoseconds.
+#define __IMR_RMA_YIELDS 64
+#define __IMR_RMA_MAX_SLEEP 1000000
+#define __IMR_RMA_CONTROL_SIZE 4
+
+//Each snapshot buffer holds its data followed by a CRC32C for every
+//__IMR_CHECKSUM_BLOCK bytes of that data.
+#define __IMR_CHECKSUM_BLOCK 4096
+
+//Both RAID-1 flavors share partners and the store exchange.
+#define __imr_is_raid1(mode) ((mode) == 1 || (mode) == FENIX_DATA_POLICY_IMR_PARTNER_ONLY)
 
 int __imr_group_delete(fenix_group_t* group);
 int __imr_member_create(fenix_group_t* group, fenix_member_entry_t* mentry);
@@ -76,8 +112,11 @@ int __imr_get_redundant_policy(fenix_group_t*, int* policy_name,
         void* policy_value, int* flag);
 int __imr_member_store(fenix_group_t* group, int member_id, 
         Fenix_Data_subset subset_specifier);
+int __imr_member_store_subset(fenix_group_t* group, int member_id,
+        Fenix_Data_subset subset_specifier);
 int __imr_member_storev(fenix_group_t* group, int member_id, 
         Fenix_Data_subset subset_specifier);
+int __imr_member_store_swap(fenix_group_t* group, int member_id, void** buffer);
 int __imr_member_istore(fenix_group_t* group, int member_id, 
         Fenix_Data_subset subset_specifier, Fenix_Request *request);
 int __imr_member_istorev(fenix_group_t* group, int member_id, 
@@ -86,7 +125,7 @@ int __imr_commit(fenix_group_t* group);
 int __imr_snapshot_delete(fenix_group_t* group, int time_stamp);
 int __imr_barrier(fenix_group_t* group);
 int __imr_member_restore(fenix_group_t* group, int member_id,
-        void* target_buffer, int max_count, int time_stamp,
+        void* target_buffer, size_t max_count, int time_stamp,
         Fenix_Data_subset* data_found);
 int __imr_member_restore_from_rank(fenix_group_t* group, int member_id,
         void* target_buffer, int max_count, int time_stamp, 
@@ -100,13 +139,70 @@ int __imr_get_number_of_snapshots(fenix_group_t* group,
 int __imr_get_snapshot_at_position(fenix_group_t* group, int position,
         int* time_stamp);
 int __imr_reinit(fenix_group_t* group, int* flag);
+int __imr_scrub(fenix_group_t* group, int* num_repaired);
+int __imr_member_reprotect(fenix_group_t* group, int member_id);
+
+//Persistent requests for a member's RAID-1 store exchange, kept while stores
+//have the same shape so that each one only starts and waits on them.
+typedef struct __fenix_imr_exchange{
+   Fenix_Data_subset shape;
+   size_t count;
+   int datatype_size;
+   void* send_buf;
+   void* recv_buf;
+   int num_requests;
+   MPI_Request* requests;
+   //Set while an istore's exchange is left to the progress engine.
+   int in_flight;
+   fenix_progress_op_t op;
+} fenix_imr_exchange_t;
+
+//Persistent RAID-5 parity reductions bound to one snapshot buffer.
+typedef struct __fenix_imr_parity{
+   void* buffer;
+   size_t capacity;
+   size_t count;
+   MPI_Request* requests;
+} fenix_imr_parity_t;
 
 typedef struct __fenix_imr_mentry{
    void** data;
    Fenix_Data_subset* data_regions;
    int* timestamp;
+   //Member count each snapshot was stored with.
+   size_t* counts;
+   //Elements each data buffer has room for, on both the local and partner side.
+   size_t capacity;
+   //Bytes in each snapshot buffer. Unused snapshots have no buffer.
+   size_t buffer_size;
+   //Bytes of data in each buffer, and where its checksums start.
+   size_t data_size;
+   size_t checksum_offset;
    int current_head;
    int memberid;
+   //Elements per block deduplicated against the partner's data, 0 for none.
+   size_t dedup_block;
+   //Error the partner's copy may have, and the __FENIX_LOSSY type coding it.
+   double error_bound;
+   int lossy;
+   //One-sided store transport, MPI_WIN_NULL until the first store opens it.
+   MPI_Win window;
+   MPI_Aint* window_control;
+   MPI_Aint own_control;
+   MPI_Aint partner_control;
+   void* window_exposed;
+   int window_timestamp;
+   int window_stores;
+   fenix_imr_exchange_t exchange;
+   //One per snapshot buffer, used with MPI 4 persistent collectives.
+   fenix_imr_parity_t* parity;
+   //The member's own copies of the group's communicators when threads may
+   //store members concurrently, MPI_COMM_NULL until its first store.
+   MPI_Comm comm;
+   MPI_Comm set_comm;
+   //Snapshot-sized buffer lent to the app by store_swap, NULL until then.
+   void* lent;
+   size_t lent_size;
 } fenix_imr_mentry_t;
 
 typedef struct __fenix_imr_group{
@@ -120,6 +216,10 @@ typedef struct __fenix_imr_group{
    int entries_count;
    fenix_imr_mentry_t* entries;
    int num_snapshots;
+   //Next snapshot position the scrubber checks.
+   int scrub_position;
+   //RAID-1 stores put into the partner's memory instead of a sendrecv.
+   int rma;
 } fenix_imr_group_t;
 
 void __fenix_policy_in_memory_raid_get_group(fenix_group_t** group, MPI_Comm comm, 
@@ -132,6 +232,7 @@ void __fenix_policy_in_memory_raid_get_group(fenix_group_t** group, MPI_Comm com
    new_group->base.vtbl.get_redundant_policy = *__imr_get_redundant_policy;
    new_group->base.vtbl.member_store = *__imr_member_store;
    new_group->base.vtbl.member_storev = *__imr_member_storev;
+   new_group->base.vtbl.member_store_swap = *__imr_member_store_swap;
    new_group->base.vtbl.member_istore = *__imr_member_istore;
    new_group->base.vtbl.member_istorev = *__imr_member_istorev;
    new_group->base.vtbl.commit = *__imr_commit;
@@ -144,6 +245,8 @@ void __fenix_policy_in_memory_raid_get_group(fenix_group_t** group, MPI_Comm com
    new_group->base.vtbl.get_number_of_snapshots = *__imr_get_number_of_snapshots;
    new_group->base.vtbl.get_snapshot_at_position = *__imr_get_snapshot_at_position;
    new_group->base.vtbl.reinit = *__imr_reinit;
+   new_group->base.vtbl.scrub = *__imr_scrub;
+   new_group->base.vtbl.member_reprotect = *__imr_member_reprotect;
 
    int* policy_vals = (int*)policy_value;
    new_group->raid_mode = policy_vals[0];
@@ -153,7 +256,7 @@ void __fenix_policy_in_memory_raid_get_group(fenix_group_t** group, MPI_Comm com
    MPI_Comm_size(comm, &comm_size);
    MPI_Comm_rank(comm, &my_rank);
 
-   if(new_group->raid_mode == 1){
+   if(__imr_is_raid1(new_group->raid_mode)){
       new_group->partners = (int*) malloc(sizeof(int) * 2);
       
       //Set up the person who's data I am storing
@@ -187,6 +290,8 @@ void __fenix_policy_in_memory_raid_get_group(fenix_group_t** group, MPI_Comm com
    new_group->entries = 
       (fenix_imr_mentry_t*) malloc(sizeof(fenix_imr_mentry_t) * __FENIX_IMR_DEFAULT_MENTRY_NUM);
    new_group->num_snapshots = 0;
+   new_group->scrub_position = 0;
+   new_group->rma = fenix.imr_rma && __imr_is_raid1(new_group->raid_mode);
 
 
    *flag = FENIX_SUCCESS;
@@ -228,20 +333,575 @@ int __imr_find_mentry(fenix_imr_group_t* group, int memberid, fenix_imr_mentry_t
    return retval;
 }
 
-void __imr_alloc_data_region(void** region, int raid_mode, int local_data_size, int set_size){
+size_t __imr_data_region_size(int raid_mode, size_t local_data_size, int set_size){
    if(raid_mode == 1){
-      *region = (void*) malloc(2*local_data_size);
+      return 2*local_data_size;
+   } else if(raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY){
+      //Only the partner's data is kept.
+      return local_data_size;
    } else if(raid_mode == 5){
       //We need space for our own local data, as well as space for the parity data
       //We add two just in case the data size isn't evenly divisble by set_size-1
       //  3 is needed because making the parity one larger on some nodes requires 
       //  extra bits of "data" on the other nodes
-      *region = (void*) malloc(local_data_size + local_data_size/(set_size - 1) + 3);
+      return local_data_size + local_data_size/(set_size - 1) + 3;
    } else {
       debug_print("Error: raid mode <%d> not supported\n", raid_mode);
+      return 0;
+   }
+}
+
+size_t __imr_checksum_blocks(fenix_imr_mentry_t* mentry){
+   return (mentry->data_size + __IMR_CHECKSUM_BLOCK - 1)/__IMR_CHECKSUM_BLOCK;
+}
+
+uint32_t* __imr_checksums(fenix_imr_mentry_t* mentry, void* buffer){
+   return (uint32_t*)((char*)buffer + mentry->checksum_offset);
+}
+
+void __imr_set_buffer_layout(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      size_t local_data_size){
+   mentry->data_size = __imr_data_region_size(group->raid_mode, local_data_size, group->set_size);
+   mentry->checksum_offset = (mentry->data_size + sizeof(uint32_t) - 1)/sizeof(uint32_t)*sizeof(uint32_t);
+   mentry->buffer_size = mentry->checksum_offset + __imr_checksum_blocks(mentry)*sizeof(uint32_t);
+}
+
+uint32_t __imr_block_checksum(fenix_imr_mentry_t* mentry, void* buffer, size_t block){
+   size_t start = block*__IMR_CHECKSUM_BLOCK;
+   size_t length = mentry->data_size - start;
+   if(length > __IMR_CHECKSUM_BLOCK) length = __IMR_CHECKSUM_BLOCK;
+   return __fenix_crc32c(0, (char*)buffer + start, length);
+}
+
+//Marks the checksum blocks overlapping bytes [start, end) of a buffer.
+void __imr_mark_bytes(fenix_imr_mentry_t* mentry, char* marks, size_t start, size_t end){
+   if(end > mentry->data_size) end = mentry->data_size;
+   if(start >= end) return;
+   size_t first = start/__IMR_CHECKSUM_BLOCK, last = (end - 1)/__IMR_CHECKSUM_BLOCK;
+   memset(marks + first, 1, last - first + 1);
+}
+
+//Marks the blocks holding a region's elements within the part of a buffer
+//which starts at offset.
+void __imr_mark_region(fenix_imr_mentry_t* mentry, char* marks, Fenix_Data_subset* region,
+      size_t offset, int datatype_size){
+   if(region->specifier == __FENIX_SUBSET_FULL){
+      __imr_mark_bytes(mentry, marks, offset, offset + mentry->capacity*datatype_size);
+   } else if(region->specifier != __FENIX_SUBSET_EMPTY){
+      for(int i = 0; i < region->num_blocks; i++){
+         for(MPI_Count j = 0; j <= region->num_repeats[i]; j++){
+            MPI_Count start = region->start_offsets[i] + j*region->stride;
+            MPI_Count end = region->end_offsets[i] + j*region->stride + 1;
+            __imr_mark_bytes(mentry, marks, offset + start*datatype_size,
+                  offset + end*datatype_size);
+         }
+      }
+   }
+}
+
+//Recomputes the checksums of the marked blocks, or of every block without marks.
+void __imr_checksum_marked(fenix_imr_mentry_t* mentry, void* buffer, char* marks){
+   uint32_t* checksums = __imr_checksums(mentry, buffer);
+   size_t num_blocks = __imr_checksum_blocks(mentry);
+   for(size_t block = 0; block < num_blocks; block++){
+      if(marks == NULL || marks[block]){
+         checksums[block] = __imr_block_checksum(mentry, buffer, block);
+      }
+   }
+}
+
+//Number of marked blocks, or of all blocks without marks, whose data no
+//longer matches its checksum.
+size_t __imr_verify_marked(fenix_imr_mentry_t* mentry, void* buffer, char* marks){
+   uint32_t* checksums = __imr_checksums(mentry, buffer);
+   size_t num_blocks = __imr_checksum_blocks(mentry), bad = 0;
+   for(size_t block = 0; block < num_blocks; block++){
+      if((marks == NULL || marks[block]) &&
+            checksums[block] != __imr_block_checksum(mentry, buffer, block)){
+         bad++;
+      }
+   }
+   return bad;
+}
+
+char* __imr_new_marks(fenix_imr_mentry_t* mentry){
+   return (char*) calloc(__imr_checksum_blocks(mentry) + 1, 1);
+}
+
+//Refreshes the checksums after a store of region has written a buffer: our
+//data and the partner's copy for RAID-1, our data and all parity for RAID-5.
+//Only the blocks just written are summed, while they are still in cache.
+void __imr_checksum_stored(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, void* buffer,
+      Fenix_Data_subset* region, int datatype_size){
+   char* marks = __imr_new_marks(mentry);
+   __imr_mark_region(mentry, marks, region, 0, datatype_size);
+   if(group->raid_mode == 1){
+      __imr_mark_region(mentry, marks, region, mentry->capacity*datatype_size, datatype_size);
+   } else if(group->raid_mode == 5){
+      __imr_mark_bytes(mentry, marks, mentry->capacity*datatype_size, mentry->data_size);
+   }
+   __imr_checksum_marked(mentry, buffer, marks);
+   free(marks);
+}
+
+//Checks the blocks holding our own data for a region, returns the number of bad blocks.
+size_t __imr_verify_region(fenix_imr_mentry_t* mentry, void* buffer, Fenix_Data_subset* region,
+      int datatype_size){
+   char* marks = __imr_new_marks(mentry);
+   __imr_mark_region(mentry, marks, region, 0, datatype_size);
+   size_t bad = __imr_verify_marked(mentry, buffer, marks);
+   free(marks);
+   return bad;
+}
+
+size_t __imr_verify_bytes(fenix_imr_mentry_t* mentry, void* buffer, size_t start, size_t end){
+   char* marks = __imr_new_marks(mentry);
+   __imr_mark_bytes(mentry, marks, start, end);
+   size_t bad = __imr_verify_marked(mentry, buffer, marks);
+   free(marks);
+   return bad;
+}
+
+//Communicator a member's stores run on. Threads storing different members at
+//once would match each other's messages on the group's communicators, so with
+//MPI_THREAD_MULTIPLE each member gets its own. They are made on the member's
+//first store with the member id as tag, which keeps concurrent creations apart.
+MPI_Comm __imr_member_comm(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int set){
+   if(!fenix.thread_multiple) return set ? group->set_comm : group->base.comm;
+
+   if(mentry->comm == MPI_COMM_NULL){
+      //MPI_TAG_UB is only guaranteed on MPI_COMM_WORLD, and is at least 32767.
+      int* tag_ub;
+      int flag;
+      MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &tag_ub, &flag);
+      unsigned int tags = flag ? (unsigned int) *tag_ub : 32767;
+      int tag = (int)((unsigned int) mentry->memberid % tags);
+
+      MPI_Errhandler errhandler;
+      MPI_Comm_get_errhandler(group->base.comm, &errhandler);
+
+      MPI_Group comm_group;
+      MPI_Comm_group(group->base.comm, &comm_group);
+      MPI_Comm_create_group(group->base.comm, comm_group, tag, &(mentry->comm));
+      MPI_Comm_set_errhandler(mentry->comm, errhandler);
+      MPI_Group_free(&comm_group);
+
+      if(group->raid_mode == 5){
+         MPI_Comm_group(group->set_comm, &comm_group);
+         MPI_Comm_create_group(group->set_comm, comm_group, tag, &(mentry->set_comm));
+         MPI_Comm_set_errhandler(mentry->set_comm, errhandler);
+         MPI_Group_free(&comm_group);
+      }
+      MPI_Errhandler_free(&errhandler);
+   }
+   return set ? mentry->set_comm : mentry->comm;
+}
+
+//Collective, like deleting the member or group the communicators belong to.
+void __imr_member_comm_free(fenix_imr_mentry_t* mentry){
+   if(mentry->comm != MPI_COMM_NULL) MPI_Comm_free(&(mentry->comm));
+   if(mentry->set_comm != MPI_COMM_NULL) MPI_Comm_free(&(mentry->set_comm));
+}
+
+//Stops exposing our head buffer, before it is freed or moved.
+void __imr_rma_unexpose(fenix_imr_mentry_t* mentry){
+   if(mentry->window_exposed != NULL){
+      MPI_Win_detach(mentry->window, mentry->window_exposed);
+      mentry->window_exposed = NULL;
+   }
+}
+
+//Control block fields are only touched through atomics, so neither side ever
+//needs an exclusive lock the other could starve.
+MPI_Aint __imr_rma_read(fenix_imr_mentry_t* mentry, int rank, MPI_Aint control, int field){
+   //A read that fails, e.g. from a dead partner, leaves -1: never a valid
+   //timestamp, busy count or store count, so the spin goes on to the backoff.
+   MPI_Aint value = -1, unused = 0;
+   MPI_Fetch_and_op(&unused, &value, MPI_AINT, rank,
+         MPI_Aint_add(control, field*sizeof(MPI_Aint)), MPI_NO_OP, mentry->window);
+   MPI_Win_flush(rank, mentry->window);
+   return value;
+}
+
+void __imr_rma_update(fenix_imr_mentry_t* mentry, int rank, MPI_Aint control, int field,
+      MPI_Aint value, MPI_Op op){
+   MPI_Accumulate(&value, 1, MPI_AINT, rank, MPI_Aint_add(control, field*sizeof(MPI_Aint)),
+         1, MPI_AINT, op, mentry->window);
+   MPI_Win_flush(rank, mentry->window);
+}
+
+//Called between reads of a control block that is still not what we wait for.
+//Only the partner can change it, and on an oversubscribed node it may need our
+//core to do so, or with a software RMA component need us in MPI to progress
+//its updates. So the probe drives progress and raises the partner's failure or
+//a revocation through the communicator's handler, then we yield and sleep
+//longer the longer it takes. Anything but MPI_SUCCESS means stop waiting.
+int __imr_rma_backoff(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int partner,
+      int* spins){
+   int flag;
+   int ret = MPI_Iprobe(partner, MPI_ANY_TAG, __imr_member_comm(group, mentry, 0), &flag,
+         MPI_STATUS_IGNORE);
+   if(ret != MPI_SUCCESS) return ret;
+
+   if(*spins < __IMR_RMA_YIELDS){
+      sched_yield();
+   } else {
+      int shift = *spins - __IMR_RMA_YIELDS;
+      long nanoseconds = __IMR_RMA_MAX_SLEEP;
+      if(shift < 10) nanoseconds = 1000L << shift;
+      struct timespec pause = { .tv_sec = 0, .tv_nsec = nanoseconds };
+      nanosleep(&pause, NULL);
+   }
+   (*spins)++;
+   return MPI_SUCCESS;
+}
+
+//Keeps the partner whose data we keep out of our head buffer while buffers
+//move: no new store starts, and the ones under way are waited for.
+int __imr_rma_hold(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   if(mentry->window == MPI_WIN_NULL) return MPI_SUCCESS;
+
+   int me = group->base.current_rank;
+   int ret = MPI_SUCCESS, spins = 0;
+   __imr_rma_update(mentry, me, mentry->own_control, __IMR_RMA_TIMESTAMP, -1, MPI_REPLACE);
+   while(ret == MPI_SUCCESS &&
+         __imr_rma_read(mentry, me, mentry->own_control, __IMR_RMA_BUSY) != 0){
+      ret = __imr_rma_backoff(group, mentry, group->partners[0], &spins);
+   }
+   return ret;
+}
+
+//Lets the partner back in, telling it where its stores for our head snapshot
+//now go. The slot is written before the timestamp that makes it valid, and the
+//store count starts over whenever the head moves to a new timestamp.
+void __imr_rma_release(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   if(mentry->window == MPI_WIN_NULL) return;
+
+   int me = group->base.current_rank;
+   void* head = mentry->data[mentry->current_head];
+   size_t slot_offset = group->raid_mode == 1 ? mentry->data_size/2 : 0;
+   if(head != mentry->window_exposed){
+      __imr_rma_unexpose(mentry);
+      MPI_Win_attach(mentry->window, head, mentry->data_size);
+      mentry->window_exposed = head;
+   }
+
+   MPI_Aint slot;
+   MPI_Get_address((char*)head + slot_offset, &slot);
+   __imr_rma_update(mentry, me, mentry->own_control, __IMR_RMA_SLOT, slot, MPI_REPLACE);
+   int timestamp = mentry->timestamp[mentry->current_head];
+   if(timestamp != mentry->window_timestamp){
+      __imr_rma_update(mentry, me, mentry->own_control, __IMR_RMA_STORES, 0, MPI_REPLACE);
+      mentry->window_timestamp = timestamp;
+   }
+   __imr_rma_update(mentry, me, mentry->own_control, __IMR_RMA_TIMESTAMP, timestamp,
+         MPI_REPLACE);
+}
+
+//Creates the member's window on its first one-sided store. Every rank stores
+//the same members in the same order, which makes this collective over the group.
+void __imr_rma_open(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   if(mentry->window != MPI_WIN_NULL) return;
+
+   MPI_Comm comm = __imr_member_comm(group, mentry, 0);
+   MPI_Win_create_dynamic(MPI_INFO_NULL, comm, &(mentry->window));
+   //Failures are picked up on the member's communicator between spins, rather
+   //than aborting from inside an atomic.
+   MPI_Win_set_errhandler(mentry->window, MPI_ERRORS_RETURN);
+   mentry->window_control = (MPI_Aint*) s_calloc(__IMR_RMA_CONTROL_SIZE, sizeof(MPI_Aint));
+   mentry->window_control[__IMR_RMA_TIMESTAMP] = -1;
+   MPI_Win_attach(mentry->window, mentry->window_control,
+         __IMR_RMA_CONTROL_SIZE*sizeof(MPI_Aint));
+   MPI_Get_address(mentry->window_control, &(mentry->own_control));
+   mentry->window_exposed = NULL;
+   mentry->window_timestamp = -1;
+   mentry->window_stores = 0;
+   MPI_Win_lock_all(0, mentry->window);
+   __imr_rma_release(group, mentry);
+
+   //Published before the address is handed out, so the partner never reads a stale block.
+   MPI_Sendrecv(&(mentry->own_control), 1, MPI_AINT, group->partners[0],
+         group->base.groupid ^ RMA_CONTROL_TAG, &(mentry->partner_control), 1, MPI_AINT,
+         group->partners[1], group->base.groupid ^ RMA_CONTROL_TAG, comm, MPI_STATUS_IGNORE);
+}
+
+//Collective, like deleting the member or group the window belongs to.
+void __imr_rma_close(fenix_imr_mentry_t* mentry){
+   if(mentry->window == MPI_WIN_NULL) return;
+
+   MPI_Win_unlock_all(mentry->window);
+   __imr_rma_unexpose(mentry);
+   MPI_Win_detach(mentry->window, mentry->window_control);
+   MPI_Win_free(&(mentry->window));
+   free(mentry->window_control);
+}
+
+//Puts a serialized store straight into the head snapshot of the partner who
+//keeps our data. Only waits if that partner has not yet committed the snapshot
+//before ours, never for it to reach its own store.
+int __imr_rma_store(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      Fenix_Data_subset* subset, void* serialized, int datatype_size, size_t count){
+   __imr_rma_open(group, mentry);
+
+   int keeper = group->partners[1];
+   MPI_Aint control = mentry->partner_control;
+   MPI_Aint timestamp = mentry->timestamp[mentry->current_head];
+   int spins = 0;
+   while(1){
+      __imr_rma_update(mentry, keeper, control, __IMR_RMA_BUSY, 1, MPI_SUM);
+      if(__imr_rma_read(mentry, keeper, control, __IMR_RMA_TIMESTAMP) == timestamp) break;
+      __imr_rma_update(mentry, keeper, control, __IMR_RMA_BUSY, -1, MPI_SUM);
+
+      int ret = __imr_rma_backoff(group, mentry, keeper, &spins);
+      if(ret != MPI_SUCCESS) return ret;
+   }
+
+   MPI_Aint slot = __imr_rma_read(mentry, keeper, control, __IMR_RMA_SLOT);
+   __fenix_data_subset_put(subset, serialized, datatype_size, count, keeper, slot,
+         mentry->window);
+   MPI_Win_flush(keeper, mentry->window);
+   __imr_rma_update(mentry, keeper, control, __IMR_RMA_STORES, 1, MPI_SUM);
+   __imr_rma_update(mentry, keeper, control, __IMR_RMA_BUSY, -1, MPI_SUM);
+
+   mentry->window_stores++;
+   return MPI_SUCCESS;
+}
+
+//Before committing, waits for the partner whose data we keep to put as many
+//stores into our head snapshot as we made, then sums the whole snapshot since
+//the partner's part was not there when we stored ours.
+int __imr_rma_wait(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   if(mentry->window == MPI_WIN_NULL || mentry->window_stores == 0) return MPI_SUCCESS;
+
+   int me = group->base.current_rank;
+   int spins = 0;
+   while(__imr_rma_read(mentry, me, mentry->own_control, __IMR_RMA_STORES) <
+         mentry->window_stores){
+      int ret = __imr_rma_backoff(group, mentry, group->partners[0], &spins);
+      if(ret != MPI_SUCCESS) return ret;
+   }
+   MPI_Win_sync(mentry->window);
+
+   int member_index = __fenix_search_memberid(group->base.member, mentry->memberid);
+   __imr_checksum_stored(group, mentry, mentry->data[mentry->current_head],
+         mentry->data_regions + mentry->current_head,
+         group->base.member->member_entry[member_index].datatype_size);
+   mentry->window_stores = 0;
+   return MPI_SUCCESS;
+}
+
+//Drops the member's cached exchange. Requests on a communicator being repaired
+//are abandoned rather than released.
+void __imr_exchange_free(fenix_imr_exchange_t* exchange, int release){
+   __fenix_progress_abandon(&(exchange->op));
+   exchange->in_flight = 0;
+   if(exchange->num_requests == 0) return;
+
+   for(int i = 0; i < exchange->num_requests && release; i++){
+      MPI_Request_free(exchange->requests + i);
+   }
+   free(exchange->requests);
+   free(exchange->send_buf);
+   free(exchange->recv_buf);
+   __fenix_data_subset_free(&(exchange->shape));
+   exchange->num_requests = 0;
+}
+
+//Returns the member's exchange for a store of subset, remade if the subset,
+//count or datatype differ from the last store's.
+fenix_imr_exchange_t* __imr_exchange_prepare(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      Fenix_Data_subset* subset, fenix_member_entry_t* member_data){
+   fenix_imr_exchange_t* exchange = &(mentry->exchange);
+   if(exchange->num_requests > 0 && exchange->count == member_data->current_count &&
+         exchange->datatype_size == member_data->datatype_size &&
+         __fenix_data_subset_equal(&(exchange->shape), subset)){
+      return exchange;
+   }
+
+   __imr_exchange_free(exchange, 1);
+   size_t bytes = __fenix_data_subset_data_size(subset, member_data->current_count) *
+         member_data->datatype_size;
+   exchange->send_buf = s_malloc(bytes > 0 ? bytes : 1);
+   exchange->recv_buf = s_malloc(bytes > 0 ? bytes : 1);
+   exchange->requests = (MPI_Request*) s_malloc(
+         __fenix_mpi_sendrecv_init_count(bytes, bytes) * sizeof(MPI_Request));
+   exchange->num_requests = __fenix_mpi_sendrecv_init_bytes(exchange->send_buf, bytes,
+         group->partners[1], group->base.groupid ^ STORE_PAYLOAD_TAG, exchange->recv_buf, bytes,
+         group->partners[0], group->base.groupid ^ STORE_PAYLOAD_TAG,
+         __imr_member_comm(group, mentry, 0), exchange->requests);
+   __fenix_data_subset_deep_copy(subset, &(exchange->shape));
+   exchange->count = member_data->current_count;
+   exchange->datatype_size = member_data->datatype_size;
+   return exchange;
+}
+
+//Packs a RAID-1 store of subset and starts trading it with the partners.
+fenix_imr_exchange_t* __imr_exchange_start(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      Fenix_Data_subset* subset, fenix_member_entry_t* member_data, void* own_data){
+   fenix_imr_exchange_t* exchange = __imr_exchange_prepare(group, mentry, subset, member_data);
+   if(group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY){
+      __fenix_data_subset_serialize_user_into(subset, own_data, exchange->send_buf,
+            &(member_data->layout), member_data->current_count);
+   } else {
+      __fenix_data_subset_serialize_into(subset, own_data, exchange->send_buf,
+            member_data->datatype_size, member_data->current_count);
+   }
+
+   MPI_Startall(exchange->num_requests, exchange->requests);
+   return exchange;
+}
+
+//Expands the partner's data from a completed exchange into the head snapshot.
+void __imr_exchange_deliver(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   fenix_imr_exchange_t* exchange = &(mentry->exchange);
+   int partner_only = group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY;
+   __fenix_data_subset_deserialize(&(exchange->shape), exchange->recv_buf,
+         mentry->data[mentry->current_head] +
+         (partner_only ? 0 : exchange->datatype_size*mentry->capacity),
+         exchange->count, exchange->datatype_size);
+}
+
+//Records that the head snapshot now holds subset, once all of its data is in place.
+void __imr_store_record(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      Fenix_Data_subset* subset, int datatype_size, size_t count){
+   if(mentry->window_stores == 0){
+      __imr_checksum_stored(group, mentry, mentry->data[mentry->current_head], subset,
+            datatype_size);
+   }
+
+   //Make sure to update which data regions this entry contains.
+   __fenix_data_subset_merge_inplace(mentry->data_regions + mentry->current_head, subset);
+   mentry->counts[mentry->current_head] = count;
+}
+
+//Completes the member's in-flight istore, if it has one. Without wait this
+//only checks, leaving flag unset while the exchange is still under way.
+int __imr_exchange_finish(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int wait,
+      int* flag){
+   fenix_imr_exchange_t* exchange = &(mentry->exchange);
+   *flag = 1;
+   if(!exchange->in_flight) return FENIX_SUCCESS;
+
+   int ret = wait ? __fenix_progress_wait(&(exchange->op))
+                  : __fenix_progress_test(&(exchange->op), flag);
+   if(!*flag) return FENIX_SUCCESS;
+
+   exchange->in_flight = 0;
+   if(ret != MPI_SUCCESS) return FENIX_ERROR_DATA_WAIT;
+
+   __imr_exchange_deliver(group, mentry);
+   __imr_store_record(group, mentry, &(exchange->shape), exchange->datatype_size,
+         exchange->count);
+   return FENIX_SUCCESS;
+}
+
+//The request stage of an istore's exchange. A member deleted meanwhile took
+//its exchange with it.
+int __imr_exchange_stage(fenix_group_t* g, fenix_request_stage_t* stage, int wait, int* flag){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+   fenix_imr_mentry_t* mentry;
+   *flag = 1;
+   if(__imr_find_mentry(group, stage->member_id, &mentry) != FENIX_SUCCESS){
+      return FENIX_SUCCESS;
+   }
+   return __imr_exchange_finish(group, mentry, wait, flag);
+}
+
+//Snapshots must not change under an exchange, so anything that reads or
+//rearranges them completes the group's istores first.
+void __imr_exchange_finish_all(fenix_imr_group_t* group){
+   int flag;
+   for(int eid = 0; eid < group->entries_count; eid++){
+      __imr_exchange_finish(group, group->entries + eid, 1, &flag);
+   }
+}
+
+//Releases the parity reductions bound to buffer, before it is freed or moved.
+void __imr_parity_free(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, void* buffer,
+      int release){
+   for(int i = 0; i < group->base.depth + 2; i++){
+      fenix_imr_parity_t* parity = mentry->parity + i;
+      if(parity->buffer == NULL || (buffer != NULL && parity->buffer != buffer)) continue;
+
+      for(int root = 0; root < group->set_size && release; root++){
+         MPI_Request_free(parity->requests + root);
+      }
+      free(parity->requests);
+      parity->buffer = NULL;
+   }
+}
+
+#if MPI_VERSION >= 4
+//Returns the persistent reductions computing a store's parity into buffer,
+//one per set rank. Creating them is collective over the set, which works out
+//because every rank allocates, resizes and frees its buffers in step.
+MPI_Request* __imr_parity_requests(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      void* buffer, void* parity_buf, size_t* offsets, size_t* sizes, size_t count){
+   fenix_imr_parity_t* parity = NULL;
+   for(int i = 0; i < group->base.depth + 2; i++){
+      fenix_imr_parity_t* candidate = mentry->parity + i;
+      if(candidate->buffer == buffer && candidate->capacity == mentry->capacity &&
+            candidate->count == count){
+         return candidate->requests;
+      }
+      if(parity == NULL && candidate->buffer == NULL) parity = candidate;
+   }
+   if(parity == NULL){
+      __imr_parity_free(group, mentry, mentry->parity[0].buffer, 1);
+      parity = mentry->parity;
+   }
+
+   parity->buffer = buffer;
+   parity->capacity = mentry->capacity;
+   parity->count = count;
+   parity->requests = (MPI_Request*) s_malloc(group->set_size * sizeof(MPI_Request));
+   for(int root = 0; root < group->set_size; root++){
+      MPI_Reduce_init_c((char*)buffer + offsets[root], parity_buf, (MPI_Count)sizes[root],
+            MPI_BYTE, MPI_BXOR, root, __imr_member_comm(group, mentry, 1), MPI_INFO_NULL,
+            parity->requests + root);
+   }
+   return parity->requests;
+}
+#endif
+
+//Snapshot buffers are allocated when a snapshot first needs one, and every
+//allocation is charged to the group's memory accounting.
+void __imr_alloc_snapshot(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int snapshot){
+   if(mentry->data[snapshot] == NULL){
+      mentry->data[snapshot] = s_malloc(mentry->buffer_size);
+      memset(mentry->data[snapshot], 0, mentry->data_size);
+      __imr_checksum_marked(mentry, mentry->data[snapshot], NULL);
+      __fenix_group_memory_add(&group->base, mentry->buffer_size);
    }
 }
 
+void __imr_free_buffer(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, void* buffer){
+   if(buffer != NULL){
+      if(buffer == mentry->window_exposed) __imr_rma_unexpose(mentry);
+      __imr_parity_free(group, mentry, buffer, 1);
+      free(buffer);
+      __fenix_group_memory_remove(&group->base, mentry->buffer_size);
+   }
+}
+
+//The buffer store_swap lent out is the size snapshots had at the time.
+void __imr_free_lent(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+   if(mentry->lent != NULL){
+      __imr_parity_free(group, mentry, mentry->lent, 1);
+      free(mentry->lent);
+      __fenix_group_memory_remove(&group->base, mentry->lent_size);
+      mentry->lent = NULL;
+      mentry->lent_size = 0;
+   }
+}
+
+//The __FENIX_LOSSY type coding a member's elements with an error bound.
+int __imr_lossy_type(MPI_Datatype datatype){
+   if(datatype == MPI_DOUBLE) return __FENIX_LOSSY_DOUBLE;
+   if(datatype == MPI_FLOAT) return __FENIX_LOSSY_FLOAT;
+   return __FENIX_LOSSY_NONE;
+}
+
 int __imr_member_create(fenix_group_t* g, fenix_member_entry_t* mentry){
    fenix_imr_group_t* group = (fenix_imr_group_t*)g;
    int retval = -1;
@@ -287,15 +947,33 @@ int __imr_member_create(fenix_group_t* g, fenix_member_entry_t* mentry){
       //so I just need to actually fill in the data.
       new_imr_mentry->current_head = 0;
       new_imr_mentry->memberid = mentry->memberid;
+      new_imr_mentry->dedup_block = 0;
+      new_imr_mentry->error_bound = 0;
+      new_imr_mentry->lossy = __FENIX_LOSSY_NONE;
+      new_imr_mentry->window = MPI_WIN_NULL;
+      new_imr_mentry->window_exposed = NULL;
+      new_imr_mentry->window_stores = 0;
+      new_imr_mentry->exchange.num_requests = 0;
+      new_imr_mentry->exchange.in_flight = 0;
+      new_imr_mentry->exchange.op.posted = 0;
+      new_imr_mentry->comm = MPI_COMM_NULL;
+      new_imr_mentry->set_comm = MPI_COMM_NULL;
+      new_imr_mentry->lent = NULL;
+      new_imr_mentry->lent_size = 0;
+      new_imr_mentry->parity =
+         (fenix_imr_parity_t*) s_calloc(group->base.depth + 2, sizeof(fenix_imr_parity_t));
       
       new_imr_mentry->data = (void**) malloc( (group->base.depth+2) * sizeof(void*));
-      int local_data_size = mentry->datatype_size * mentry->current_count;
+      size_t local_data_size = mentry->datatype_size * mentry->current_count;
       new_imr_mentry->data_regions = 
          (Fenix_Data_subset *)malloc(sizeof(Fenix_Data_subset) * (group->base.depth+2) );
       new_imr_mentry->timestamp = (int*) malloc(sizeof(int) * (group->base.depth + 2));
+      new_imr_mentry->counts = (size_t*) malloc(sizeof(size_t) * (group->base.depth + 2));
+      new_imr_mentry->capacity = mentry->current_count;
+      __imr_set_buffer_layout(group, new_imr_mentry, local_data_size);
       
       for(int i = 0; i < group->base.depth + 2; i++){
-         __imr_alloc_data_region(new_imr_mentry->data + i, group->raid_mode, local_data_size, group->set_size);
+         new_imr_mentry->data[i] = NULL;
 
          //Initialize to smallest # blocks allowed.
          __fenix_data_subset_init(1, new_imr_mentry->data_regions + i);
@@ -303,9 +981,11 @@ int __imr_member_create(fenix_group_t* g, fenix_member_entry_t* mentry){
 
         //-1 is not a valid timestamp, use as an indicator that the data isn't valid.
         new_imr_mentry->timestamp[i] = -1;
+        new_imr_mentry->counts[i] = mentry->current_count;
       }
       //The first commit's timestamp is the group's timestart.
       new_imr_mentry->timestamp[0] = group->base.timestart;
+      __imr_alloc_snapshot(group, new_imr_mentry, 0);
 
       group->entries_count++;
 
@@ -315,16 +995,103 @@ int __imr_member_create(fenix_group_t* g, fenix_member_entry_t* mentry){
    return retval;
 }
 
-void __imr_member_free(fenix_imr_mentry_t* mentry, int depth){
+void __imr_member_free(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry){
+  int flag;
+  __imr_exchange_finish(group, mentry, 1, &flag);
+  __imr_rma_close(mentry);
+  __imr_exchange_free(&(mentry->exchange), 1);
+  __imr_member_comm_free(mentry);
+
   //Start by clearing out the mentry's data pointers.
-  for(int i = 0; i < depth + 2; i++){
+  for(int i = 0; i < group->base.depth + 2; i++){
      __fenix_data_subset_free(mentry->data_regions + i);
-     free(mentry->data[i]);
+     __imr_free_buffer(group, mentry, mentry->data[i]);
   }
+  __imr_free_lent(group, mentry);
 
+  free(mentry->parity);
   free(mentry->data);
   free(mentry->data_regions);
   free(mentry->timestamp);
+  free(mentry->counts);
+}
+
+//Snapshot regions are in elements, and FULL means "all of the count at store time".
+//Before the count changes, pin FULL regions to their actual extent.
+void __imr_pin_full_regions(fenix_imr_mentry_t* mentry){
+   for(int snapshot = 0; snapshot <= mentry->current_head; snapshot++){
+      Fenix_Data_subset* region = mentry->data_regions + snapshot;
+      if(region->specifier == __FENIX_SUBSET_FULL){
+         __fenix_data_subset_free(region);
+         if(mentry->counts[snapshot] > 0){
+            MPI_Count start = 0, end = mentry->counts[snapshot] - 1;
+            __fenix_data_subset_createv_c(1, &start, &end, region);
+         } else {
+            __fenix_data_subset_init(1, region);
+            region->specifier = __FENIX_SUBSET_EMPTY;
+         }
+      }
+   }
+}
+
+//Makes room for at least count elements in every snapshot buffer, growing
+//geometrically. Stored data (ours, our partner's, and RAID-5 parity) is kept,
+//just moved to the offsets that go with the new capacity.
+void __imr_ensure_capacity(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      int datatype_size, size_t count){
+   if(count <= mentry->capacity) return;
+
+   size_t old_capacity = mentry->capacity;
+   size_t new_capacity = 2*old_capacity > count ? 2*old_capacity : count;
+   size_t old_local_size = old_capacity*datatype_size;
+   size_t new_local_size = new_capacity*datatype_size;
+
+   size_t old_buffer_size = mentry->buffer_size;
+   __imr_rma_hold(group, mentry);
+   __imr_rma_unexpose(mentry);
+   __imr_parity_free(group, mentry, NULL, 1);
+   __imr_set_buffer_layout(group, mentry, new_local_size);
+   for(int snapshot = 0; snapshot < group->base.depth + 2; snapshot++){
+      if(mentry->data[snapshot] == NULL) continue;
+
+      char* buffer = (char*) s_realloc(mentry->data[snapshot], mentry->buffer_size);
+      __fenix_group_memory_add(&group->base, mentry->buffer_size - old_buffer_size);
+      if(group->raid_mode == 1){
+         memmove(buffer + new_local_size, buffer + old_local_size, old_local_size);
+      } else if(group->raid_mode == 5){
+         memmove(buffer + new_local_size + 2, buffer + old_local_size + 2,
+               old_local_size/(group->set_size - 1) + 1);
+      }
+      mentry->data[snapshot] = buffer;
+      __imr_checksum_marked(mentry, buffer, NULL);
+   }
+   //A buffer lent out is the app's until it comes back through store_swap,
+   //which then replaces it with one of the new size.
+
+   mentry->capacity = new_capacity;
+   __imr_rma_release(group, mentry);
+}
+
+//A member rebuilt during recovery starts with room for its current count only,
+//but snapshots from before a shrink can be larger.
+void __imr_ensure_snapshot_capacity(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      fenix_member_entry_t* member){
+   size_t largest = member->current_count;
+   for(int snapshot = 0; snapshot <= group->num_snapshots; snapshot++){
+      if(mentry->counts[snapshot] > largest) largest = mentry->counts[snapshot];
+   }
+   __imr_ensure_capacity(group, mentry, member->datatype_size, largest);
+}
+
+//Called before the core member entry takes the new count. Every rank is
+//expected to resize the same way, as the store exchange assumes partners
+//hold the same number of elements.
+void __imr_member_resize(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      fenix_member_entry_t* member, size_t new_count){
+   if(new_count == member->current_count) return;
+
+   __imr_pin_full_regions(mentry);
+   __imr_ensure_capacity(group, mentry, member->datatype_size, new_count);
 }
 
 int __imr_member_delete(fenix_group_t* g, int member_id){
@@ -341,7 +1108,7 @@ int __imr_member_delete(fenix_group_t* g, int member_id){
    } else {
       
       //Free all of the pointers in the mentry
-      __imr_member_free(mentry, group->base.depth);
+      __imr_member_free(group, mentry);
 
       //Now shift all the subsequent mentries back one, unless I'm already the last one.
       int member_index = mentry - group->entries;
@@ -356,8 +1123,266 @@ int __imr_member_delete(fenix_group_t* g, int member_id){
 
 
 
+//What identifies a block's contents. Skipping a block trusts that equal keys
+//mean equal bytes, so the 64-bit fingerprint is paired with the block's
+//CRC32C, an unrelated function, and a block is only skipped if both match.
+typedef struct __fenix_imr_block_key {
+   uint64_t fingerprint;
+   uint32_t crc;
+   uint32_t unused;     // Keeps the keys traded between ranks free of padding
+} fenix_imr_block_key_t;
+
+fenix_imr_block_key_t __imr_block_key(const void* data, size_t length){
+   fenix_imr_block_key_t key;
+   key.fingerprint = __fenix_fingerprint(data, length);
+   key.crc = __fenix_crc32c(0, data, length);
+   key.unused = 0;
+   return key;
+}
+
+//A block's key and its position in the serialized data.
+typedef struct __fenix_imr_fingerprint {
+   fenix_imr_block_key_t key;
+   size_t block;
+} fenix_imr_fingerprint_t;
+
+int __imr_fingerprint_compare(const void* a, const void* b){
+   const fenix_imr_block_key_t* first = &((const fenix_imr_fingerprint_t*)a)->key;
+   const fenix_imr_block_key_t* second = &((const fenix_imr_fingerprint_t*)b)->key;
+   if(first->fingerprint != second->fingerprint){
+      return (first->fingerprint > second->fingerprint) - (first->fingerprint < second->fingerprint);
+   }
+   return (first->crc > second->crc) - (first->crc < second->crc);
+}
+
+//Sorted lookup table of a rank's block keys.
+fenix_imr_fingerprint_t* __imr_fingerprint_table(fenix_imr_block_key_t* keys, size_t num_blocks){
+   fenix_imr_fingerprint_t* table = (fenix_imr_fingerprint_t*)
+         s_malloc(num_blocks * sizeof(fenix_imr_fingerprint_t) + 1);
+   for(size_t block = 0; block < num_blocks; block++){
+      table[block].key = keys[block];
+      table[block].block = block;
+   }
+   qsort(table, num_blocks, sizeof(fenix_imr_fingerprint_t), __imr_fingerprint_compare);
+   return table;
+}
+
+fenix_imr_fingerprint_t* __imr_fingerprint_find(fenix_imr_fingerprint_t* table,
+      size_t num_blocks, fenix_imr_block_key_t key){
+   fenix_imr_fingerprint_t entry = {key, 0};
+   return (fenix_imr_fingerprint_t*) bsearch(&entry, table, num_blocks,
+         sizeof(fenix_imr_fingerprint_t), __imr_fingerprint_compare);
+}
+
+//RAID-1 store exchange for members with an error bound. Each rank sends its
+//serialized data encoded to within the bound, so the copy its partner keeps,
+//and restores from should this rank fail, is that close to its own. Smooth
+//fields encode to a small fraction of their size. The encoded length varies,
+//so it is sent ahead of the data.
+void __imr_lossy_exchange(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      void* serialized, void* recv_buf, size_t count){
+   MPI_Comm comm = __imr_member_comm(group, mentry, 0);
+
+   uint64_t send_bytes, recv_bytes;
+   size_t encoded_bytes;
+   void* encoded = __fenix_lossy_encode(serialized, count, mentry->lossy, mentry->error_bound,
+         &encoded_bytes);
+   send_bytes = encoded_bytes;
+   __fenix_mpi_sendrecv_bytes(&send_bytes, sizeof(uint64_t), group->partners[1],
+         group->base.groupid ^ STORE_LOSSY_SIZE_TAG, &recv_bytes, sizeof(uint64_t),
+         group->partners[0], group->base.groupid ^ STORE_LOSSY_SIZE_TAG, comm);
+
+   void* packed = s_malloc(recv_bytes + 1);
+   __fenix_mpi_sendrecv_bytes(encoded, send_bytes, group->partners[1],
+         group->base.groupid ^ STORE_PAYLOAD_TAG, packed, recv_bytes, group->partners[0],
+         group->base.groupid ^ STORE_PAYLOAD_TAG, comm);
+   __fenix_lossy_decode(packed, recv_bytes, recv_buf, count, mentry->lossy, mentry->error_bound);
+
+   if(fenix.options.verbose == 58){
+      size_t value_size = mentry->lossy == __FENIX_LOSSY_DOUBLE ? sizeof(double) : sizeof(float);
+      verbose_print("c-rank: %d, member: %d, sent %zu of %zu bytes, received %zu\n",
+                    group->base.current_rank, mentry->memberid, (size_t)send_bytes,
+                    count*value_size, (size_t)recv_bytes);
+   }
+
+   free(packed);
+   free(encoded);
+}
+
+//RAID-1 store exchange for members with dedup blocks. Each rank keys the
+//blocks of its serialized data and trades keys with both partners. A block is
+//only sent if the rank keeping it has no identical block of its own data,
+//otherwise the keeper copies its own block. Both ends decide this from the
+//same keys, so the payload needs no extra description. Replicated data such
+//as tables and parameters is then sent once per pair. The keeper still holds
+//a full copy, so this saves bandwidth, not memory.
+void __imr_dedup_exchange(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      int datatype_size, void* serialized, void* recv_buf, size_t bytes){
+   size_t block_bytes = mentry->dedup_block * datatype_size;
+   size_t num_blocks = bytes == 0 ? 0 : (bytes - 1)/block_bytes + 1;
+   size_t fingerprint_bytes = num_blocks * sizeof(fenix_imr_block_key_t);
+
+   MPI_Comm comm = __imr_member_comm(group, mentry, 0);
+
+   fenix_imr_block_key_t* mine = (fenix_imr_block_key_t*) s_malloc(fingerprint_bytes + 1);
+   for(size_t block = 0; block < num_blocks; block++){
+      size_t offset = block*block_bytes;
+      size_t length = bytes - offset < block_bytes ? bytes - offset : block_bytes;
+      mine[block] = __imr_block_key((char*)serialized + offset, length);
+   }
+
+   //incoming describes the data we keep for partners[0], keeper_own describes
+   //the data partners[1] keeps for itself. With a single partner they match.
+   fenix_imr_block_key_t* incoming = (fenix_imr_block_key_t*) s_malloc(fingerprint_bytes + 1);
+   __fenix_mpi_sendrecv_bytes(mine, fingerprint_bytes, group->partners[1],
+         group->base.groupid ^ STORE_FINGERPRINT_TAG, incoming, fingerprint_bytes,
+         group->partners[0], group->base.groupid ^ STORE_FINGERPRINT_TAG, comm);
+   fenix_imr_block_key_t* keeper_own = incoming;
+   if(group->partners[0] != group->partners[1]){
+      keeper_own = (fenix_imr_block_key_t*) s_malloc(fingerprint_bytes + 1);
+      __fenix_mpi_sendrecv_bytes(mine, fingerprint_bytes, group->partners[0],
+            group->base.groupid ^ STORE_FINGERPRINT_TAG, keeper_own, fingerprint_bytes,
+            group->partners[1], group->base.groupid ^ STORE_FINGERPRINT_TAG, comm);
+   }
+
+   fenix_imr_fingerprint_t* own_table = __imr_fingerprint_table(mine, num_blocks);
+   fenix_imr_fingerprint_t* keeper_table = __imr_fingerprint_table(keeper_own, num_blocks);
+
+   char* send_buf = (char*) s_malloc(bytes + 1);
+   size_t send_bytes = 0, recv_bytes = 0;
+   for(size_t block = 0; block < num_blocks; block++){
+      size_t offset = block*block_bytes;
+      size_t length = bytes - offset < block_bytes ? bytes - offset : block_bytes;
+      if(__imr_fingerprint_find(keeper_table, num_blocks, mine[block]) == NULL){
+         memcpy(send_buf + send_bytes, (char*)serialized + offset, length);
+         send_bytes += length;
+      }
+      if(__imr_fingerprint_find(own_table, num_blocks, incoming[block]) == NULL){
+         recv_bytes += length;
+      }
+   }
+
+   char* packed = (char*) s_malloc(recv_bytes + 1);
+   __fenix_mpi_sendrecv_bytes(send_buf, send_bytes, group->partners[1],
+         group->base.groupid ^ STORE_PAYLOAD_TAG, packed, recv_bytes, group->partners[0],
+         group->base.groupid ^ STORE_PAYLOAD_TAG, comm);
+
+   size_t unpacked = 0;
+   for(size_t block = 0; block < num_blocks; block++){
+      size_t offset = block*block_bytes;
+      size_t length = bytes - offset < block_bytes ? bytes - offset : block_bytes;
+      fenix_imr_fingerprint_t* match = __imr_fingerprint_find(own_table, num_blocks,
+            incoming[block]);
+      if(match != NULL){
+         memcpy((char*)recv_buf + offset, (char*)serialized + match->block*block_bytes, length);
+      } else {
+         memcpy((char*)recv_buf + offset, packed + unpacked, length);
+         unpacked += length;
+      }
+   }
+
+   if(fenix.options.verbose == 36){
+      verbose_print("c-rank: %d, member: %d, sent %zu of %zu bytes, received %zu of %zu bytes\n",
+                    group->base.current_rank, mentry->memberid, send_bytes, bytes,
+                    recv_bytes, bytes);
+   }
+
+   free(packed);
+   free(send_buf);
+   free(keeper_table);
+   free(own_table);
+   if(keeper_own != incoming) free(keeper_own);
+   free(incoming);
+   free(mine);
+}
+
+//Checks the member's declared silent data corruption regions before they are
+//stored. Replicated regions are compared by CRC32C with the partner whose data
+//we keep (RAID-1) or by majority over the set (RAID-5), so every rank must call
+//this for the member. Immutable regions are compared with their CRC from the
+//first store after they were declared. Returns FENIX_WARNING_SDC_DETECTED after
+//reporting any mismatch.
+int __imr_sdc_check(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      fenix_member_entry_t* member_data){
+   int retval = FENIX_SUCCESS;
+
+   if(member_data->sdc_replicated.specifier != __FENIX_SUBSET_EMPTY){
+      uint32_t mine = __fenix_data_subset_checksum_user(&(member_data->sdc_replicated),
+            member_data->user_data, &(member_data->layout), member_data->current_count);
+      int mismatch = 0;
+      if(__imr_is_raid1(group->raid_mode)){
+         uint32_t theirs;
+         MPI_Sendrecv(&mine, 1, MPI_UINT32_T, group->partners[1],
+               group->base.groupid ^ SDC_FINGERPRINT_TAG, &theirs, 1, MPI_UINT32_T,
+               group->partners[0], group->base.groupid ^ SDC_FINGERPRINT_TAG,
+               __imr_member_comm(group, mentry, 0), MPI_STATUS_IGNORE);
+         mismatch = theirs != mine;
+      } else if(group->raid_mode == 5){
+         //With a majority agreeing, only the ranks outside it are corrupt.
+         uint32_t* all = (uint32_t*) s_malloc(group->set_size * sizeof(uint32_t));
+         MPI_Allgather(&mine, 1, MPI_UINT32_T, all, 1, MPI_UINT32_T,
+               __imr_member_comm(group, mentry, 1));
+         int agreeing = 0;
+         for(int i = 0; i < group->set_size; i++) agreeing += all[i] == mine;
+         mismatch = agreeing*2 <= group->set_size;
+         free(all);
+      }
+      if(mismatch){
+         __fenix_sdc_report(group->base.groupid, member_data->memberid, FENIX_DATA_SDC_REPLICATED);
+         retval = FENIX_WARNING_SDC_DETECTED;
+      }
+   }
+
+   if(member_data->sdc_immutable.specifier != __FENIX_SUBSET_EMPTY){
+      uint32_t crc = __fenix_data_subset_checksum_user(&(member_data->sdc_immutable),
+            member_data->user_data, &(member_data->layout), member_data->current_count);
+      if(!member_data->sdc_has_reference){
+         member_data->sdc_reference = crc;
+         member_data->sdc_has_reference = 1;
+      } else if(crc != member_data->sdc_reference){
+         __fenix_sdc_report(group->base.groupid, member_data->memberid, FENIX_DATA_SDC_IMMUTABLE);
+         retval = FENIX_WARNING_SDC_DETECTED;
+      }
+   }
+
+   return retval;
+}
+
+//With dirty-page tracking, a full RAID-1 store only has to store the pages
+//written since the member's last store, its older snapshots holding the rest.
+//RAID-5 parity covers the whole buffer anyway, and its snapshots can't be
+//folded together when the oldest one is given up. Every rank of the group
+//takes part, so that all of them store the same subset.
+int __imr_dirty_narrow(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      Fenix_Data_subset* requested, Fenix_Data_subset* dirty){
+   if(!fenix.dirty_tracking || !__imr_is_raid1(group->raid_mode) ||
+         requested->specifier != __FENIX_SUBSET_FULL){
+      return 0;
+   }
+
+   int member_data_index = __fenix_search_memberid(group->base.member, mentry->memberid);
+   fenix_member_entry_t* member_data = group->base.member->member_entry + member_data_index;
+   //Non-contiguous members are gathered from wherever their datatype points.
+   void* data = member_data->layout.contiguous ? member_data->user_data : NULL;
+   return __fenix_dirty_subset(&(member_data->dirty), data, member_data->current_count,
+         member_data->datatype_size, __imr_member_comm(group, mentry, 0), dirty);
+}
+
 int __imr_member_store(fenix_group_t* g, int member_id, 
         Fenix_Data_subset subset_specifier){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+   fenix_imr_mentry_t* mentry;
+   Fenix_Data_subset dirty;
+   int narrowed = __imr_find_mentry(group, member_id, &mentry) == FENIX_SUCCESS &&
+         __imr_dirty_narrow(group, mentry, &subset_specifier, &dirty);
+
+   int retval = __imr_member_store_subset(g, member_id, narrowed ? dirty : subset_specifier);
+   if(narrowed) __fenix_data_subset_free(&dirty);
+   return retval;
+}
+
+int __imr_member_store_subset(fenix_group_t* g, int member_id, 
+        Fenix_Data_subset subset_specifier){
    int retval = -1;
    fenix_imr_group_t* group = (fenix_imr_group_t*)g;
    
@@ -375,32 +1400,71 @@ int __imr_member_store(fenix_group_t* g, int member_id,
                 member_id, g->current_rank);
       retval = FENIX_ERROR_INVALID_MEMBERID;
    } else {
+      int flag;
+      __imr_exchange_finish(group, mentry, 1, &flag);
+      retval = __imr_sdc_check(group, mentry, member_data);
+
       //Copy my own data, trade data with partner, update data region
       //Store my data at the beginning of the member's buffer, resiliency data after that.
-      __fenix_data_subset_copy_data(&subset_specifier, mentry->data[mentry->current_head],
-         member_data->user_data, member_data->datatype_size, member_data->current_count);
+      //Partner-only mode has no local copy, the buffer holds just the partner's data.
+      int partner_only = group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY;
+      void* own_data = member_data->user_data;
+      if(!partner_only){
+         //A buffer adopted by store_swap already is the head snapshot.
+         if(member_data->user_data != mentry->data[mentry->current_head]){
+            __fenix_data_subset_copy_from_user(&subset_specifier,
+               mentry->data[mentry->current_head], member_data->user_data,
+               &(member_data->layout), member_data->current_count);
+         }
+         own_data = mentry->data[mentry->current_head];
+      }
       
-      if(group->raid_mode == 1){
+      int lossy = mentry->lossy != __FENIX_LOSSY_NONE;
+      if(__imr_is_raid1(group->raid_mode) && mentry->dedup_block == 0 && !group->rma && !lossy){
+         //Repeated stores of one shape reuse the same persistent exchange.
+         fenix_imr_exchange_t* exchange =
+               __imr_exchange_start(group, mentry, &subset_specifier, member_data, own_data);
+         MPI_Waitall(exchange->num_requests, exchange->requests, MPI_STATUSES_IGNORE);
+         __imr_exchange_deliver(group, mentry);
+
+      } else if(__imr_is_raid1(group->raid_mode)){
 
          size_t serialized_size;
-         void* serialized = __fenix_data_subset_serialize(&subset_specifier, 
-               mentry->data[mentry->current_head], member_data->datatype_size, 
-               member_data->current_count, &serialized_size);
+         void* serialized;
+         if(partner_only){
+            serialized = __fenix_data_subset_serialize_user(&subset_specifier, own_data,
+                  &(member_data->layout), member_data->current_count, &serialized_size);
+         } else {
+            serialized = __fenix_data_subset_serialize(&subset_specifier, 
+                  own_data, member_data->datatype_size, 
+                  member_data->current_count, &serialized_size);
+         }
 
-         void* recv_buf = malloc(serialized_size * member_data->datatype_size);
+         if(group->rma && mentry->dedup_block == 0 && !lossy){
+            //The partner's data arrives on its own time, commit waits for it.
+            int ret = __imr_rma_store(group, mentry, &subset_specifier, serialized,
+                  member_data->datatype_size, member_data->current_count);
+            if(ret != MPI_SUCCESS) retval = ret;
+            free(serialized);
+         } else {
+            void* recv_buf = malloc(serialized_size * member_data->datatype_size);
 
-         MPI_Sendrecv(serialized, serialized_size * member_data->datatype_size, MPI_BYTE,
-               group->partners[1], group->base.groupid ^ STORE_PAYLOAD_TAG, recv_buf, 
-               serialized_size * member_data->datatype_size, MPI_BYTE, group->partners[0], 
-               group->base.groupid ^ STORE_PAYLOAD_TAG, group->base.comm, NULL); 
+            if(lossy){
+               __imr_lossy_exchange(group, mentry, serialized, recv_buf, serialized_size);
+            } else {
+               __imr_dedup_exchange(group, mentry, member_data->datatype_size, serialized,
+                     recv_buf, serialized_size * member_data->datatype_size);
+            }
 
-         //Expand the serialized data out and store into the partner's portion of this data entry.
-         __fenix_data_subset_deserialize(&subset_specifier, recv_buf, 
-               mentry->data[mentry->current_head] + member_data->datatype_size*member_data->current_count,
-               member_data->current_count, member_data->datatype_size);
+            //Expand the serialized data out and store into the partner's portion of this data entry.
+            __fenix_data_subset_deserialize(&subset_specifier, recv_buf, 
+                  mentry->data[mentry->current_head] + 
+                  (partner_only ? 0 : member_data->datatype_size*mentry->capacity),
+                  member_data->current_count, member_data->datatype_size);
 
-         free(recv_buf);
-         free(serialized);
+            free(recv_buf);
+            free(serialized);
+         }
 
       } else if(group->raid_mode == 5){
          //TODO: Try to optimize for partial commits - currently does parity on the whole region regardless of commit area.
@@ -431,34 +1495,52 @@ int __imr_member_store(fenix_group_t* g, int member_id,
          //    to get the accurate parity info.
          //    This involves computing the XOR on an extra 2/(set_size-1)*parity_size of data, but minimizes excess memory allocation
          //    and network use. Scales well with higher set sizes.
-         int parity_size = (member_data->datatype_size * member_data->current_count)/(group->set_size - 1);
-         int remainder = (member_data->datatype_size * member_data->current_count)%(group->set_size - 1);
+         size_t parity_size = (member_data->datatype_size * member_data->current_count)/(group->set_size - 1);
+         size_t remainder = (member_data->datatype_size * member_data->current_count)%(group->set_size - 1);
 
          if(remainder != 0) remainder++;
          
          void* data_buf = mentry->data[mentry->current_head];
          //store parity info after my data in data region.
          //we always have a spare data buffer byte for rounding stuff, so store after that as well.
-         void* parity_buf = (void*)((char*)data_buf + member_data->datatype_size*member_data->current_count + 2);
+         void* parity_buf = (void*)((char*)data_buf + member_data->datatype_size*mentry->capacity + 2);
          
          int my_set_rank;
-         MPI_Comm_rank(group->set_comm, &my_set_rank);
-         int offset = 0, rounding_compensator;
+         MPI_Comm set_comm = __imr_member_comm(group, mentry, 1);
+         MPI_Comm_rank(set_comm, &my_set_rank);
+         size_t* offsets = (size_t*) s_malloc(group->set_size * sizeof(size_t));
+         size_t* sizes = (size_t*) s_malloc(group->set_size * sizeof(size_t));
+         size_t offset = 0;
          for(int i = 0; i < group->set_size; i++){
             //Last node is an edge case.
             if((my_set_rank == group->set_size-1) && i==my_set_rank){
               offset = 0;
             }
 
-            MPI_Reduce((void*)((char*)data_buf) + offset, parity_buf, parity_size + (i < remainder ? 1 : 0), MPI_BYTE,
-                MPI_BXOR, i, group->set_comm);
+            offsets[i] = offset;
+            sizes[i] = parity_size + ((size_t)i < remainder ? 1 : 0);
             if(i != my_set_rank){
-               offset += parity_size + (i < remainder ? 1 : 0);
+               offset += parity_size + ((size_t)i < remainder ? 1 : 0);
             }
          }
 
+#if MPI_VERSION >= 4
+         //The reductions only depend on the buffer and the count, so they persist across stores.
+         MPI_Request* reductions = __imr_parity_requests(group, mentry, data_buf, parity_buf,
+               offsets, sizes, member_data->current_count);
+         MPI_Startall(group->set_size, reductions);
+         MPI_Waitall(group->set_size, reductions, MPI_STATUSES_IGNORE);
+#else
+         for(int i = 0; i < group->set_size; i++){
+            __fenix_mpi_reduce_bytes((char*)data_buf + offsets[i], parity_buf, sizes[i],
+                MPI_BXOR, i, set_comm);
+         }
+#endif
+         free(offsets);
+         free(sizes);
+
          //Each node has buffer which contains parity^some_local_data, so now pull parity from that.
-         offset = my_set_rank * parity_size + (my_set_rank < remainder ? my_set_rank : remainder);
+         offset = my_set_rank * parity_size + ((size_t)my_set_rank < remainder ? (size_t)my_set_rank : remainder);
          
          //As above, last node is an edge case.
          if(my_set_rank == group->set_size - 1){
@@ -466,8 +1548,8 @@ int __imr_member_store(fenix_group_t* g, int member_id,
          }
 
          //Utilize MPI's local XOR function, assuming it is more optimized than a naive implementation would be.
-         MPI_Reduce_local((void*)((char*)data_buf + offset), parity_buf, parity_size + (my_set_rank < remainder ? 1 : 0),
-             MPI_BYTE, MPI_BXOR);
+         __fenix_mpi_reduce_local_bytes((void*)((char*)data_buf + offset), parity_buf, parity_size + ((size_t)my_set_rank < remainder ? 1 : 0),
+             MPI_BXOR);
 
          //Finally, each node has the right stuff.
 
@@ -477,9 +1559,8 @@ int __imr_member_store(fenix_group_t* g, int member_id,
          retval = FENIX_ERROR_UNINITIALIZED; 
       }
 
-      //Make sure to update which data regions this entry contains.
-      __fenix_data_subset_merge_inplace(mentry->data_regions + mentry->current_head, &subset_specifier);
-      
+      __imr_store_record(group, mentry, &subset_specifier, member_data->datatype_size,
+            member_data->current_count);
    }
 
 
@@ -492,60 +1573,352 @@ int __imr_member_store(fenix_group_t* g, int member_id,
 
 int __imr_member_storev(fenix_group_t* group, int member_id, 
         Fenix_Data_subset subset_specifier){return 0;}
-int __imr_member_istore(fenix_group_t* group, int member_id, 
-        Fenix_Data_subset subset_specifier, Fenix_Request *request){return 0;}
+
+//A full store that takes the app's buffer as the head snapshot when it is the
+//one lent out last time, leaving the old head's buffer lent in its place. Only
+//the tail past our own data, which the store doesn't write all of, is carried
+//over. Snapshot buffers keep partner data or parity and checksums after the
+//app's data, so a buffer the app allocated itself is copied once, and a lent
+//buffer is allocated for the next call. One lent before the member grew no
+//longer fits a snapshot, so it is copied the same way and only freed after. RAID-5 parity reductions are set up per
+//buffer, so every rank of the set has to swap, or not, in step.
+int __imr_member_store_swap(fenix_group_t* g, int member_id, void** buffer){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+
+   fenix_imr_mentry_t* mentry;
+   if(__imr_find_mentry(group, member_id, &mentry) != FENIX_SUCCESS){
+      debug_print("ERROR Fenix_Data_member_store_swap: member_id <%d> does not exist on rank <%d>!\n",
+                member_id, g->current_rank);
+      return FENIX_ERROR_INVALID_MEMBERID;
+   }
+
+   int member_data_index = __fenix_search_memberid(group->base.member, member_id);
+   fenix_member_entry_t* member_data = &(group->base.member->member_entry[member_data_index]);
+
+   if(group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY || group->rma ||
+         !member_data->layout.contiguous){
+      debug_print("ERROR Fenix_Data_member_store_swap: member_id <%d> can't adopt app buffers\n",
+                member_id);
+      return FENIX_ERROR_INVALID_LOGIC_CALL;
+   }
+
+   int flag;
+   __imr_exchange_finish(group, mentry, 1, &flag);
+
+   void* source = *buffer;
+   size_t local_size = mentry->capacity * member_data->datatype_size;
+   int stale = mentry->lent_size != mentry->buffer_size;
+   if(source != NULL && source == mentry->lent && stale &&
+         member_data->current_count * member_data->datatype_size > mentry->lent_size){
+      debug_print("ERROR Fenix_Data_member_store_swap: member_id <%d> grew past the buffer it lent out\n",
+                member_id);
+      return FENIX_ERROR_INVALID_LOGIC_CALL;
+   }
+   if(source != NULL && source == mentry->lent && !stale){
+      void* old_head = mentry->data[mentry->current_head];
+      memcpy((char*)source + local_size, (char*)old_head + local_size,
+            mentry->buffer_size - local_size);
+      mentry->data[mentry->current_head] = source;
+      mentry->lent = old_head;
+   }
+
+   void* user_data = member_data->user_data;
+   member_data->user_data = source;
+   int retval = __imr_member_store_subset(g, member_id, FENIX_DATA_SUBSET_FULL);
+   member_data->user_data = user_data;
+   //The snapshot no longer holds what the member's own buffer did.
+   __fenix_dirty_forget(member_data->dirty);
+
+   if(stale){
+      __imr_free_lent(group, mentry);
+      mentry->lent = s_malloc(mentry->buffer_size);
+      mentry->lent_size = mentry->buffer_size;
+      __fenix_group_memory_add(&group->base, mentry->lent_size);
+   }
+
+   *buffer = mentry->lent;
+   return retval;
+}
+int __imr_member_istore(fenix_group_t* g, int member_id, 
+        Fenix_Data_subset subset_specifier, Fenix_Request *request){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+
+   fenix_imr_mentry_t* mentry;
+   if(__imr_find_mentry(group, member_id, &mentry) != FENIX_SUCCESS){
+      debug_print("ERROR Fenix_Data_member_istore: member_id <%d> does not exist on rank <%d>!\n",
+                member_id, g->current_rank);
+      return FENIX_ERROR_INVALID_MEMBERID;
+   }
+
+   //Only the plain RAID-1 exchange is left in flight, everything else is
+   //stored right away and the request is complete on return.
+   if(!__imr_is_raid1(group->raid_mode) || mentry->dedup_block > 0 || group->rma ||
+         mentry->lossy != __FENIX_LOSSY_NONE){
+      return __imr_member_store(g, member_id, subset_specifier);
+   }
+
+   int member_data_index = __fenix_search_memberid(group->base.member, member_id);
+   fenix_member_entry_t* member_data = &(group->base.member->member_entry[member_data_index]);
+
+   //One istore in flight per member, the data it exchanges lives in the member's buffers.
+   int flag;
+   __imr_exchange_finish(group, mentry, 1, &flag);
+   int retval = __imr_sdc_check(group, mentry, member_data);
+
+   Fenix_Data_subset dirty;
+   int narrowed = __imr_dirty_narrow(group, mentry, &subset_specifier, &dirty);
+   if(narrowed) subset_specifier = dirty;
+
+   //The local copy is taken now, so the app may reuse its buffer right away.
+   void* own_data = member_data->user_data;
+   if(group->raid_mode != FENIX_DATA_POLICY_IMR_PARTNER_ONLY){
+      __fenix_data_subset_copy_from_user(&subset_specifier, mentry->data[mentry->current_head],
+         member_data->user_data, &(member_data->layout), member_data->current_count);
+      own_data = mentry->data[mentry->current_head];
+   }
+
+   fenix_imr_exchange_t* exchange =
+         __imr_exchange_start(group, mentry, &subset_specifier, member_data, own_data);
+   if(narrowed) __fenix_data_subset_free(&dirty);
+   __fenix_progress_post(&(exchange->op), exchange->requests, exchange->num_requests,
+         __imr_member_comm(group, mentry, 0));
+   exchange->in_flight = 1;
+   __fenix_request_push(*request, __imr_exchange_stage, member_id, NULL);
+
+   return retval;
+}
+
 int __imr_member_istorev(fenix_group_t* group, int member_id, 
            Fenix_Data_subset subset_specifier, Fenix_Request *request){return 0;}
 
 
 
+//Folds a snapshot into the next newer one so that giving it up loses no data
+//the newer one depends on. The newer snapshot's data is copied over the older
+//one's, and the two swap buffers and regions, leaving the outdated buffer in
+//the older slot. Parity can't be folded, RAID-5 only drops a snapshot from the
+//middle when the next one is complete by itself.
+void __imr_fold_into_next(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int index){
+   Fenix_Data_subset* older = mentry->data_regions + index;
+   Fenix_Data_subset* newer = mentry->data_regions + index + 1;
+   if(newer->specifier == __FENIX_SUBSET_FULL) return;
+
+   int member_index = __fenix_search_memberid(group->base.member, mentry->memberid);
+   int datatype_size = group->base.member->member_entry[member_index].datatype_size;
+   char* older_data = (char*) mentry->data[index];
+   char* newer_data = (char*) mentry->data[index + 1];
+
+   __fenix_data_subset_copy_data(newer, older_data, newer_data, datatype_size, mentry->capacity);
+   if(group->raid_mode == 1){
+      size_t partner_offset = mentry->capacity*datatype_size;
+      __fenix_data_subset_copy_data(newer, older_data + partner_offset,
+            newer_data + partner_offset, datatype_size, mentry->capacity);
+   }
+   __imr_checksum_stored(group, mentry, older_data, newer, datatype_size);
+   __fenix_data_subset_merge_inplace(older, newer);
+
+   Fenix_Data_subset merged = *older;
+   *older = *newer;
+   *newer = merged;
+   mentry->data[index] = newer_data;
+   mentry->data[index + 1] = older_data;
+}
+
+//Gives up a committed snapshot of a member. Its buffer becomes the next
+//staging area if that one has no buffer yet, otherwise it is released.
+void __imr_drop_snapshot(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int index){
+   int last = group->base.depth + 1;
+   if(group->raid_mode != 5){
+      __imr_fold_into_next(group, mentry, index);
+   }
+   void* dropped = mentry->data[index];
+   int moved = last - index;
+
+   __fenix_data_subset_free(mentry->data_regions + index);
+   memmove(mentry->data + index, mentry->data + index + 1, moved*sizeof(void*));
+   memmove(mentry->data_regions + index, mentry->data_regions + index + 1, moved*sizeof(Fenix_Data_subset));
+   memmove(mentry->timestamp + index, mentry->timestamp + index + 1, moved*sizeof(int));
+   memmove(mentry->counts + index, mentry->counts + index + 1, moved*sizeof(size_t));
+
+   mentry->data[last] = NULL;
+   __fenix_data_subset_init(1, mentry->data_regions + last);
+   mentry->data_regions[last].specifier = __FENIX_SUBSET_EMPTY;
+   mentry->timestamp[last] = -1;
+   mentry->counts[last] = mentry->counts[last - 1];
+   mentry->current_head--;
+
+   int next = mentry->current_head + 1;
+   if(next <= last && mentry->data[next] == NULL){
+      mentry->data[next] = dropped;
+   } else {
+      __imr_free_buffer(group, mentry, dropped);
+   }
+}
+
+//Picks the snapshot a full group gives up on this commit. All members hold the
+//same timestamps, so the first one decides for everyone.
+int __imr_retention_victim(fenix_imr_group_t* group){
+   if(group->entries_count == 0) return 0;
+
+   int victim = __fenix_group_retention_victim(&group->base, group->entries[0].timestamp,
+         group->base.depth + 2);
+   if(group->raid_mode == 5 && victim > 0){
+      for(int eid = 0; eid < group->entries_count; eid++){
+         if(group->entries[eid].data_regions[victim + 1].specifier != __FENIX_SUBSET_FULL){
+            victim = 0;
+            break;
+         }
+      }
+   }
+   return victim;
+}
+
+//With a memory budget, decides how many of the oldest snapshots this commit
+//gives up instead of growing past the budget. The first one only saves the
+//new staging buffers, each further one frees a buffer per member. At least
+//the snapshot being committed is always kept. Ranks agree on the largest
+//count so every rank keeps the same snapshots, which includes ranks with no
+//budget or no members of their own: they still take part, asking for none.
+int __imr_snapshots_to_evict(fenix_imr_group_t* group){
+   size_t budget = group->base.memory_budget;
+   int evict = 0;
+   if(budget != 0 && group->entries_count != 0){
+      size_t usage = group->base.memory_usage, needed = 0, per_snapshot = 0;
+      for(int eid = 0; eid < group->entries_count; eid++){
+         fenix_imr_mentry_t* mentry = group->entries + eid;
+         if(mentry->current_head < group->base.depth + 1 &&
+               mentry->data[mentry->current_head + 1] == NULL){
+            needed += mentry->buffer_size;
+         }
+         per_snapshot += mentry->buffer_size;
+      }
+
+      int max_evict = group->entries[0].current_head;
+      if(usage + needed > budget && max_evict > 0){
+         evict = 1;
+         while(usage > budget && evict < max_evict){
+            usage -= per_snapshot;
+            evict++;
+         }
+      }
+   }
+
+   int global_evict;
+   MPI_Allreduce(&evict, &global_evict, 1, MPI_INT, MPI_MAX, group->base.comm);
+
+   if(global_evict > 0 && fenix.options.verbose == 31 && group->base.current_rank == 0){
+      verbose_print("group: %d, usage: %zu, budget: %zu, evicting %d snapshot(s)\n",
+                    group->base.groupid, group->base.memory_usage, budget, global_evict);
+   }
+   return global_evict;
+}
+
+//Sends each member's newest snapshot to this rank's spare, as the two parts a
+//restore of it would receive: the copy kept for the partner, then this rank's
+//own data. Only full RAID-1 copies hold both.
+void __imr_standby_trickle(fenix_imr_group_t* group){
+   if(group->raid_mode != 1) return;
+
+   for(int eid = 0; eid < group->entries_count; eid++){
+      fenix_imr_mentry_t* mentry = group->entries + eid;
+      if(!__fenix_standby_ready(group->base.groupid, mentry->memberid)) continue;
+
+      int member_data_index = __fenix_search_memberid(group->base.member, mentry->memberid);
+      fenix_member_entry_t* member_data = group->base.member->member_entry + member_data_index;
+      int snapshot = mentry->current_head - 1;
+
+      fenix_standby_header_t header;
+      header.groupid = group->base.groupid;
+      header.memberid = mentry->memberid;
+      header.timestamp = mentry->timestamp[snapshot];
+      header.keep = group->base.depth + 1;
+
+      size_t size;
+      void* parts[2];
+      parts[0] = __fenix_data_subset_serialize(mentry->data_regions + snapshot,
+            ((char*)mentry->data[snapshot]) + member_data->datatype_size*mentry->capacity,
+            member_data->datatype_size, member_data->current_count, &size);
+      header.bytes[0] = size*member_data->datatype_size;
+      parts[1] = __fenix_data_subset_serialize(mentry->data_regions + snapshot,
+            mentry->data[snapshot], member_data->datatype_size, member_data->current_count, &size);
+      header.bytes[1] = size*member_data->datatype_size;
+
+      //Snapshots the member wasn't stored in have nothing to restore.
+      if(size > 0) __fenix_standby_send(&header, parts);
+      free(parts[0]);
+      free(parts[1]);
+   }
+}
+
 int __imr_commit(fenix_group_t* g){
-   //No sources of error for this one yet.
    int to_return = FENIX_SUCCESS;
    
    fenix_imr_group_t *group = (fenix_imr_group_t*)g;
+   __imr_exchange_finish_all(group);
+
+   for(int eid = 0; eid < group->entries_count; eid++){
+      int ret = __imr_rma_wait(group, group->entries + eid);
+      //A hold that fails has already closed the control block.
+      int num_held = eid;
+      if(ret == MPI_SUCCESS){
+         ret = __imr_rma_hold(group, group->entries + eid);
+         num_held++;
+      }
+      if(ret != MPI_SUCCESS){
+         //The partner failed or the communicator was revoked. Nothing is
+         //committed, so the entries held so far go back as they were.
+         for(int held = 0; held < num_held; held++){
+            __imr_rma_release(group, group->entries + held);
+         }
+         return ret;
+      }
+   }
+
+   //Shrink the effective depth first if we're over budget.
+   int evict = __imr_snapshots_to_evict(group);
+   for(int eid = 0; eid < group->entries_count; eid++){
+      for(int i = 0; i < evict; i++){
+         __imr_drop_snapshot(group, group->entries + eid, 0);
+      }
+   }
+   group->num_snapshots -= evict;
+
+   //Once depth has been reached, retention decides which snapshot makes room.
+   int full = group->entries_count > 0 &&
+         group->entries[0].current_head == group->base.depth + 1;
+   int victim = full ? __imr_retention_victim(group) : 0;
+   if(full && fenix.options.verbose == 32 && group->base.current_rank == 0){
+      verbose_print("group: %d, dropping snapshot %d at position %d\n", group->base.groupid,
+                    group->entries[0].timestamp[victim], victim);
+   }
 
    //For each entry id (eid)
    for(int eid = 0; eid < group->entries_count; eid++){ 
       fenix_imr_mentry_t *mentry = &group->entries[eid];
 
       //Two cases for each member entry: 
-      //    (1) depth has been reached, shift out the oldest commit 
+      //    (1) depth has been reached, give up a snapshot and reuse its buffer
       //    (2) depth has not been reached, just commit and start filling a new location.
+      //Members created after the group filled up reach depth later than the rest.
       if(mentry->current_head == group->base.depth + 1){
-         //The entry is full, one snapshot should be shifted out.
-         
-         //Save this pointer to reuse the allocated memory
-         void* first_data = mentry->data[0];
-         
-         for(int snapshot = 0; snapshot < group->base.depth + 1; snapshot++){
-            //lightweight movement, just moving the pointers about.
-            mentry->data[snapshot] = mentry->data[snapshot + 1];
-            __fenix_data_subset_deep_copy(mentry->data_regions + snapshot + 1,
-                     mentry->data_regions + snapshot);
-            mentry->timestamp[snapshot] = mentry->timestamp[snapshot + 1];
-         }
+         __imr_drop_snapshot(group, mentry, victim);
+      } else if(!full && eid == 0){
+         //Only do this once
+         group->num_snapshots++;
+      }
 
-         mentry->data[group->base.depth + 1] = first_data;
-         mentry->data_regions[group->base.depth + 1].specifier = __FENIX_SUBSET_EMPTY;
-         mentry->timestamp[group->base.depth + 1] = mentry->timestamp[group->base.depth] + 1;
-      
-      } else {
-         //The entry is not full, just shift the current head.
-         mentry->current_head++;
+      mentry->current_head++;
+      __imr_alloc_snapshot(group, mentry, mentry->current_head);
 
-         //Everything is initialized to correct values, we just need to provide
-         //the correct timestamp for the next snapshot.
-         mentry->timestamp[mentry->current_head] = mentry->timestamp[mentry->current_head-1] + 1;
-          
-         if(eid == 0){
-            //Only do this once
-            group->num_snapshots++;
-         }
-      }
+      //Everything is initialized to correct values, we just need to provide
+      //the correct timestamp for the next snapshot.
+      mentry->timestamp[mentry->current_head] = mentry->timestamp[mentry->current_head-1] + 1;
+      mentry->counts[mentry->current_head] = mentry->counts[mentry->current_head-1];
+      __imr_rma_release(group, mentry);
    }
 
    group->base.timestamp = group->entries[0].timestamp[group->entries[0].current_head - 1];
+   __imr_standby_trickle(group);
 
    return to_return;
 }
@@ -555,32 +1928,27 @@ int __imr_snapshot_delete(fenix_group_t* g, int time_stamp){
    int retval = FENIX_SUCCESS;
 
    fenix_imr_group_t *group = (fenix_imr_group_t*)g;
+   __imr_exchange_finish_all(group);
 
    for(int entry_id = 0; entry_id < group->entries_count && retval == FENIX_SUCCESS; entry_id++){
       //Search for the timestamp in each group. Given how commits and deletes work, we know
       //the snapshots are sorted by timestamp in the arrays.
-      fenix_imr_mentry_t mentry = group->entries[entry_id];
+      fenix_imr_mentry_t *mentry = group->entries + entry_id;
+      retval = FENIX_ERROR_INVALID_TIMESTAMP;
 
       //current_head is the staging area's entry, so start before that and work backwards.
       //We'll work backwards under the assumption that snapshots are likely to be deleted soon after creation.
       //  (Does this assumption seem valid?)
-      for(int snapshot = mentry.current_head - 1; snapshot >= 0 && retval == FENIX_SUCCESS; snapshot--){
-         if(mentry.timestamp[snapshot] < time_stamp){
-            retval = FENIX_ERROR_INVALID_TIMESTAMP;
-
-         } else if(mentry.timestamp[snapshot] == time_stamp){
-            void* old_data = mentry.data[snapshot];
-
-            for(int to_shift = snapshot; to_shift < mentry.current_head; to_shift++){
-               mentry.timestamp[to_shift] = mentry.timestamp[to_shift + 1];
-               __fenix_data_subset_deep_copy(mentry.data_regions + to_shift+1,
-                     mentry.data_regions + to_shift);
-               mentry.data[to_shift] = mentry.data[to_shift + 1];
-            }
-            mentry.data[mentry.current_head] = old_data;
-            mentry.data_regions[mentry.current_head].specifier = __FENIX_SUBSET_EMPTY;
+      for(int snapshot = mentry->current_head - 1; snapshot >= 0; snapshot--){
+         if(mentry->timestamp[snapshot] < time_stamp){
+            break;
 
-            mentry.current_head--;
+         } else if(mentry->timestamp[snapshot] == time_stamp){
+            //Dropping can move the head snapshot to another buffer.
+            __imr_rma_hold(group, mentry);
+            __imr_drop_snapshot(group, mentry, snapshot);
+            __imr_rma_release(group, mentry);
+            retval = FENIX_SUCCESS;
             break;
          }
       }
@@ -595,12 +1963,58 @@ int __imr_snapshot_delete(fenix_group_t* g, int time_stamp){
 
 
 
-int __imr_barrier(fenix_group_t* group){return 0;}
+//Completes the group's stores here, then trades a token with each rank that
+//keeps our data or whose data we keep: the partners for RAID-1, the rest of
+//the set for RAID-5. A token only goes out once everything we owe its
+//receiver is in place, so when ours are all in our peers have our data. That
+//is a fixed number of messages however many ranks there are.
+int __imr_barrier(fenix_group_t* g){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+   __imr_exchange_finish_all(group);
+   for(int eid = 0; eid < group->entries_count; eid++){
+      int ret = __imr_rma_wait(group, group->entries + eid);
+      if(ret != MPI_SUCCESS) return ret;
+   }
+
+   MPI_Comm comm = g->comm;
+   int num_peers = 2;
+   int* peers = group->partners;
+   if(group->raid_mode == 5){
+      comm = group->set_comm;
+      num_peers = group->set_size;
+      peers = (int*) s_malloc(num_peers * sizeof(int));
+      for(int i = 0; i < num_peers; i++) peers[i] = i;
+   }
+
+   int me;
+   MPI_Comm_rank(comm, &me);
+   int tag = g->groupid ^ BARRIER_TOKEN_TAG;
+   char* tokens = (char*) s_calloc(2*num_peers, 1);
+   MPI_Request* requests = (MPI_Request*) s_malloc(2*num_peers * sizeof(MPI_Request));
+   int num_requests = 0;
+   for(int i = 0; i < num_peers; i++){
+      if(peers[i] == me) continue;
+      MPI_Irecv(tokens + num_requests, 1, MPI_BYTE, peers[i], tag, comm, requests + num_requests);
+      num_requests++;
+   }
+   for(int i = 0; i < num_peers; i++){
+      if(peers[i] == me) continue;
+      MPI_Isend(tokens + num_requests, 1, MPI_BYTE, peers[i], tag, comm, requests + num_requests);
+      num_requests++;
+   }
+   int ret = MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE);
+
+   free(tokens);
+   free(requests);
+   if(peers != group->partners) free(peers);
+   return ret == MPI_SUCCESS ? FENIX_SUCCESS : ret;
+}
 
 
 int __imr_get_number_of_snapshots(fenix_group_t* group, 
         int* number_of_snapshots){
-   return ((fenix_imr_group_t*)group)->num_snapshots;
+   *number_of_snapshots = ((fenix_imr_group_t*)group)->num_snapshots;
+   return FENIX_SUCCESS;
 }
 
 int __imr_get_snapshot_at_position(fenix_group_t* g, int position,
@@ -623,8 +2037,163 @@ int __imr_get_snapshot_at_position(fenix_group_t* g, int position,
 }
 
 
+//Partner-only mode keeps none of our own data locally, so every rank sends the
+//snapshots it holds back to their owner and receives its own from its partner.
+//As with a local restore, only the newest snapshot up to time_stamp is sent,
+//with as many older ones as it takes to fill in what it lacks, oldest first so
+//the newest data wins where they overlap. If any of them fails its checksum
+//none are sent, and the owner is told they are corrupted rather than given
+//less data. Returns FENIX_ERROR_CORRUPTED_DATA in that case on the owner.
+int __imr_partner_only_exchange(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry,
+      fenix_member_entry_t* member_data, int holds_partner_data, int time_stamp,
+      void* target_buffer, Fenix_Data_subset* data_found){
+   int newest = -1, oldest = 0;
+   for(int snapshot = mentry->current_head - 1; snapshot >= 0 && holds_partner_data; snapshot--){
+      if(time_stamp == FENIX_TIME_STAMP_MAX || mentry->timestamp[snapshot] <= time_stamp){
+         newest = snapshot;
+         break;
+      }
+   }
+
+   //What we'll send: how many snapshots, and whether they are corrupted.
+   int send_status[2] = {0, 0};
+   if(newest != -1){
+      Fenix_Data_subset needed;
+      __fenix_data_subset_init(1, &needed);
+      needed.specifier = __FENIX_SUBSET_EMPTY;
+      for(oldest = newest; oldest > 0; oldest--){
+         __fenix_data_subset_merge_inplace(&needed, mentry->data_regions + oldest);
+         __fenix_data_subset_clip(&needed, member_data->current_count);
+         if(__fenix_data_subset_is_full(&needed, member_data->current_count)) break;
+      }
+      __fenix_data_subset_free(&needed);
+
+      send_status[0] = newest - oldest + 1;
+      for(int snapshot = oldest; snapshot <= newest; snapshot++){
+         if(__imr_verify_region(mentry, mentry->data[snapshot], mentry->data_regions + snapshot,
+               member_data->datatype_size) > 0){
+            debug_print("ERROR Fenix_Data_member_restore: member_id <%d> snapshot <%d> is corrupted on rank <%d>\n",
+                  mentry->memberid, mentry->timestamp[snapshot], group->base.current_rank);
+            send_status[0] = 0;
+            send_status[1] = 1;
+            break;
+         }
+      }
+   }
+
+   int recv_status[2];
+   MPI_Sendrecv(send_status, 2, MPI_INT, group->partners[0], RECOVER_SIZE_TAG^group->base.groupid,
+         recv_status, 2, MPI_INT, group->partners[1], RECOVER_SIZE_TAG^group->base.groupid,
+         group->base.comm, NULL);
+   int send_snapshots = send_status[0], recv_snapshots = recv_status[0];
+
+   int rounds = send_snapshots > recv_snapshots ? send_snapshots : recv_snapshots;
+   for(int round = 0; round < rounds; round++){
+      size_t send_size = 0;
+      void* send_buf = NULL;
+      if(round < send_snapshots){
+         int snapshot = oldest + round;
+         Fenix_Data_subset* send_region = mentry->data_regions + snapshot;
+         __fenix_data_subset_send(send_region, group->partners[0],
+               __IMR_RECOVER_DATA_REGION_TAG ^ group->base.groupid, group->base.comm);
+         send_size = __fenix_data_subset_data_size(send_region, member_data->current_count);
+         if(send_size > 0){
+            send_buf = __fenix_data_subset_serialize(send_region,
+                  mentry->data[snapshot], member_data->datatype_size, member_data->current_count,
+                  &send_size);
+         }
+      }
+
+      Fenix_Data_subset region;
+      size_t recv_size = 0;
+      void* recv_buf = NULL;
+      if(round < recv_snapshots){
+         __fenix_data_subset_recv(&region, group->partners[1],
+               __IMR_RECOVER_DATA_REGION_TAG ^ group->base.groupid, group->base.comm);
+         recv_size = __fenix_data_subset_data_size(&region, member_data->current_count);
+         recv_buf = malloc(recv_size * member_data->datatype_size);
+      }
+
+      __fenix_mpi_sendrecv_bytes(send_buf, send_size * member_data->datatype_size, group->partners[0],
+            RECOVER_DATA_TAG^group->base.groupid, recv_buf, recv_size * member_data->datatype_size,
+            group->partners[1], RECOVER_DATA_TAG^group->base.groupid, group->base.comm);
+
+      if(round < recv_snapshots){
+         if(target_buffer != NULL){
+            __fenix_data_subset_deserialize_user(&region, recv_buf, target_buffer,
+                  &(member_data->layout), member_data->current_count);
+         }
+         __fenix_data_subset_merge_inplace(data_found, &region);
+         __fenix_data_subset_free(&region);
+      }
+
+      free(send_buf);
+      free(recv_buf);
+   }
+
+   return recv_status[1] ? FENIX_ERROR_CORRUPTED_DATA : FENIX_SUCCESS;
+}
+
+//Tells the partner restoring a snapshot from me which of its two parts it still
+//needs, going by the keys of the copies it received as a hot standby. As with
+//dedup, a part is only skipped if both its fingerprint and its CRC32C match.
+//Returns a bit for each part to send.
+int __imr_standby_check_send(fenix_imr_group_t* group, void* parts[2], size_t bytes){
+   if(!fenix.hot_standby || bytes == 0) return 3;
+
+   //No keys at all when the partner holds no copy.
+   fenix_imr_block_key_t held[2];
+   MPI_Status status;
+   int held_bytes;
+   MPI_Recv(held, sizeof(held), MPI_BYTE, group->partners[0],
+         STANDBY_CHECK_TAG^group->base.groupid, group->base.comm, &status);
+   MPI_Get_count(&status, MPI_BYTE, &held_bytes);
+   int needed = 3;
+   for(int part = 0; part < 2 && held_bytes == (int)sizeof(held); part++){
+      fenix_imr_block_key_t key = __imr_block_key(parts[part], bytes);
+      if(held[part].fingerprint == key.fingerprint && held[part].crc == key.crc){
+         needed &= ~(1 << part);
+      }
+   }
+   MPI_Send(&needed, 1, MPI_INT, group->partners[0], STANDBY_CHECK_TAG^group->base.groupid,
+         group->base.comm);
+   return needed;
+}
+
+//The restoring side of __imr_standby_check_send. Points held at the copies of
+//the parts that won't be sent.
+int __imr_standby_check_recv(fenix_imr_group_t* group, int member_id, int timestamp,
+      size_t bytes, void* held[2]){
+   held[0] = held[1] = NULL;
+   if(!fenix.hot_standby) return 3;
+
+   size_t part_bytes[2] = {bytes, bytes};
+   uint64_t fingerprints[2];
+   uint32_t crcs[2];
+   int found = __fenix_standby_find(group->base.groupid, member_id, timestamp, part_bytes,
+         held, fingerprints, crcs) == FENIX_SUCCESS;
+   fenix_imr_block_key_t keys[2];
+   for(int part = 0; part < 2 && found; part++){
+      keys[part].fingerprint = fingerprints[part];
+      keys[part].crc = crcs[part];
+      keys[part].unused = 0;
+   }
+   MPI_Send(keys, found ? (int)sizeof(keys) : 0, MPI_BYTE, group->partners[1],
+         STANDBY_CHECK_TAG^group->base.groupid, group->base.comm);
+
+   int needed;
+   MPI_Recv(&needed, 1, MPI_INT, group->partners[1], STANDBY_CHECK_TAG^group->base.groupid,
+         group->base.comm, MPI_STATUS_IGNORE);
+   if(fenix.options.verbose == 56){
+      verbose_print("rank: %d, group: %d, member: %d, timestamp: %d, parts held: %d\n",
+            group->base.current_rank, group->base.groupid, member_id, timestamp,
+            2 - (needed & 1) - ((needed >> 1) & 1));
+   }
+   return needed;
+}
+
 int __imr_member_restore(fenix_group_t* g, int member_id,
-        void* target_buffer, int max_count, int time_stamp, Fenix_Data_subset* data_found){ 
+        void* target_buffer, size_t max_count, int time_stamp, Fenix_Data_subset* data_found){ 
    int retval = -1;
 
    fenix_imr_group_t* group = (fenix_imr_group_t*)g;
@@ -632,13 +2201,20 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
    fenix_imr_mentry_t* mentry;
    //find_mentry returns the error status. We found the member (and corresponding data) if there are no errors.
    int found_member = !(__imr_find_mentry(group, member_id, &mentry));
+   if(found_member){
+      int flag;
+      __imr_exchange_finish(group, mentry, 1, &flag);
+   }
 
    int member_data_index = __fenix_search_memberid(group->base.member, member_id);
    fenix_member_entry_t member_data = group->base.member->member_entry[member_data_index];
 
    int recovery_locally_possible;
+   int partner_only = group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY;
+   //Whether this rank holds valid data for partners[0] once recovery is done.
+   int holds_partner_data = found_member;
 
-   if(group->raid_mode == 1){
+   if(__imr_is_raid1(group->raid_mode)){
       int my_data_found, partner_data_found;
 
       //We need to know if both partners found their data.
@@ -672,28 +2248,37 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
          //They also need the timestamps for each snapshot, as well as the value for the next.
          MPI_Send((void*)mentry->timestamp, group->num_snapshots+1, MPI_INT, group->partners[0],
                RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
+         MPI_Send((void*)mentry->counts, (group->num_snapshots+1)*sizeof(size_t), MPI_BYTE,
+               group->partners[0], RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
 
-         for(int snapshot = 0; snapshot < group->num_snapshots; snapshot++){
+         //In partner-only mode I don't have my own data to give back, and their data
+         //is sent by the common exchange below.
+         for(int snapshot = 0; snapshot < group->num_snapshots && !partner_only; snapshot++){
             //send data region info next
             __fenix_data_subset_send(mentry->data_regions + snapshot, group->partners[0], 
                   __IMR_RECOVER_DATA_REGION_TAG ^ group->base.groupid, group->base.comm);
             
-            //send my data, to maintain resiliency on my data
+            //send my data, to maintain resiliency on my data, then their data
             size_t size;
-            void* toSend = __fenix_data_subset_serialize(mentry->data_regions+snapshot, 
+            void* toSend[2];
+            toSend[0] = __fenix_data_subset_serialize(mentry->data_regions+snapshot, 
                   mentry->data[snapshot], member_data.datatype_size, member_data.current_count, 
                   &size);
-            MPI_Send(toSend, member_data.datatype_size*size, MPI_BYTE, group->partners[0], 
-                  RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
-            
-            //send their data
-            toSend = __fenix_data_subset_serialize(mentry->data_regions+snapshot, 
-                  ((char*)mentry->data[snapshot]) + member_data.datatype_size*member_data.current_count,
+            toSend[1] = __fenix_data_subset_serialize(mentry->data_regions+snapshot, 
+                  ((char*)mentry->data[snapshot]) + member_data.datatype_size*mentry->capacity,
                   member_data.datatype_size, member_data.current_count, &size);
-            MPI_Send(toSend, member_data.datatype_size*size, MPI_BYTE, group->partners[0], 
-                  RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
-            
-            free(toSend);
+
+            //A hot standby partner may already hold either of them. Empty
+            //snapshots aren't received at all.
+            int needed = __imr_standby_check_send(group, toSend, member_data.datatype_size*size);
+            for(int part = 0; part < 2; part++){
+               if(size > 0 && (needed & (1 << part))){
+                  __fenix_mpi_send_bytes(toSend[part], member_data.datatype_size*size,
+                        group->partners[0], RECOVER_MEMBER_ENTRY_TAG^group->base.groupid,
+                        group->base.comm);
+               }
+               free(toSend[part]);
+            }
          }
 
       } else if(!found_member && partner_data_found) {
@@ -707,6 +2292,7 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
 
          __imr_find_mentry(group, member_id, &mentry);
          int member_data_index = __fenix_search_memberid(group->base.member, member_id);
+         group->base.member->member_entry[member_data_index].owns_datatype = packet.rebuilt_datatype;
          member_data = group->base.member->member_entry[member_data_index];
         
 
@@ -714,33 +2300,58 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
                RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm, NULL);
 
          mentry->current_head = group->num_snapshots;
+         for(int snapshot = 0; snapshot <= group->num_snapshots; snapshot++){
+            __imr_alloc_snapshot(group, mentry, snapshot);
+         }
 
          //We also need to explicitly ask for all timestamps, since user may have deleted some and caused mischief.
          MPI_Recv((void*)(mentry->timestamp), group->num_snapshots + 1, MPI_INT, group->partners[1],
                RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm, NULL);
+         MPI_Recv((void*)(mentry->counts), (group->num_snapshots + 1)*sizeof(size_t), MPI_BYTE,
+               group->partners[1], RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm, NULL);
+         __imr_ensure_snapshot_capacity(group, mentry, &member_data);
+
+         //In partner-only mode the only copy of partners[0]'s data was lost with me,
+         //so the snapshots I hold for them stay empty.
+         for(int snapshot = 0; snapshot < group->num_snapshots && partner_only; snapshot++){
+            mentry->data_regions[snapshot].specifier = __FENIX_SUBSET_EMPTY;
+         }
 
          //now recover data.
-         for(int snapshot = 0; snapshot < group->num_snapshots; snapshot++){
+         for(int snapshot = 0; snapshot < group->num_snapshots && !partner_only; snapshot++){
             __fenix_data_subset_free(mentry->data_regions+snapshot);
             __fenix_data_subset_recv(mentry->data_regions+snapshot, group->partners[1],
                   __IMR_RECOVER_DATA_REGION_TAG ^ group->base.groupid, group->base.comm);
 
-            int recv_size = __fenix_data_subset_data_size(mentry->data_regions + snapshot,
+            size_t recv_size = __fenix_data_subset_data_size(mentry->data_regions + snapshot,
                   member_data.current_count);
             
             if(recv_size > 0){
+               //Parts this rank received while it was a spare aren't sent again.
+               void* held[2];
+               int needed = __imr_standby_check_recv(group, member_id, mentry->timestamp[snapshot],
+                     recv_size*member_data.datatype_size, held);
+
                void* recv_buf = malloc(member_data.datatype_size * recv_size);
                //first recieve their data, so store in the resiliency section.
-               MPI_Recv(recv_buf, recv_size*member_data.datatype_size, MPI_BYTE, group->partners[1],
-                     RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm, NULL);
-               __fenix_data_subset_deserialize(mentry->data_regions + snapshot, recv_buf,
-                        ((char*)mentry->data[snapshot]) + member_data.current_count*member_data.datatype_size,
+               void* part = held[0];
+               if(needed & 1){
+                  __fenix_mpi_recv_bytes(recv_buf, recv_size*member_data.datatype_size, group->partners[1],
+                        RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
+                  part = recv_buf;
+               }
+               __fenix_data_subset_deserialize(mentry->data_regions + snapshot, part,
+                        ((char*)mentry->data[snapshot]) + mentry->capacity*member_data.datatype_size,
                         member_data.current_count, member_data.datatype_size);
 
-               //first recieve their data, so store in the resiliency section.
-               MPI_Recv(recv_buf, recv_size*member_data.datatype_size, MPI_BYTE, group->partners[1],
-                     RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm, NULL);
-               __fenix_data_subset_deserialize(mentry->data_regions + snapshot, recv_buf,
+               //then my own data.
+               part = held[1];
+               if(needed & 2){
+                  __fenix_mpi_recv_bytes(recv_buf, recv_size*member_data.datatype_size, group->partners[1],
+                        RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->base.comm);
+                  part = recv_buf;
+               }
+               __fenix_data_subset_deserialize(mentry->data_regions + snapshot, part,
                         mentry->data[snapshot], member_data.current_count, member_data.datatype_size);
 
                free(recv_buf);
@@ -793,6 +2404,8 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
            //They also need the timestamps for each snapshot, as well as the value for the next.
            MPI_Send((void*)mentry->timestamp, group->num_snapshots+1, MPI_INT, recovering_node,
                  RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->set_comm);
+           MPI_Send((void*)mentry->counts, (group->num_snapshots+1)*sizeof(size_t), MPI_BYTE,
+                 recovering_node, RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->set_comm);
           
            for(int snapshot = 0; snapshot < group->num_snapshots; snapshot++){
               __fenix_data_subset_send(mentry->data_regions + snapshot, recovering_node, 
@@ -810,6 +2423,7 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
 
            __imr_find_mentry(group, member_id, &mentry);
            int member_data_index = __fenix_search_memberid(group->base.member, member_id);
+           group->base.member->member_entry[member_data_index].owns_datatype = packet.rebuilt_datatype;
            member_data = group->base.member->member_entry[member_data_index];
           
 
@@ -817,10 +2431,16 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
                  RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->set_comm, NULL);
 
            mentry->current_head = group->num_snapshots;
+           for(int snapshot = 0; snapshot <= group->num_snapshots; snapshot++){
+              __imr_alloc_snapshot(group, mentry, snapshot);
+           }
 
            //We also need to explicitly ask for all timestamps, since user may have deleted some and caused mischief.
            MPI_Recv((void*)(mentry->timestamp), group->num_snapshots + 1, MPI_INT, (my_set_rank==0 ? 1 : 0),
                  RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->set_comm, NULL);
+           MPI_Recv((void*)(mentry->counts), (group->num_snapshots + 1)*sizeof(size_t), MPI_BYTE,
+                 (my_set_rank==0 ? 1 : 0), RECOVER_MEMBER_ENTRY_TAG^group->base.groupid, group->set_comm, NULL);
+           __imr_ensure_snapshot_capacity(group, mentry, &member_data);
 
            for(int snapshot = 0; snapshot < group->num_snapshots; snapshot++){
               __fenix_data_subset_free(mentry->data_regions+snapshot);
@@ -832,15 +2452,15 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
          for(int snapshot = 0; snapshot < group->num_snapshots; snapshot++){
             //Similar to the process of doing a store, we're going to end up XORing with noisy data from
             //the recovering node, then XORing with it again to get what we actually want.
-            int parity_size = (member_data.datatype_size*member_data.current_count)/(group->set_size-1);
-            int remainder = (member_data.datatype_size*member_data.current_count)%(group->set_size-1);
+            size_t parity_size = (member_data.datatype_size*mentry->counts[snapshot])/(group->set_size-1);
+            size_t remainder = (member_data.datatype_size*mentry->counts[snapshot])%(group->set_size-1);
 
             if(remainder > 0) remainder++;
 
             void* data_buf = mentry->data[snapshot];
-            void* parity_buf = (void*)((char*)data_buf + member_data.datatype_size*member_data.current_count + 2);
+            void* parity_buf = (void*)((char*)data_buf + member_data.datatype_size*mentry->capacity + 2);
             
-            int offset = 0;
+            size_t offset = 0;
             for(int i = 0; i < group->set_size; i++){
                //Make sure to send the (out of order) parity info on the correct grouping
                void* toSend;
@@ -860,17 +2480,17 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
                 
                void* recv_buf = (i == my_set_rank ? parity_buf : (void*)((char*)data_buf + offset));
 
-               MPI_Reduce(toSend, recv_buf, parity_size + (1<remainder? 1:0), MPI_BYTE, MPI_BXOR, 
+               __fenix_mpi_reduce_bytes(toSend, recv_buf, parity_size + ((size_t)i<remainder? 1:0), MPI_BXOR, 
                    recovering_node, group->set_comm);
 
                if(my_set_rank == recovering_node){
                   //Remove the random data I had to send from the result.
-                  MPI_Reduce_local(toSend, recv_buf, parity_size + (i<remainder? 1:0),
-                      MPI_BYTE, MPI_BXOR);
+                  __fenix_mpi_reduce_local_bytes(toSend, recv_buf, parity_size + ((size_t)i<remainder? 1:0),
+                      MPI_BXOR);
                }
                
                if(i != my_set_rank){
-                  offset += parity_size + (i<remainder? 1:0); 
+                  offset += parity_size + ((size_t)i<remainder? 1:0); 
                }
             }
 
@@ -900,6 +2520,15 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
    
 
 
+   //Buffers rebuilt from redundancy need checksums for their new contents.
+   if(!found_member && recovery_locally_possible){
+      for(int snapshot = 0; snapshot < group->base.depth + 2; snapshot++){
+         if(mentry->data[snapshot] != NULL){
+            __imr_checksum_marked(mentry, mentry->data[snapshot], NULL);
+         }
+      }
+   }
+
    //Now that we've ensured everyone has data, restore from it.
    
    int return_found_data;
@@ -911,13 +2540,30 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
    }
    __fenix_data_subset_init(1, data_found);
    
-   //Don't try to restore if we weren't able to get the relevant data.
-   if(recovery_locally_possible && target_buffer != NULL){
+   if(partner_only){
+      data_found->specifier = __FENIX_SUBSET_EMPTY;
+      int exchanged = __imr_partner_only_exchange(group, mentry, &member_data,
+            holds_partner_data, time_stamp, target_buffer, data_found);
+
+      if(retval != FENIX_ERROR_INVALID_MEMBERID){
+         if(exchanged != FENIX_SUCCESS){
+            retval = exchanged;
+         } else if(data_found->specifier != __FENIX_SUBSET_EMPTY &&
+               __fenix_data_subset_is_full(data_found, member_data.current_count)){
+            retval = FENIX_SUCCESS;
+         } else {
+            retval = FENIX_WARNING_PARTIAL_RESTORE;
+         }
+      }
+   } else if(recovery_locally_possible && target_buffer != NULL){
+      //Don't try to restore if we weren't able to get the relevant data.
       data_found->specifier = __FENIX_SUBSET_EMPTY;
       
       int oldest_snapshot;
       for(oldest_snapshot = (mentry->current_head - 1); oldest_snapshot >= 0; oldest_snapshot--){
          __fenix_data_subset_merge_inplace(data_found, mentry->data_regions + oldest_snapshot);
+         //Snapshots from before a shrink may reach past the current count.
+         __fenix_data_subset_clip(data_found, member_data.current_count);
  
          if(__fenix_data_subset_is_full(data_found, member_data.current_count)){
             //The snapshots have formed a full set of data, not need to add older snapshots.
@@ -929,16 +2575,32 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
       if(oldest_snapshot == -1){
          oldest_snapshot = 0;
       }
- 
+
+      //Never hand back data which changed since it was stored.
+      size_t bad_blocks = 0;
       for(int i = oldest_snapshot; i < mentry->current_head; i++){
-         __fenix_data_subset_copy_data(&mentry->data_regions[i], target_buffer,
-               mentry->data[i], member_data.datatype_size, member_data.current_count);
+         bad_blocks += __imr_verify_region(mentry, mentry->data[i], &mentry->data_regions[i],
+               member_data.datatype_size);
       }
-
-      if(__fenix_data_subset_is_full(data_found, member_data.current_count)){
-        retval = FENIX_SUCCESS;
+ 
+      if(bad_blocks > 0){
+         debug_print("ERROR Fenix_Data_member_restore: member_id <%d> has %zu corrupted block(s) on rank <%d>\n",
+               member_id, bad_blocks, group->base.current_rank);
+         __fenix_data_subset_free(data_found);
+         __fenix_data_subset_init(1, data_found);
+         data_found->specifier = __FENIX_SUBSET_EMPTY;
+         retval = FENIX_ERROR_CORRUPTED_DATA;
       } else {
-        retval = FENIX_WARNING_PARTIAL_RESTORE;
+         for(int i = oldest_snapshot; i < mentry->current_head; i++){
+            __fenix_data_subset_copy_to_user(&mentry->data_regions[i], target_buffer,
+                  mentry->data[i], &(member_data.layout), member_data.current_count);
+         }
+
+         if(__fenix_data_subset_is_full(data_found, member_data.current_count)){
+           retval = FENIX_SUCCESS;
+         } else {
+           retval = FENIX_WARNING_PARTIAL_RESTORE;
+         }
       }
    } else {
       data_found->specifier = __FENIX_SUBSET_EMPTY;   
@@ -949,13 +2611,27 @@ int __imr_member_restore(fenix_group_t* g, int member_id,
       free(data_found);
    }
 
-   //Dont forget to clear the commit buffer
-   mentry->data_regions[mentry->current_head].specifier = __FENIX_SUBSET_EMPTY;
+   //Dont forget to clear the commit buffer, unless an icommit still waiting
+   //on its agreement is about to commit it.
+   if(!group->base.commit_pending){
+      mentry->data_regions[mentry->current_head].specifier = __FENIX_SUBSET_EMPTY;
+   }
 
+   //Copies received as a spare aren't needed once the member is back.
+   __fenix_standby_drop(group->base.groupid, member_id);
 
    return retval;
 }
 
+//Restores without a target rebuild the lost copies and leave the app's data
+//alone. A partner-only group's lost copy came from its owner's user buffer,
+//which only a store or the owner's own restore can send again.
+int __imr_member_reprotect(fenix_group_t* g, int member_id){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+   if(group->raid_mode == FENIX_DATA_POLICY_IMR_PARTNER_ONLY) return FENIX_SUCCESS;
+   return __imr_member_restore(g, member_id, NULL, 0, FENIX_TIME_STAMP_MAX, NULL);
+}
+
 
 int __imr_member_restore_from_rank(fenix_group_t* group, int member_id,
         void* target_buffer, int max_count, int time_stamp, 
@@ -967,13 +2643,153 @@ int __imr_member_get_attribute(fenix_group_t* group, fenix_member_entry_t* membe
 
 int __imr_member_set_attribute(fenix_group_t* g, fenix_member_entry_t* member, 
            int attributename, void* attributevalue, int* flag){ 
-  //No mutable attributes (as of now) require any changes to this policy's info
+  fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+  fenix_imr_mentry_t* mentry;
+  if(__imr_find_mentry(group, member->memberid, &mentry) != FENIX_SUCCESS){
+    return FENIX_SUCCESS;
+  }
+  int done;
+  __imr_exchange_finish(group, mentry, 1, &done);
+
+  //Only the count changes our buffers.
+  if(attributename == FENIX_DATA_MEMBER_ATTRIBUTE_COUNT){
+    __imr_member_resize(group, mentry, member, *((int *)attributevalue));
+  } else if(attributename == FENIX_DATA_MEMBER_ATTRIBUTE_COUNT_C){
+    __imr_member_resize(group, mentry, member, *((MPI_Count *)attributevalue));
+  } else if(attributename == FENIX_DATA_MEMBER_ATTRIBUTE_DEDUP_BLOCK){
+    int block = *((int *)attributevalue);
+    mentry->dedup_block = block > 0 ? block : 0;
+  } else if(attributename == FENIX_DATA_MEMBER_ATTRIBUTE_ERROR_BOUND){
+    double bound = *((double *)attributevalue);
+    int type = __imr_lossy_type(member->current_datatype);
+    if(!(bound >= 0) || isinf(bound) ||
+          (bound > 0 && (type == __FENIX_LOSSY_NONE || !__imr_is_raid1(group->raid_mode)))){
+      debug_print("ERROR Fenix_Data_member_attr_set: member_id <%d> can't have error bound %g\n",
+                  member->memberid, bound);
+      return FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+    }
+    mentry->error_bound = bound;
+    mentry->lossy = bound > 0 ? type : __FENIX_LOSSY_NONE;
+  } else if(attributename == FENIX_DATA_MEMBER_ATTRIBUTE_DATATYPE && mentry->error_bound > 0){
+    //Members changed to other types are stored exactly.
+    mentry->lossy = __imr_lossy_type(*((MPI_Datatype *)attributevalue));
+  }
   return FENIX_SUCCESS;
 }
 
+//Checks one snapshot of a RAID-1 member and repairs bad halves from the
+//partners' copies. Our own data is copied back from partners[1], the copy
+//we keep for partners[0] from its own data. Every rank takes part, even with
+//nothing to repair. Returns the number of halves which couldn't be repaired.
+int __imr_scrub_raid1(fenix_imr_group_t* group, fenix_imr_mentry_t* mentry, int snapshot,
+      int datatype_size, int* num_repaired){
+   char* buffer = (char*) mentry->data[snapshot];
+   size_t half = mentry->capacity*datatype_size;
+   int own_bad = __imr_verify_bytes(mentry, buffer, 0, half) > 0;
+   int partner_bad = __imr_verify_bytes(mentry, buffer, half, 2*half) > 0;
+   MPI_Comm comm = group->base.comm;
+   int tag = group->base.groupid;
+
+   //partners[0] may want its data back from our copy, partners[1] may want
+   //our data back from its copy.
+   int give_partner_half, give_own_half;
+   MPI_Sendrecv(&own_bad, 1, MPI_INT, group->partners[1], tag ^ SCRUB_STATUS_TAG,
+         &give_partner_half, 1, MPI_INT, group->partners[0], tag ^ SCRUB_STATUS_TAG,
+         comm, MPI_STATUS_IGNORE);
+   MPI_Sendrecv(&partner_bad, 1, MPI_INT, group->partners[0], tag ^ SCRUB_STATUS_TAG,
+         &give_own_half, 1, MPI_INT, group->partners[1], tag ^ SCRUB_STATUS_TAG,
+         comm, MPI_STATUS_IGNORE);
+
+   //Our own half first, a repaired own half can then serve partners[1].
+   int unrepaired = 0, repaired = 0;
+   int rounds[2][2] = {{give_partner_half, own_bad}, {give_own_half, partner_bad}};
+   for(int round = 0; round < 2; round++){
+      int giving = rounds[round][0], needing = rounds[round][1];
+      int give_to = round == 0 ? group->partners[0] : group->partners[1];
+      int need_from = round == 0 ? group->partners[1] : group->partners[0];
+      char* give_buf = round == 0 ? buffer + half : buffer;
+      char* need_buf = round == 0 ? buffer : buffer + half;
+
+      int give_ok = round == 0 ? !partner_bad : !own_bad, need_ok = 0;
+      MPI_Sendrecv(&give_ok, 1, MPI_INT, giving ? give_to : MPI_PROC_NULL, tag ^ SCRUB_STATUS_TAG,
+            &need_ok, 1, MPI_INT, needing ? need_from : MPI_PROC_NULL, tag ^ SCRUB_STATUS_TAG,
+            comm, MPI_STATUS_IGNORE);
+      giving = giving && give_ok;
+      needing = needing && need_ok;
+      __fenix_mpi_sendrecv_bytes(give_buf, giving ? half : 0, giving ? give_to : MPI_PROC_NULL,
+            tag ^ SCRUB_DATA_TAG, need_buf, needing ? half : 0,
+            needing ? need_from : MPI_PROC_NULL, tag ^ SCRUB_DATA_TAG, comm);
+
+      if(rounds[round][1]){
+         if(needing){
+            repaired++;
+            if(round == 0) own_bad = 0;
+         } else {
+            unrepaired++;
+         }
+      }
+   }
+
+   if(repaired > 0) __imr_checksum_marked(mentry, buffer, NULL);
+   *num_repaired += repaired;
+   return unrepaired;
+}
+
+//Checks the next committed snapshot of every member against its checksums.
+//RAID-1 repairs damage from the partner's copy. Partner-only and RAID-5
+//buffers can only be checked, their damage is reported.
+int __imr_scrub(fenix_group_t* g, int* num_repaired){
+   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
+   int unrepaired = 0;
+   *num_repaired = 0;
+   if(group->num_snapshots == 0) return FENIX_SUCCESS;
+
+   __imr_exchange_finish_all(group);
+   int snapshot = group->scrub_position % group->num_snapshots;
+   group->scrub_position = snapshot + 1;
+
+   for(int eid = 0; eid < group->entries_count; eid++){
+      fenix_imr_mentry_t* mentry = group->entries + eid;
+      int member_index = __fenix_search_memberid(group->base.member, mentry->memberid);
+      int datatype_size = group->base.member->member_entry[member_index].datatype_size;
+
+      if(group->raid_mode == 1){
+         unrepaired += __imr_scrub_raid1(group, mentry, snapshot, datatype_size, num_repaired);
+      } else if(__imr_verify_marked(mentry, mentry->data[snapshot], NULL) > 0){
+         unrepaired++;
+      }
+   }
+
+   if(fenix.options.verbose == 39 && (*num_repaired > 0 || unrepaired > 0)){
+      verbose_print("c-rank: %d, group: %d, snapshot: %d, repaired: %d, unrepaired: %d\n",
+                    group->base.current_rank, group->base.groupid,
+                    group->entries_count > 0 ? group->entries[0].timestamp[snapshot] : -1,
+                    *num_repaired, unrepaired);
+   }
+   return unrepaired > 0 ? FENIX_ERROR_CORRUPTED_DATA : FENIX_SUCCESS;
+}
+
 int __imr_reinit(fenix_group_t* g, int* flag){
   fenix_imr_group_t* group = (fenix_imr_group_t*)g;
 
+  //Windows and member communicators span the old communicator and cannot be
+  //freed collectively with a rank gone. They are abandoned, and the next store
+  //makes new ones.
+  for(int eid = 0; eid < group->entries_count; eid++){
+    group->entries[eid].window = MPI_WIN_NULL;
+    group->entries[eid].window_exposed = NULL;
+    group->entries[eid].window_stores = 0;
+    group->entries[eid].comm = MPI_COMM_NULL;
+    group->entries[eid].set_comm = MPI_COMM_NULL;
+    __imr_exchange_free(&(group->entries[eid].exchange), 0);
+    __imr_parity_free(group, group->entries + eid, NULL, 0);
+
+    //Recovery may give up what was stored since the last commit, so the next
+    //store of each member stores all of it.
+    int member_index = __fenix_search_memberid(g->member, group->entries[eid].memberid);
+    if(member_index != -1) __fenix_dirty_forget(g->member->member_entry[member_index].dirty);
+  }
+
   if(group->raid_mode == 5){
     //Rebuild the set comm to re-include the failed node(s).
     MPI_Group comm_group, set_group;
@@ -1005,7 +2821,7 @@ int __imr_group_delete(fenix_group_t* g){
    fenix_imr_group_t* group = (fenix_imr_group_t*) g;
 
    for(int entry = 0; entry < group->base.member->count; entry++){
-     __imr_member_free(group->entries+entry, g->depth); 
+     __imr_member_free(group, group->entries+entry);
    }
    free(group->entries);
 
@@ -57,13 +57,207 @@
 
 
 #include "fenix_data_recovery.h"
+#include "fenix_data_request.h"
 #include "fenix_data_policy.h"
 #include "fenix_opt.h"
 //#include "fenix_process_recovery.h"
 #include "fenix_util.h"
 #include "fenix_ext.h"
+#include "fenix_standby.h"
+#include "fenix_warning.h"
+#include "fenix-config.h"
 
 #include <mpi-ext.h>
+#include <math.h>
+#include <pthread.h>
+
+//With MPI_THREAD_MULTIPLE the data API may be entered from several threads.
+//Calls that only look up groups and members share the registry lock, calls
+//that add, remove or rearrange them take it exclusively. Work on one member
+//is serialized by the member's own lock, so threads storing different
+//members don't wait on each other.
+static pthread_rwlock_t __fenix_data_registry = PTHREAD_RWLOCK_INITIALIZER;
+
+//What the calling thread holds, so that a failure jumping out of a data call
+//doesn't leave the registry locked for good.
+static _Thread_local int __fenix_data_held_registry = 0;
+static _Thread_local pthread_mutex_t *__fenix_data_held_member = NULL;
+
+/**
+ * @brief           Enters the data API, shared for lookups and exclusive for
+ *                  calls that change the registry. Does nothing unless MPI
+ *                  provides MPI_THREAD_MULTIPLE.
+ * @param exclusive
+ */
+void __fenix_data_lock(int exclusive) {
+  if (!fenix.thread_multiple) return;
+  if (exclusive) {
+    pthread_rwlock_wrlock(&__fenix_data_registry);
+  } else {
+    pthread_rwlock_rdlock(&__fenix_data_registry);
+  }
+  __fenix_data_held_registry = 1;
+}
+
+/**
+ * @brief           Leaves the data API.
+ */
+void __fenix_data_unlock() {
+  if (!__fenix_data_held_registry) return;
+  __fenix_data_held_registry = 0;
+  pthread_rwlock_unlock(&__fenix_data_registry);
+}
+
+/**
+ * @brief           Serializes the calling thread's work on a member with other
+ *                  threads'. Taken inside the registry lock, which keeps the
+ *                  member from going away.
+ * @param group
+ * @param memberid
+ */
+void __fenix_data_member_lock(fenix_group_t *group, int memberid) {
+  if (!fenix.thread_multiple) return;
+  int member_index = __fenix_search_memberid(group->member, memberid);
+  if (member_index == -1) return;
+  __fenix_data_held_member = group->member->member_entry[member_index].lock;
+  pthread_mutex_lock(__fenix_data_held_member);
+}
+
+/**
+ * @brief           Releases the member taken by __fenix_data_member_lock.
+ */
+void __fenix_data_member_unlock() {
+  if (__fenix_data_held_member == NULL) return;
+  pthread_mutex_unlock(__fenix_data_held_member);
+  __fenix_data_held_member = NULL;
+}
+
+/**
+ * @brief           Releases whatever the calling thread holds, for a failure
+ *                  that jumped out of a data call before it could.
+ */
+void __fenix_data_release_held() {
+  __fenix_data_member_unlock();
+  __fenix_data_unlock();
+}
+
+/**
+ * @brief           Adds to the time the group spent storing since its last commit.
+ * @param group
+ * @param seconds
+ */
+static void __fenix_group_add_store_time(fenix_group_t *group, double seconds) {
+  pthread_mutex_lock(&(group->stats_lock));
+  group->store_time += seconds;
+  pthread_mutex_unlock(&(group->stats_lock));
+}
+
+/**
+ * @brief           After a repair, lists the members some rank of the group
+ *                  lost, so that commits rebuild their redundancy even if the
+ *                  app never restores them. Survivors all hold every member,
+ *                  so the list is taken from one of them.
+ * @param group
+ */
+static void __fenix_data_reprotect_plan(fenix_group_t *group) {
+  free(group->reprotect_ids);
+  free(group->reprotect_bytes);
+  group->reprotect_ids = NULL;
+  group->reprotect_bytes = NULL;
+  group->reprotect_count = 0;
+
+  int count = group->member->count;
+  int least;
+  struct { int count; int rank; } mine = { count, group->current_rank }, most;
+  MPI_Allreduce(&count, &least, 1, MPI_INT, MPI_MIN, group->comm);
+  MPI_Allreduce(&mine, &most, 1, MPI_2INT, MPI_MAXLOC, group->comm);
+  if (least == most.count) return;
+
+  group->reprotect_count = most.count;
+  group->reprotect_ids = (int *) s_malloc(most.count * sizeof(int));
+  group->reprotect_bytes = (size_t *) s_malloc(most.count * sizeof(size_t));
+  if (group->current_rank == most.rank) {
+    fenix_member_t *member = group->member;
+    int n = 0;
+    for (size_t i = 0; i < member->total_size && n < most.count; i++) {
+      fenix_member_entry_t *mentry = member->member_entry + i;
+      if (mentry->state == EMPTY || mentry->state == DELETED) continue;
+      group->reprotect_ids[n] = mentry->memberid;
+      group->reprotect_bytes[n++] = mentry->current_count * mentry->datatype_size;
+    }
+  }
+  MPI_Bcast(group->reprotect_ids, most.count, MPI_INT, most.rank, group->comm);
+  MPI_Bcast(group->reprotect_bytes, most.count * sizeof(size_t), MPI_BYTE, most.rank,
+            group->comm);
+
+  if (fenix.options.verbose == 55) {
+    verbose_print("c-rank: %d, groupid: %d, members to re-protect: %d\n",
+                    __fenix_get_current_rank(fenix.new_world), group->groupid,
+                  group->reprotect_count);
+  }
+}
+
+/**
+ * @brief           Rebuilds the redundancy of the next members left by a
+ *                  repair, as many as fit in fenix.reprotect_bytes but at
+ *                  least one. Every rank of the group commits, so every rank
+ *                  rebuilds the same members. The ranks agree on whether each
+ *                  one was rebuilt, and stop at the first that wasn't on any
+ *                  of them: it stays at the head of the list for the next try.
+ * @param group
+ * @return          FENIX_SUCCESS, or the same error on every rank.
+ */
+static int __fenix_data_reprotect_step(fenix_group_t *group) {
+  size_t bytes = 0;
+  int done = 0, retval = FENIX_SUCCESS;
+  while (done < group->reprotect_count &&
+         (done == 0 || bytes + group->reprotect_bytes[done] <= fenix.reprotect_bytes)) {
+    int ret = group->vtbl.member_reprotect(group, group->reprotect_ids[done]);
+    int error = ret == FENIX_SUCCESS || ret == FENIX_WARNING_PARTIAL_RESTORE ? 0
+              : ret < 0 ? ret : FENIX_ERROR_INTERN;
+    int agreed = MPI_Allreduce(&error, &retval, 1, MPI_INT, MPI_MIN, group->comm);
+    if (agreed != MPI_SUCCESS) return agreed;
+    if (retval != FENIX_SUCCESS) {
+      debug_print("ERROR Fenix_Data_commit: re-protecting member_id <%d> of group_id <%d> failed with <%d>\n",
+                  group->reprotect_ids[done], group->groupid, retval);
+      break;
+    }
+    bytes += group->reprotect_bytes[done];
+    done++;
+  }
+  if (done == 0) return retval;
+
+  group->reprotect_count -= done;
+  memmove(group->reprotect_ids, group->reprotect_ids + done,
+          group->reprotect_count * sizeof(int));
+  memmove(group->reprotect_bytes, group->reprotect_bytes + done,
+          group->reprotect_count * sizeof(size_t));
+
+  if (fenix.options.verbose == 55 && group->reprotect_count == 0) {
+    verbose_print("c-rank: %d, groupid: %d, fully protected again\n",
+                    __fenix_get_current_rank(fenix.new_world), group->groupid);
+  }
+  return retval;
+}
+
+/**
+ * @brief           Takes a member the app restored or deleted itself off the
+ *                  list of members to re-protect.
+ * @param group
+ * @param memberid
+ */
+void __fenix_data_reprotect_drop(fenix_group_t *group, int memberid) {
+  for (int i = 0; i < group->reprotect_count; i++) {
+    if (group->reprotect_ids[i] != memberid) continue;
+
+    group->reprotect_count--;
+    memmove(group->reprotect_ids + i, group->reprotect_ids + i + 1,
+            (group->reprotect_count - i) * sizeof(int));
+    memmove(group->reprotect_bytes + i, group->reprotect_bytes + i + 1,
+            (group->reprotect_count - i) * sizeof(size_t));
+    return;
+  }
+}
 
 /**
  * @brief           create new group or recover group data for lost processes
@@ -134,6 +328,22 @@ int __fenix_group_create( int groupid, MPI_Comm comm, int timestart, int depth,
       group->member = __fenix_data_member_init();
       group->comm = comm;
       MPI_Comm_rank(comm, &(group->current_rank));
+      group->store_time = 0;
+      pthread_mutex_init(&(group->stats_lock), NULL);
+      group->commit_pending = 0;
+      group->commit_op.posted = 0;
+      pthread_mutex_init(&(group->commit_lock), NULL);
+      group->ckpt_cost = 0;
+      group->last_commit = MPI_Wtime();
+      group->memory_budget = fenix.memory_budget;
+      group->memory_usage = 0;
+      group->memory_high_water = 0;
+      group->retention_policy = FENIX_DATA_RETENTION_SLIDING;
+      group->retention_keep = 1;
+      group->retention_interval = 1;
+      group->reprotect_ids = NULL;
+      group->reprotect_bytes = NULL;
+      group->reprotect_count = 0;
 
 
       //Update the count AFTER finding next group position.
@@ -153,11 +363,20 @@ int __fenix_group_create( int groupid, MPI_Comm comm, int timestart, int depth,
       group->comm = comm; /* Renew communicator */
       MPI_Comm_rank(comm, &(group->current_rank));
 
+      //An icommit's agreement was on the old communicator and can't complete.
+      //The commit is dropped, its snapshot was never the restore target.
+      __fenix_progress_abandon(&(group->commit_op));
+      group->commit_pending = 0;
+
 
       //Reinit group metadata as needed w/ new communicator.
       group->vtbl.reinit(group, flag);
     }
 
+    if (fenix.role != FENIX_ROLE_INITIAL_RANK && fenix.reprotect_bytes > 0) {
+      __fenix_data_reprotect_plan(group);
+    }
+
 
     /* Global agreement among the group */
     retval = FENIX_SUCCESS;
@@ -190,7 +409,7 @@ int __fenix_group_get_redundancy_policy(int groupid, int* policy_name, int* poli
  * @param count
  * @param data_type
  */
-int __fenix_member_create(int groupid, int memberid, void *data, int count, MPI_Datatype datatype ) {
+int __fenix_member_create(int groupid, int memberid, void *data, size_t count, MPI_Datatype datatype ) {
 
   int retval = -1;
   int group_index = __fenix_search_groupid( groupid, fenix.data_recovery );
@@ -215,6 +434,7 @@ int __fenix_member_create(int groupid, int memberid, void *data, int count, MPI_
   } else {
 
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
     fenix_member_t *member = group->member;
 
     //First, we'll make a fenix-core member entry, then pass that info to
@@ -232,51 +452,6 @@ int __fenix_member_create(int groupid, int memberid, void *data, int count, MPI_
 }
 
 
-/**
- * @brief
- * @param request
- */
-int __fenix_data_wait( Fenix_Request request ) {
-  int retval = -1;
-  int result = __fenix_mpi_wait(&(request.mpi_recv_req));
-
-  if (result != MPI_SUCCESS) {
-    retval = FENIX_SUCCESS;
-  } else {
-    retval = FENIX_ERROR_DATA_WAIT;
-  }
-
-  result = __fenix_mpi_wait(&(request.mpi_send_req));
-
-  if (result != MPI_SUCCESS) {
-    retval = FENIX_SUCCESS;
-  } else {
-    retval = FENIX_ERROR_DATA_WAIT;
-  }
-
-  return retval;
-}
-
-/**
- * @brief
- * @param request
- * @param flag
- */
-int __fenix_data_test(Fenix_Request request, int *flag) {
-  int retval = -1;
-  int result = ( __fenix_mpi_test(&(request.mpi_recv_req)) & __fenix_mpi_test(&(request.mpi_send_req))) ;
-
-  if ( result == 1 ) {
-    *flag = 1;
-    retval = FENIX_SUCCESS;
-  } else {
-    *flag = 0 ; // incomplete error?
-    retval = FENIX_ERROR_DATA_WAIT;
-  }
-  return retval;
-  /* Good 2/10/17 */
-}
-
 /**
  * @brief // TODO: implement FENIX_DATA_MEMBER_ALL
  * @param group_id
@@ -311,7 +486,56 @@ int __fenix_member_store(int groupid, int memberid, Fenix_Data_subset specifier)
     retval = FENIX_ERROR_INVALID_MEMBERID;
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    double start = MPI_Wtime();
+    __fenix_data_member_lock(group, memberid);
     retval = group->vtbl.member_store(group, memberid, specifier);
+    __fenix_data_member_unlock();
+    __fenix_group_add_store_time(group, MPI_Wtime() - start);
+  }
+  return retval;
+}
+
+/**
+ * @brief           Stores all of a member from *buffer, which the group's
+ *                  policy keeps as the snapshot where it can, and sets
+ *                  *buffer to a buffer for the app to fill next.
+ * @param groupid
+ * @param memberid
+ * @param buffer
+ */
+int __fenix_member_store_swap(int groupid, int memberid, void **buffer) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  int member_index = -1;
+
+  if (group_index != -1) {
+    member_index = __fenix_search_memberid(fenix.data_recovery->group[group_index]->member, memberid );
+  }
+
+  if (fenix.options.verbose == 18 && group_index != -1 &&
+      fenix.data_recovery->group[group_index]->current_rank == 0 ) {
+    verbose_print(
+            "c-rank: %d, role: %d, group_index: %d, member_index: %d memberid: %d\n",
+              __fenix_get_current_rank(fenix.new_world), fenix.role, group_index,
+            member_index, memberid);
+  }
+
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_member_store_swap: group_id <%d> does not exist\n", groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else if (member_index == -1) {
+    debug_print("ERROR Fenix_Data_member_store_swap: member_id <%d> does not exist\n",
+                memberid);
+    retval = FENIX_ERROR_INVALID_MEMBERID;
+  } else {
+    fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    double start = MPI_Wtime();
+    __fenix_data_member_lock(group, memberid);
+    retval = group->vtbl.member_store_swap(group, memberid, buffer);
+    __fenix_data_member_unlock();
+    __fenix_group_add_store_time(group, MPI_Wtime() - start);
   }
   return retval;
 }
@@ -327,6 +551,7 @@ int __fenix_member_istore(int groupid, int memberid, Fenix_Data_subset specifier
                   Fenix_Request *request) {
 
   int retval = -1;
+  *request = FENIX_REQUEST_NULL;
   int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
   int member_index = -1;
 
@@ -351,7 +576,15 @@ int __fenix_member_istore(int groupid, int memberid, Fenix_Data_subset specifier
     retval = FENIX_ERROR_INVALID_MEMBERID;
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    double start = MPI_Wtime();
+    //The policy pushes the stages it leaves in flight onto the request.
+    *request = __fenix_request_create(groupid);
+    __fenix_data_member_lock(group, memberid);
     retval = group->vtbl.member_istore(group, memberid, specifier, request);
+    __fenix_data_member_unlock();
+    __fenix_request_finish_empty(request);
+    __fenix_group_add_store_time(group, MPI_Wtime() - start);
   }
   return retval;
 }
@@ -534,6 +767,19 @@ int __fenix_member_istorev(int group_id, int member_id, Fenix_Data_subset subset
 }
 #endif
 
+//Fold the stores since the last commit and the commit itself into the
+//group's measured checkpoint cost.
+static void __fenix_data_commit_timing(fenix_group_t *group, double commit_start) {
+  double now = MPI_Wtime();
+  double cost = group->store_time + (now - commit_start);
+
+  if (group->ckpt_cost == 0) group->ckpt_cost = cost;
+  else group->ckpt_cost += __FENIX_CKPT_COST_SMOOTHING * (cost - group->ckpt_cost);
+
+  group->store_time = 0;
+  group->last_commit = now;
+}
+
 /**
  * @brief
  * @param group_id
@@ -552,12 +798,16 @@ int __fenix_data_commit(int groupid, int *timestamp) {
     retval = FENIX_ERROR_INVALID_GROUPID;
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    retval = __fenix_data_reprotect_step(group);
+    if (retval != FENIX_SUCCESS) return retval;
+    double start = MPI_Wtime();
     
     group->vtbl.commit(group);
+    __fenix_data_commit_timing(group, start);
 
-    if (group->timestamp +1 -1) group->timestamp++;
-    else group->timestamp = group->timestart;
-    
+    //The policy keeps group->timestamp at its newest snapshot, as in
+    //commit_barrier.
     if (timestamp != NULL) {
       *timestamp = group->timestamp;
     }
@@ -584,12 +834,15 @@ int __fenix_data_commit_barrier(int groupid, int *timestamp) {
     retval = FENIX_ERROR_INVALID_GROUPID;
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    retval = __fenix_data_reprotect_step(group);
+    if (retval != FENIX_SUCCESS) return retval;
+    double start = MPI_Wtime();
    
 
     //We want to make sure there aren't any revocations and also do a barrier.
     //Start by disabling Fenix error handling so we don't generate any new revokations here.
-    int old_failure_handling = fenix.ignore_errs;
-    fenix.ignore_errs = 1;
+    int old_failure_handling = __fenix_set_ignore_errs(1);
 
     //We'll use comm_agree as a resilient barrier, which should also give time for
     //any revocations to propogate
@@ -600,11 +853,12 @@ int __fenix_data_commit_barrier(int groupid, int *timestamp) {
     int ret = MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, group->comm, 
                          &tmp_throwaway, &status);
 
-    fenix.ignore_errs = old_failure_handling;
+    __fenix_set_ignore_errs(old_failure_handling);
 
 
     if(ret != MPI_ERR_REVOKED){
         retval = group->vtbl.commit(group);
+        __fenix_data_commit_timing(group, start);
     }
     
 
@@ -627,6 +881,163 @@ int __fenix_data_commit_barrier(int groupid, int *timestamp) {
 }
 
 
+
+//Applies an icommit once its agreement has completed with result ret. A
+//failure it learned about is left in raise, to be handled once the group is
+//unlocked.
+static int __fenix_data_commit_apply(fenix_group_t *group, int ret, int *raise) {
+  int retval = ret == MPI_SUCCESS ? FENIX_SUCCESS : ret;
+  double start = MPI_Wtime();
+
+  if (group->commit_barrier) {
+    //As in commit_barrier, check for revocations the agreement let through.
+    int tmp_throwaway;
+    MPI_Status status;
+    int probed = MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, group->comm, &tmp_throwaway, &status);
+    if (ret == MPI_SUCCESS) ret = probed;
+
+    if (ret != MPI_ERR_REVOKED) {
+      retval = group->vtbl.commit(group);
+      __fenix_data_commit_timing(group, start);
+    }
+    if (ret != MPI_SUCCESS) retval = ret;
+  } else if (ret == MPI_SUCCESS) {
+    retval = group->vtbl.commit(group);
+    __fenix_data_commit_timing(group, start);
+  }
+
+  if (group->commit_timestamp != NULL) {
+    *(group->commit_timestamp) = group->timestamp;
+  }
+  *raise = ret;
+  return retval;
+}
+
+/**
+ * @brief           Completes the group's icommit, if it has one. Without wait
+ *                  this only checks, leaving flag unset while the agreement
+ *                  is under way.
+ * @param group
+ * @param wait
+ * @param flag
+ */
+int __fenix_data_commit_complete(fenix_group_t *group, int wait, int *flag) {
+  int retval = FENIX_SUCCESS;
+  int raise = MPI_SUCCESS;
+  *flag = 1;
+
+  //Failures are handled after unlocking, recovery doesn't come back here.
+  pthread_mutex_lock(&(group->commit_lock));
+  if (group->commit_pending) {
+    int old_failure_handling = __fenix_set_ignore_errs(1);
+    int ret = wait ? __fenix_progress_wait(&(group->commit_op))
+                   : __fenix_progress_test(&(group->commit_op), flag);
+    if (*flag) {
+      group->commit_pending = 0;
+      retval = __fenix_data_commit_apply(group, ret, &raise);
+    }
+    __fenix_set_ignore_errs(old_failure_handling);
+  }
+  pthread_mutex_unlock(&(group->commit_lock));
+
+  if (raise != MPI_SUCCESS) MPI_Comm_call_errhandler(group->comm, raise);
+  return retval;
+}
+
+/**
+ * @brief           Applies the group's icommit before anything that would
+ *                  change its snapshots.
+ * @param group
+ */
+int __fenix_data_commit_settle(fenix_group_t *group) {
+  int flag;
+  return __fenix_data_commit_complete(group, 1, &flag);
+}
+
+#ifdef FENIX_HAVE_MPIX_COMM_IAGREE
+//The single stage of an icommit's request.
+static int __fenix_data_commit_stage(fenix_group_t *group, fenix_request_stage_t *stage,
+                                     int wait, int *flag) {
+  return __fenix_data_commit_complete(group, wait, flag);
+}
+#endif
+
+/**
+ * @brief           Starts a commit that applies once every rank of the group
+ *                  has agreed to it, leaving the agreement to complete while
+ *                  the app computes.
+ * @param groupid
+ * @param timestamp  Set to the new snapshot's timestamp once the request completes
+ * @param request
+ * @param barrier    Check for revocations before applying, as commit_barrier does
+ */
+int __fenix_data_icommit(int groupid, int *timestamp, Fenix_Request *request, int barrier) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (fenix.options.verbose == 53) {
+    verbose_print("c-rank: %d, role: %d, group_index: %d, barrier: %d\n",
+                    __fenix_get_current_rank(fenix.new_world), fenix.role, group_index, barrier);
+  }
+
+  *request = FENIX_REQUEST_NULL;
+
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_icommit: group_id <%d> does not exist\n", groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+
+#ifdef FENIX_HAVE_MPIX_COMM_IAGREE
+    retval = __fenix_data_reprotect_step(group);
+    if (retval != FENIX_SUCCESS) return retval;
+    int old_failure_handling = __fenix_set_ignore_errs(__fenix_ignore_errs() || barrier);
+    group->commit_flag = 1;
+    MPIX_Comm_iagree(group->comm, &(group->commit_flag), &(group->commit_request));
+    __fenix_set_ignore_errs(old_failure_handling);
+
+    group->commit_barrier = barrier;
+    group->commit_timestamp = timestamp;
+    group->commit_pending = 1;
+    __fenix_progress_post(&(group->commit_op), &(group->commit_request), 1, group->comm);
+
+    *request = __fenix_request_create(groupid);
+    __fenix_request_push(*request, __fenix_data_commit_stage, __FENIX_REQUEST_GROUP, NULL);
+    retval = FENIX_SUCCESS;
+#else
+    //Without a non-blocking agreement the commit is made right away.
+    retval = barrier ? __fenix_data_commit_barrier(groupid, timestamp)
+                     : __fenix_data_commit(groupid, timestamp);
+#endif
+  }
+  return retval;
+}
+
+/**
+ * @brief           Waits for the group's outstanding stores and commits to
+ *                  complete, here and at the ranks holding their redundancy.
+ *                  Unlike commit_barrier this only involves those ranks.
+ * @param groupid
+ */
+int __fenix_data_barrier(int groupid) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (fenix.options.verbose == 54) {
+    verbose_print("c-rank: %d, role: %d, group_index: %d\n",
+                    __fenix_get_current_rank(fenix.new_world), fenix.role, group_index);
+  }
+
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_barrier: group_id <%d> does not exist\n", groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
+    retval = group->vtbl.barrier(group);
+  }
+  return retval;
+}
+
 /**
  * @brief
  * @param group_id
@@ -635,7 +1046,7 @@ int __fenix_data_commit_barrier(int groupid, int *timestamp) {
  * @param max_count
  * @param time_stamp
  */
-int __fenix_member_restore(int groupid, int memberid, void *data, int maxcount, int timestamp, Fenix_Data_subset* data_found) {
+int __fenix_member_restore(int groupid, int memberid, void *data, size_t maxcount, int timestamp, Fenix_Data_subset* data_found) {
 
   int retval =  FENIX_SUCCESS;
   int group_index = __fenix_search_groupid(groupid, fenix.data_recovery);
@@ -657,6 +1068,7 @@ int __fenix_member_restore(int groupid, int memberid, void *data, int maxcount,
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
     retval = group->vtbl.member_restore(group, memberid, data, maxcount, timestamp, data_found);
+    __fenix_data_reprotect_drop(group, memberid);
   }
   return retval;
 }
@@ -782,8 +1194,9 @@ int __fenix_get_snapshot_at_position(int groupid, int position, int *timestamp)
     debug_print("ERROR Fenix_Data_commit: group_id <%d> does not exist\n", groupid);
     retval = FENIX_ERROR_INVALID_GROUPID;
   } else {
+    //Snapshots need not be consecutive once retention has thinned them out.
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
-    *timestamp = group->timestamp - position;
+    retval = group->vtbl.get_snapshot_at_position(group, position, timestamp);
   }
   return retval;
 }
@@ -865,9 +1278,9 @@ int __fenix_member_set_attribute(int groupid, int memberid, int attributename,
                 memberid);
     retval = FENIX_ERROR_INVALID_MEMBERID;
   } else {
-    int my_datatype_size;
     int myerr;
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
     fenix_member_t *member = group->member;
     fenix_member_entry_t *mentry = &(member->member_entry[member_index]);
 
@@ -885,25 +1298,27 @@ int __fenix_member_set_attribute(int groupid, int memberid, int attributename,
         mentry->current_count = *((int *) (attributevalue));
         retval = FENIX_SUCCESS;
         break;
+      case FENIX_DATA_MEMBER_ATTRIBUTE_COUNT_C:
+        mentry->current_count = *((MPI_Count *) (attributevalue));
+        retval = FENIX_SUCCESS;
+        break;
       case FENIX_DATA_MEMBER_ATTRIBUTE_DATATYPE:
 
-        myerr = MPI_Type_size(*((MPI_Datatype *)(attributevalue)), &my_datatype_size);
+        myerr = __fenix_data_member_set_datatype(mentry, *((MPI_Datatype *)(attributevalue)));
 
         if( myerr ) {
           debug_print(
                   "ERROR Fenix_Data_member_attr_get: Fenix currently does not support this MPI_DATATYPE; invalid attribute_value <%d>\n",
                   attributevalue);
           retval = FENIX_ERROR_INVALID_ATTRIBUTE_NAME;
+        } else {
+          retval = FENIX_SUCCESS;
         }
-
-        mentry->current_datatype = *((MPI_Datatype *)(attributevalue));
-        mentry->datatype_size = my_datatype_size;
-        retval = FENIX_SUCCESS;
         break;
       
       default:
         //Only an issue if the policy also doesn't have this attribute.
-        if(retval){
+        if(retval && retval != FENIX_ERROR_INVALID_ATTRIBUTE_VALUE){
           debug_print("ERROR Fenix_Data_member_attr_get: invalid attribute_name <%d>\n",
                       attributename);
           retval = FENIX_ERROR_INVALID_ATTRIBUTE_NAME;
@@ -933,11 +1348,405 @@ int __fenix_snapshot_delete(int group_id, int time_stamp) {
     retval = FENIX_ERROR_INVALID_TIMESTAMP;
   } else {
     fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+    __fenix_data_commit_settle(group);
     retval = group->vtbl.snapshot_delete(group, time_stamp);
   }
   return retval;
 }
 
+/**
+ * @brief          Advise whether now is a good time to checkpoint the group.
+ *                 Collective over the group's communicator.
+ * @param group_id
+ * @param flag     Set to 1 if the time since the last commit has reached the
+ *                 Young/Daly optimal interval, 0 otherwise.
+ */
+int __fenix_group_should_checkpoint(int groupid, int *flag) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_should_checkpoint: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix_group_t *group = (fenix.data_recovery->group[group_index]);
+
+    //Every rank has to give the same answer, so decide on the slowest
+    //rank's checkpoint cost and the longest time since a commit. A rank
+    //warned of its failure wants a checkpoint now.
+    double local[3] = { group->ckpt_cost, MPI_Wtime() - group->last_commit,
+                        (double) __fenix_warning_pending() };
+    double global[3];
+    retval = MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_MAX, group->comm);
+
+    if (retval == MPI_SUCCESS) {
+      double cost = global[0];
+      double elapsed = global[1];
+      double mtbf = __fenix_failure_stats_mtbf(&fenix.failure_stats);
+
+      double interval;
+      if (cost == 0) {
+        //Nothing measured yet, checkpoint to learn the cost.
+        interval = 0;
+      } else if (cost < 2 * mtbf) {
+        //Daly's higher order estimate of the optimal compute time between checkpoints.
+        interval = sqrt(2 * cost * mtbf) * (1 + sqrt(cost / (2 * mtbf)) / 3
+                   + cost / (18 * mtbf)) - cost;
+      } else {
+        interval = mtbf;
+      }
+
+      if (fenix.options.verbose == 26 && group->current_rank == 0) {
+        verbose_print("group: %d, cost: %f, mtbf: %f, interval: %f, elapsed: %f\n",
+                      groupid, cost, mtbf, interval, elapsed);
+      }
+
+      *flag = elapsed >= interval || global[2] != 0;
+      retval = FENIX_SUCCESS;
+    }
+  }
+  return retval;
+}
+
+/**
+ * @brief             Agrees on the members of a group that every rank has a
+ *                    buffer for. Ranks may hold different members, e.g. one
+ *                    recovered rank that hasn't recreated them all yet, so the
+ *                    union of every rank's member ids is gathered first and
+ *                    each id is then checked on every rank. Collective over
+ *                    the group.
+ * @param group
+ * @param memberids   Set to the union's ids, sorted, freed by the caller.
+ * @param buffered    Set to 1 for each id every rank has a buffer for, else 0.
+ *                    Freed by the caller.
+ * @param num_members Set to the number of ids in the union.
+ */
+static int __fenix_data_agree_buffered(fenix_group_t *group, int **memberids, int **buffered,
+                                       int *num_members) {
+  fenix_member_t *member = group->member;
+  *memberids = NULL;
+  *buffered = NULL;
+  *num_members = 0;
+
+  //Our ids go out after their count, padded to the longest list.
+  int local_count = 0;
+  for (size_t m = 0; m < member->total_size; m++) {
+    fenix_member_entry_t *mentry = &(member->member_entry[m]);
+    if (!(mentry->state == EMPTY || mentry->state == DELETED)) local_count++;
+  }
+  int max_count;
+  int ret = MPI_Allreduce(&local_count, &max_count, 1, MPI_INT, MPI_MAX, group->comm);
+  if (ret != MPI_SUCCESS || max_count == 0) return ret;
+
+  int comm_size;
+  MPI_Comm_size(group->comm, &comm_size);
+  int *local = (int *) s_calloc(max_count + 1, sizeof(int));
+  int *gathered = (int *) s_malloc((size_t)comm_size * (max_count + 1) * sizeof(int));
+  local[0] = local_count;
+  for (size_t m = 0, n = 1; m < member->total_size; m++) {
+    fenix_member_entry_t *mentry = &(member->member_entry[m]);
+    if (!(mentry->state == EMPTY || mentry->state == DELETED)) local[n++] = mentry->memberid;
+  }
+  ret = MPI_Allgather(local, max_count + 1, MPI_INT, gathered, max_count + 1, MPI_INT,
+                      group->comm);
+  free(local);
+  if (ret != MPI_SUCCESS) {
+    free(gathered);
+    return ret;
+  }
+
+  int *ids = (int *) s_malloc((size_t)comm_size * max_count * sizeof(int));
+  int num_ids = 0;
+  for (int r = 0; r < comm_size; r++) {
+    int *list = gathered + (size_t)r * (max_count + 1);
+    for (int m = 0; m < list[0]; m++) ids[num_ids++] = list[m + 1];
+  }
+  free(gathered);
+  qsort(ids, num_ids, sizeof(int), __fenix_comparator);
+  int num_unique = 0;
+  for (int m = 0; m < num_ids; m++) {
+    if (num_unique == 0 || ids[num_unique - 1] != ids[m]) ids[num_unique++] = ids[m];
+  }
+
+  int *flags = (int *) s_malloc(num_unique * sizeof(int));
+  for (int m = 0; m < num_unique; m++) {
+    int member_index = __fenix_search_memberid(member, ids[m]);
+    flags[m] = member_index != -1 && member->member_entry[member_index].user_data != NULL;
+  }
+  ret = MPI_Allreduce(MPI_IN_PLACE, flags, num_unique, MPI_INT, MPI_MIN, group->comm);
+  if (ret != MPI_SUCCESS) {
+    free(flags);
+    free(ids);
+    return ret;
+  }
+
+  *memberids = ids;
+  *buffered = flags;
+  *num_members = num_unique;
+  return MPI_SUCCESS;
+}
+
+/**
+ * @brief              A point where every member's buffer holds consistent
+ *                     data. If any rank has been warned of its failure since
+ *                     the last one, every group is stored in full and
+ *                     committed, ahead of the app's own schedule. Collective
+ *                     over the active ranks.
+ * @param checkpointed Set to 1 if the groups were checkpointed, 0 otherwise.
+ */
+int __fenix_data_safe_point(int *checkpointed) {
+  int warned = __fenix_warning_take();
+  int num_warned;
+  int retval = MPI_Allreduce(&warned, &num_warned, 1, MPI_INT, MPI_SUM, fenix.new_world);
+  if (retval != MPI_SUCCESS) return retval;
+
+  *checkpointed = num_warned > 0;
+  if (num_warned == 0) return FENIX_SUCCESS;
+
+  //With its spare holding its newest snapshots, the warned rank's failure
+  //costs neither the work since the app's last checkpoint nor a restore
+  //from its partner. Its copies still on their way go first, so that none of
+  //the checkpoint's is skipped.
+  int rebalance = warned && fenix.warning_rebalance && __fenix_standby_target() != -1;
+  if (fenix.options.verbose == 60 && warned) {
+    verbose_print("c-rank: %d, warned, checkpointing %zu groups, rebalance: %d\n",
+                  __fenix_get_current_rank(fenix.new_world), fenix.data_recovery->count,
+                  rebalance);
+  }
+  if (rebalance) __fenix_standby_flush();
+
+  //Groups may overlap, so every rank goes through them, and their members, in
+  //the same order.
+  size_t num_groups = fenix.data_recovery->count;
+  int *groupids = (int *) s_malloc(num_groups * sizeof(int));
+  for (size_t i = 0; i < num_groups; i++) {
+    groupids[i] = fenix.data_recovery->group[i]->groupid;
+  }
+  qsort(groupids, num_groups, sizeof(int), __fenix_comparator);
+
+  retval = FENIX_SUCCESS;
+  for (size_t i = 0; i < num_groups; i++) {
+    fenix_group_t *group = fenix.data_recovery->group[
+            __fenix_search_groupid(groupids[i], fenix.data_recovery)];
+
+    //Members that some rank has no buffer for, such as those a recovered rank
+    //hasn't restored yet, are left to the app.
+    int *memberids, *buffered, num_members;
+    int ret = __fenix_data_agree_buffered(group, &memberids, &buffered, &num_members);
+    if (ret != MPI_SUCCESS) {
+      free(groupids);
+      return ret;
+    }
+
+    for (int m = 0; m < num_members; m++) {
+      if (!buffered[m]) continue;
+      ret = __fenix_member_store(groupids[i], memberids[m], FENIX_DATA_SUBSET_FULL);
+      if (ret != FENIX_SUCCESS && retval == FENIX_SUCCESS) retval = ret;
+    }
+    free(buffered);
+    free(memberids);
+
+    ret = __fenix_data_commit(groupids[i], NULL);
+    if (ret != FENIX_SUCCESS && retval == FENIX_SUCCESS) retval = ret;
+  }
+  free(groupids);
+
+  if (rebalance) __fenix_standby_flush();
+  return retval;
+}
+
+/**
+ * @brief          Set the group's snapshot memory budget. Once over budget, the
+ *                 next commit drops the oldest snapshots instead of keeping the
+ *                 full depth.
+ * @param group_id
+ * @param budget   Bytes of snapshot storage per rank, 0 for no limit.
+ */
+int __fenix_group_set_memory_budget(int groupid, size_t budget) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_set_memory_budget: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix.data_recovery->group[group_index]->memory_budget = budget;
+    retval = FENIX_SUCCESS;
+  }
+  return retval;
+}
+
+/**
+ * @brief            Report the group's snapshot memory use on this rank.
+ * @param group_id
+ * @param usage      Bytes currently allocated, may be NULL.
+ * @param high_water Most bytes allocated at once so far, may be NULL.
+ */
+int __fenix_group_get_memory_usage(int groupid, size_t *usage, size_t *high_water) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_get_memory_usage: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix_group_t *group = fenix.data_recovery->group[group_index];
+    if (usage != NULL) *usage = group->memory_usage;
+    if (high_water != NULL) *high_water = group->memory_high_water;
+    retval = FENIX_SUCCESS;
+  }
+  return retval;
+}
+
+/**
+ * @brief             Report how many members still wait for their redundancy
+ *                    to be rebuilt after a repair. Zero once the group is
+ *                    fully protected again.
+ * @param group_id
+ * @param num_members
+ */
+int __fenix_group_get_reprotect_pending(int groupid, int *num_members) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_get_reprotect_pending: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    *num_members = fenix.data_recovery->group[group_index]->reprotect_count;
+    retval = FENIX_SUCCESS;
+  }
+  return retval;
+}
+
+/**
+ * @brief           Set which snapshot a commit gives up once the group is
+ *                  full. Must be called with the same values on every rank.
+ * @param group_id
+ * @param policy    One of FENIX_DATA_RETENTION_*.
+ * @param keep_last Number of newest snapshots which are always kept, at least 1.
+ * @param interval  Timestamp spacing kept by FENIX_DATA_RETENTION_EVERY_NTH.
+ */
+int __fenix_group_set_retention(int groupid, int policy, int keep_last, int interval) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_set_retention: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else if ((policy != FENIX_DATA_RETENTION_SLIDING &&
+              policy != FENIX_DATA_RETENTION_EVERY_NTH &&
+              policy != FENIX_DATA_RETENTION_EXPONENTIAL) ||
+             keep_last < 1 || interval < 1) {
+    debug_print("ERROR Fenix_Data_group_set_retention: invalid policy <%d>, keep_last <%d> or interval <%d>\n",
+                policy, keep_last, interval);
+    retval = FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+  } else {
+    fenix_group_t *group = fenix.data_recovery->group[group_index];
+    group->retention_policy = policy;
+    group->retention_keep = keep_last;
+    group->retention_interval = interval;
+    retval = FENIX_SUCCESS;
+  }
+  return retval;
+}
+
+/**
+ * @brief              Check the next snapshot of the group against its
+ *                     checksums and repair damage from redundancy where the
+ *                     policy can. Checks one snapshot per call, so it can be
+ *                     called whenever the application is idle. Collective
+ *                     over the group.
+ * @param group_id
+ * @param num_repaired Set to the number of damaged copies repaired, may be NULL.
+ * @return FENIX_ERROR_CORRUPTED_DATA if damage was found which couldn't be repaired.
+ */
+int __fenix_group_scrub(int groupid, int *num_repaired) {
+  int retval = -1;
+  int repaired = 0;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_group_scrub: group_id <%d> does not exist\n",
+                groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else {
+    fenix_group_t *group = fenix.data_recovery->group[group_index];
+    __fenix_data_commit_settle(group);
+    retval = group->vtbl.scrub(group, &repaired);
+  }
+  if (num_repaired != NULL) *num_repaired = repaired;
+  return retval;
+}
+
+/**
+ * @brief Declares a region of a member checked for silent data corruption on every store.
+ * @param groupid
+ * @param memberid
+ * @param kind FENIX_DATA_SDC_REPLICATED or FENIX_DATA_SDC_IMMUTABLE
+ * @param specifier the region, FENIX_DATA_SUBSET_EMPTY stops checking
+ */
+int __fenix_member_sdc_region(int groupid, int memberid, int kind, Fenix_Data_subset specifier) {
+  int retval = -1;
+  int group_index = __fenix_search_groupid(groupid, fenix.data_recovery );
+  int member_index = -1;
+  if (group_index != -1) {
+    member_index = __fenix_search_memberid(fenix.data_recovery->group[group_index]->member, memberid);
+  }
+
+  if (group_index == -1) {
+    debug_print("ERROR Fenix_Data_member_sdc_region: group_id <%d> does not exist\n", groupid);
+    retval = FENIX_ERROR_INVALID_GROUPID;
+  } else if (member_index == -1) {
+    debug_print("ERROR Fenix_Data_member_sdc_region: member_id <%d> does not exist\n",
+                memberid);
+    retval = FENIX_ERROR_INVALID_MEMBERID;
+  } else if (kind != FENIX_DATA_SDC_REPLICATED && kind != FENIX_DATA_SDC_IMMUTABLE) {
+    debug_print("ERROR Fenix_Data_member_sdc_region: kind <%d> is not supported\n", kind);
+    retval = FENIX_ERROR_INVALID_ATTRIBUTE_NAME;
+  } else {
+    fenix_member_entry_t *mentry =
+        &(fenix.data_recovery->group[group_index]->member->member_entry[member_index]);
+    Fenix_Data_subset *region = kind == FENIX_DATA_SDC_REPLICATED ?
+        &(mentry->sdc_replicated) : &(mentry->sdc_immutable);
+    __fenix_data_subset_free(region);
+    __fenix_data_subset_deep_copy(&specifier, region);
+    if (kind == FENIX_DATA_SDC_IMMUTABLE) mentry->sdc_has_reference = 0;
+    retval = FENIX_SUCCESS;
+  }
+  return retval;
+}
+
+/**
+ * @brief Sets the function told of silent data corruption found by a store.
+ * @param detected called with the group id, member id, region kind and callback_data
+ * @param callback_data
+ */
+int __fenix_sdc_callback_register(void (*detected)(int, int, int, void *), void *callback_data) {
+  if (fenix.fenix_init_flag) {
+    fenix.sdc_callback = detected;
+    fenix.sdc_callback_data = callback_data;
+    return FENIX_SUCCESS;
+  }
+  return FENIX_ERROR_UNINITIALIZED;
+}
+
+/**
+ * @brief Reports silent data corruption in a region of a member.
+ * @param groupid
+ * @param memberid
+ * @param kind
+ */
+void __fenix_sdc_report(int groupid, int memberid, int kind) {
+  if (fenix.options.verbose == 40) {
+    verbose_print("c-rank: %d, group: %d, member: %d, silent data corruption in %s region\n",
+                  __fenix_get_current_rank(fenix.new_world), groupid, memberid,
+                  kind == FENIX_DATA_SDC_REPLICATED ? "replicated" : "immutable");
+  }
+  if (fenix.sdc_callback != NULL) {
+    fenix.sdc_callback(groupid, memberid, kind, fenix.sdc_callback_data);
+  }
+}
+
 ///////////////////////////////////////////////////// TODO //
 
 void __fenix_store_single() {
@@ -0,0 +1,378 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix_data_request.h"
+#include "fenix_data_recovery.h"
+#include "fenix_util.h"
+#include "fenix_ext.h"
+#include <mpi.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+//The operation behind a Fenix_Request. Slots are reused once a request
+//completes, with a new generation, so that a handle the app kept past
+//completion finds its slot taken by someone else and is treated as null.
+typedef struct __fenix_request {
+    unsigned int generation;
+    int in_use;
+    int group_id;
+    int num_stages;
+    int stages_size;
+    int current;                  // First stage not yet completed
+    fenix_request_stage_t *stages;
+    int next_free;
+} fenix_request_t;
+
+//Slots are allocated one at a time and never move, only the table of them
+//grows, so a request can be advanced without holding the lock.
+static struct {
+    fenix_request_t **slots;
+    int size;
+    int count;
+    int free;                     // First released slot, or -1
+    pthread_mutex_t lock;
+} __fenix_requests = { NULL, 0, 0, -1, PTHREAD_MUTEX_INITIALIZER };
+
+static fenix_request_t *__fenix_request_lookup(Fenix_Request request)
+{
+    fenix_request_t *req = NULL;
+    pthread_mutex_lock(&__fenix_requests.lock);
+    if (request.slot >= 0 && request.slot < __fenix_requests.count) {
+        req = __fenix_requests.slots[request.slot];
+        if (!req->in_use || req->generation != request.generation) req = NULL;
+    }
+    pthread_mutex_unlock(&__fenix_requests.lock);
+    return req;
+}
+
+static void __fenix_request_release(Fenix_Request *request)
+{
+    pthread_mutex_lock(&__fenix_requests.lock);
+    fenix_request_t *req = __fenix_requests.slots[request->slot];
+    req->in_use = 0;
+    req->generation++;
+    req->num_stages = 0;
+    req->current = 0;
+    req->next_free = __fenix_requests.free;
+    __fenix_requests.free = request->slot;
+    pthread_mutex_unlock(&__fenix_requests.lock);
+
+    *request = FENIX_REQUEST_NULL;
+}
+
+//Runs the request's stages from the first one not yet completed, stopping at
+//one still under way. A group deleted meanwhile took whatever it had in
+//flight with it, so its requests are complete.
+static int __fenix_request_advance(fenix_request_t *req, int wait, int *flag)
+{
+    int retval = FENIX_SUCCESS;
+    *flag = 1;
+
+    int group_index = __fenix_search_groupid(req->group_id, fenix.data_recovery);
+    if (group_index == -1) return FENIX_SUCCESS;
+    fenix_group_t *group = fenix.data_recovery->group[group_index];
+
+    while (req->current < req->num_stages && retval == FENIX_SUCCESS) {
+        fenix_request_stage_t *stage = req->stages + req->current;
+        if (stage->member_id != __FENIX_REQUEST_GROUP) {
+            __fenix_data_member_lock(group, stage->member_id);
+        }
+        retval = stage->advance(group, stage, wait, flag);
+        __fenix_data_member_unlock();
+
+        if (!*flag) return FENIX_SUCCESS;
+        req->current++;
+    }
+    return retval;
+}
+
+/**
+ * @brief Starts a request on a group, with no stages yet.
+ * @param group_id
+ */
+Fenix_Request __fenix_request_create(int group_id)
+{
+    Fenix_Request request;
+
+    pthread_mutex_lock(&__fenix_requests.lock);
+    if (__fenix_requests.free != -1) {
+        request.slot = __fenix_requests.free;
+        __fenix_requests.free = __fenix_requests.slots[request.slot]->next_free;
+    } else {
+        if (__fenix_requests.count == __fenix_requests.size) {
+            __fenix_requests.size = __fenix_requests.size == 0 ? 16 : 2 * __fenix_requests.size;
+            __fenix_requests.slots = (fenix_request_t **) s_realloc(__fenix_requests.slots,
+                    __fenix_requests.size * sizeof(fenix_request_t *));
+        }
+        request.slot = __fenix_requests.count++;
+        __fenix_requests.slots[request.slot] = (fenix_request_t *) s_calloc(1, sizeof(fenix_request_t));
+    }
+
+    fenix_request_t *req = __fenix_requests.slots[request.slot];
+    req->in_use = 1;
+    req->group_id = group_id;
+    request.generation = req->generation;
+    pthread_mutex_unlock(&__fenix_requests.lock);
+
+    return request;
+}
+
+/**
+ * @brief Appends a stage to a request, to run once the stages before it
+ *        have completed.
+ * @param request
+ * @param advance
+ * @param member_id  Member locked while the stage advances, or __FENIX_REQUEST_GROUP
+ * @param data
+ */
+void __fenix_request_push(Fenix_Request request, fenix_request_advance_t advance,
+                          int member_id, void *data)
+{
+    fenix_request_t *req = __fenix_request_lookup(request);
+    if (req == NULL) return;
+
+    if (req->num_stages == req->stages_size) {
+        req->stages_size = req->stages_size == 0 ? 2 : 2 * req->stages_size;
+        req->stages = (fenix_request_stage_t *) s_realloc(req->stages,
+                req->stages_size * sizeof(fenix_request_stage_t));
+    }
+    fenix_request_stage_t *stage = req->stages + req->num_stages++;
+    stage->advance = advance;
+    stage->member_id = member_id;
+    stage->data = data;
+}
+
+/**
+ * @brief Whether a handle refers to no request, e.g. one already completed.
+ * @param request
+ */
+int __fenix_request_is_null(Fenix_Request request)
+{
+    return request.slot < 0;
+}
+
+/**
+ * @brief Releases a request that was given no stages, since the operation
+ *        completed before returning, leaving the handle null.
+ * @param request
+ */
+void __fenix_request_finish_empty(Fenix_Request *request)
+{
+    fenix_request_t *req = __fenix_request_lookup(*request);
+    if (req != NULL && req->num_stages == 0) __fenix_request_release(request);
+}
+
+/**
+ * @brief Frees every request, at finalization.
+ */
+void __fenix_request_finalize()
+{
+    pthread_mutex_lock(&__fenix_requests.lock);
+    for (int i = 0; i < __fenix_requests.count; i++) {
+        free(__fenix_requests.slots[i]->stages);
+        free(__fenix_requests.slots[i]);
+    }
+    free(__fenix_requests.slots);
+    __fenix_requests.slots = NULL;
+    __fenix_requests.size = 0;
+    __fenix_requests.count = 0;
+    __fenix_requests.free = -1;
+    pthread_mutex_unlock(&__fenix_requests.lock);
+}
+
+/**
+ * @brief Blocks until a request has completed all of its stages.
+ * @param request
+ */
+int __fenix_data_wait(Fenix_Request request)
+{
+    fenix_request_t *req = __fenix_request_lookup(request);
+    if (req == NULL) return FENIX_SUCCESS;
+
+    int flag;
+    int retval = __fenix_request_advance(req, 1, &flag);
+    __fenix_request_release(&request);
+    return retval;
+}
+
+/**
+ * @brief Advances a request as far as it goes without blocking. Returns
+ *        FENIX_ERROR_DATA_WAIT, with flag unset, while it is incomplete.
+ * @param request
+ * @param flag
+ */
+int __fenix_data_test(Fenix_Request request, int *flag)
+{
+    fenix_request_t *req = __fenix_request_lookup(request);
+    *flag = 1;
+    if (req == NULL) return FENIX_SUCCESS;
+
+    int retval = __fenix_request_advance(req, 0, flag);
+    if (!*flag) return FENIX_ERROR_DATA_WAIT;
+
+    __fenix_request_release(&request);
+    return retval;
+}
+
+//Tests requests[index], nulling it once it completes. Returns the request's
+//error, if it completed with one.
+static int __fenix_data_test_at(Fenix_Request *requests, int index, int *flag)
+{
+    fenix_request_t *req = __fenix_request_lookup(requests[index]);
+    *flag = 1;
+    if (req == NULL) {
+        requests[index] = FENIX_REQUEST_NULL;
+        return FENIX_SUCCESS;
+    }
+
+    int retval = __fenix_request_advance(req, 0, flag);
+    if (*flag) __fenix_request_release(requests + index);
+    return *flag ? retval : FENIX_SUCCESS;
+}
+
+/**
+ * @brief Blocks until every request has completed, leaving their handles
+ *        null. Returns the first error a request completed with.
+ * @param count
+ * @param requests
+ */
+int __fenix_data_waitall(int count, Fenix_Request *requests)
+{
+    int retval = FENIX_SUCCESS;
+    int remaining = 0;
+    for (int i = 0; i < count; i++) remaining += !__fenix_request_is_null(requests[i]);
+
+    //Sweep over the requests, so that each one moves on to its next stage as
+    //soon as the last one is done rather than when the requests before it
+    //have completed, and only block once a single one is left.
+    while (remaining > 1) {
+        for (int i = 0; i < count; i++) {
+            if (__fenix_request_is_null(requests[i])) continue;
+
+            int flag;
+            int ret = __fenix_data_test_at(requests, i, &flag);
+            if (flag) remaining--;
+            if (ret != FENIX_SUCCESS && retval == FENIX_SUCCESS) retval = ret;
+        }
+    }
+
+    for (int i = 0; i < count && remaining == 1; i++) {
+        if (__fenix_request_is_null(requests[i])) continue;
+
+        int ret = __fenix_data_wait(requests[i]);
+        requests[i] = FENIX_REQUEST_NULL;
+        if (ret != FENIX_SUCCESS && retval == FENIX_SUCCESS) retval = ret;
+        remaining = 0;
+    }
+    return retval;
+}
+
+/**
+ * @brief Completes one request if any has finished, setting index to it and
+ *        leaving its handle null. Index is MPI_UNDEFINED if none has, and
+ *        flag is set if there was none left to complete.
+ * @param count
+ * @param requests
+ * @param index
+ * @param flag
+ */
+int __fenix_data_testany(int count, Fenix_Request *requests, int *index, int *flag)
+{
+    int active = 0;
+    *index = MPI_UNDEFINED;
+    for (int i = 0; i < count; i++) {
+        if (__fenix_request_is_null(requests[i])) continue;
+        active = 1;
+
+        int ret = __fenix_data_test_at(requests, i, flag);
+        if (*flag) {
+            *index = i;
+            return ret;
+        }
+    }
+
+    *flag = !active;
+    return FENIX_SUCCESS;
+}
+
+/**
+ * @brief Completes every request that has finished, listing their indices
+ *        and leaving their handles null. Outcount is MPI_UNDEFINED if there
+ *        was none left to complete. Returns the first error a request
+ *        completed with.
+ * @param count
+ * @param requests
+ * @param outcount
+ * @param indices
+ */
+int __fenix_data_testsome(int count, Fenix_Request *requests, int *outcount, int *indices)
+{
+    int retval = FENIX_SUCCESS;
+    int active = 0;
+    *outcount = 0;
+    for (int i = 0; i < count; i++) {
+        if (__fenix_request_is_null(requests[i])) continue;
+        active = 1;
+
+        int flag;
+        int ret = __fenix_data_test_at(requests, i, &flag);
+        if (flag) indices[(*outcount)++] = i;
+        if (ret != FENIX_SUCCESS && retval == FENIX_SUCCESS) retval = ret;
+    }
+
+    if (!active) *outcount = MPI_UNDEFINED;
+    return retval;
+}
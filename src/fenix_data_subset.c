@@ -58,6 +58,7 @@
 #include "fenix-config.h"
 #include "fenix_ext.h"
 #include "fenix_data_subset.h"
+#include "fenix_copy.h"
 
 
 int __fenix_data_subset_init(int num_blocks, Fenix_Data_subset* subset){
@@ -66,9 +67,9 @@ int __fenix_data_subset_init(int num_blocks, Fenix_Data_subset* subset){
       debug_print("ERROR __fenix_data_subset_init: num_regions <%d> must be positive\n",
                 num_blocks);
    } else {
-      subset->start_offsets = (int*) s_malloc(sizeof(int) * num_blocks);
-      subset->end_offsets = (int*) s_malloc(sizeof(int) * num_blocks);
-      subset->num_repeats = (int*) s_calloc(num_blocks, sizeof(int));
+      subset->start_offsets = (MPI_Count*) s_malloc(sizeof(MPI_Count) * num_blocks);
+      subset->end_offsets = (MPI_Count*) s_malloc(sizeof(MPI_Count) * num_blocks);
+      subset->num_repeats = (MPI_Count*) s_calloc(num_blocks, sizeof(MPI_Count));
       subset->num_blocks = num_blocks;
       retval = FENIX_SUCCESS;
    }
@@ -85,23 +86,23 @@ int __fenix_data_subset_init(int num_blocks, Fenix_Data_subset* subset){
  *
  * This routine creates 
  */
-int __fenix_data_subset_create(int num_blocks, int start_offset, int end_offset, int stride,
-                       Fenix_Data_subset *subset_specifier) {
+int __fenix_data_subset_create(MPI_Count num_blocks, MPI_Count start_offset, MPI_Count end_offset,
+                       MPI_Count stride, Fenix_Data_subset *subset_specifier) {
   int retval = -1;
   if (num_blocks <= 0) {
-    debug_print("ERROR Fenix_Data_subset_create: num_blocks <%d> must be positive\n",
-                num_blocks);
+    debug_print("ERROR Fenix_Data_subset_create: num_blocks <%lld> must be positive\n",
+                (long long)num_blocks);
     retval = FENIX_ERROR_SUBSET_NUM_BLOCKS;
   } else if (start_offset < 0) {
-    debug_print("ERROR Fenix_Data_subset_create: start_offset <%d> must be positive\n",
-                start_offset);
+    debug_print("ERROR Fenix_Data_subset_create: start_offset <%lld> must be positive\n",
+                (long long)start_offset);
     retval = FENIX_ERROR_SUBSET_START_OFFSET;
   } else if (end_offset < 0) {
-    debug_print("ERROR Fenix_Data_subset_create: end_offset <%d> must be positive\n",
-                end_offset);
+    debug_print("ERROR Fenix_Data_subset_create: end_offset <%lld> must be positive\n",
+                (long long)end_offset);
     retval = FENIX_ERROR_SUBSET_END_OFFSET;
   } else if (stride <= 0) {
-    debug_print("ERROR Fenix_Data_subset_create: stride <%d> must be positive\n", stride);
+    debug_print("ERROR Fenix_Data_subset_create: stride <%lld> must be positive\n", (long long)stride);
     retval = FENIX_ERROR_SUBSET_STRIDE;
   } else {
     //This is a simple subset with a single region descriptor that simply
@@ -127,6 +128,36 @@ int __fenix_data_subset_create(int num_blocks, int start_offset, int end_offset,
  */
 int __fenix_data_subset_createv(int num_blocks, int *array_start_offsets, int *array_end_offsets,
                         Fenix_Data_subset *subset_specifier) {
+  int retval;
+  if (num_blocks <= 0 || array_start_offsets == NULL || array_end_offsets == NULL) {
+    //Let the large-count version report the problem.
+    MPI_Count placeholder = 0;
+    retval = __fenix_data_subset_createv_c(num_blocks,
+          array_start_offsets == NULL ? NULL : &placeholder,
+          array_end_offsets == NULL ? NULL : &placeholder, subset_specifier);
+  } else {
+    MPI_Count *start_offsets = (MPI_Count*) s_malloc(num_blocks * sizeof(MPI_Count));
+    MPI_Count *end_offsets = (MPI_Count*) s_malloc(num_blocks * sizeof(MPI_Count));
+    for (int index = 0; index < num_blocks; index++) {
+      start_offsets[index] = array_start_offsets[index];
+      end_offsets[index] = array_end_offsets[index];
+    }
+    retval = __fenix_data_subset_createv_c(num_blocks, start_offsets, end_offsets, subset_specifier);
+    free(start_offsets);
+    free(end_offsets);
+  }
+  return retval;
+}
+
+/**
+ * @brief
+ * @param num_blocks
+ * @param array_start_offsets
+ * @param array_end_offsets
+ * @param subset_specifier
+ */
+int __fenix_data_subset_createv_c(int num_blocks, MPI_Count *array_start_offsets,
+                        MPI_Count *array_end_offsets, Fenix_Data_subset *subset_specifier) {
 
   int retval = -1;
   if (num_blocks <= 0) {
@@ -155,8 +186,8 @@ int __fenix_data_subset_createv(int num_blocks, int *array_start_offsets, int *a
     if (found_invalid_index != 1) { // if not true (!= 1)
       __fenix_data_subset_init(num_blocks, subset_specifier);
 
-      memcpy(subset_specifier->start_offsets, array_start_offsets, ( num_blocks * sizeof(int))); // deep copy
-      memcpy(subset_specifier->end_offsets, array_end_offsets, ( num_blocks * sizeof(int))); // deep copy
+      memcpy(subset_specifier->start_offsets, array_start_offsets, ( num_blocks * sizeof(MPI_Count))); // deep copy
+      memcpy(subset_specifier->end_offsets, array_end_offsets, ( num_blocks * sizeof(MPI_Count))); // deep copy
       
       subset_specifier->specifier = __FENIX_SUBSET_CREATEV;
       subset_specifier->stride = 0;
@@ -182,9 +213,9 @@ void __fenix_data_subset_deep_copy(Fenix_Data_subset* from, Fenix_Data_subset* t
       to->specifier = from->specifier;
    } else {
       __fenix_data_subset_init(from->num_blocks, to);
-      memcpy(to->num_repeats, from->num_repeats, to->num_blocks*sizeof(int));
-      memcpy(to->start_offsets, from->start_offsets, to->num_blocks*sizeof(int));
-      memcpy(to->end_offsets, from->end_offsets, to->num_blocks*sizeof(int));
+      memcpy(to->num_repeats, from->num_repeats, to->num_blocks*sizeof(MPI_Count));
+      memcpy(to->start_offsets, from->start_offsets, to->num_blocks*sizeof(MPI_Count));
+      memcpy(to->end_offsets, from->end_offsets, to->num_blocks*sizeof(MPI_Count));
       to->specifier = from->specifier;
       to->stride = from->stride;
    }
@@ -230,7 +261,7 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
             // As this gives us which repetition an overlap is first possible on.
             // Simplify to x >= (second_block_start - first_block_end)/s
             // We want the lowest, so swap >= with =, and since we need an integer we'll round up.
-            int first_intersecting_repetition, option2;
+            MPI_Count first_intersecting_repetition, option2;
             if(ss->start_offsets[second_block] - ss->end_offsets[first_block] > 0){
                first_intersecting_repetition = (ss->start_offsets[second_block] - ss->end_offsets[first_block] - 1)/ss->stride + 1;
                // = ceil( (ss->start_offsets[second_block] - ss->end_offsets[first_block]) / ss->stride)
@@ -279,12 +310,12 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
                continue;
             }
 
-            int length_first_only_start;
-            int length_first_only_end;
-            int length_both;
-            int length_second_only;
-            int merged_start;
-            int merged_end;
+            MPI_Count length_first_only_start;
+            MPI_Count length_first_only_end;
+            MPI_Count length_both;
+            MPI_Count length_second_only;
+            MPI_Count merged_start;
+            MPI_Count merged_end;
             
             
             length_first_only_start = first_intersecting_repetition;
@@ -292,7 +323,7 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
             length_first_only_start = length_first_only_start > (ss->num_repeats[i] + 1) ?
                   (ss->num_repeats[i] + 1) : length_first_only_start;
 
-            int remaining_first_repetitions = ss->num_repeats[first_block] + 1 - length_first_only_start;
+            MPI_Count remaining_first_repetitions = ss->num_repeats[first_block] + 1 - length_first_only_start;
             if(remaining_first_repetitions > ss->num_repeats[second_block]+1){
                length_both = ss->num_repeats[second_block] + 1;
                length_second_only = 0;
@@ -356,12 +387,12 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
                ss->num_blocks++;
                if(ss->num_blocks > space_allocated){
                   
-                  ss->end_offsets = (int*) s_realloc(ss->end_offsets,
-                                (space_allocated * 2) * sizeof(int));
-                  ss->start_offsets = (int*) s_realloc(ss->start_offsets,
-                                (space_allocated * 2) * sizeof(int));
-                  ss->num_repeats = (int*) s_realloc(ss->num_repeats,
-                                (space_allocated * 2) * sizeof(int));
+                  ss->end_offsets = (MPI_Count*) s_realloc(ss->end_offsets,
+                                (space_allocated * 2) * sizeof(MPI_Count));
+                  ss->start_offsets = (MPI_Count*) s_realloc(ss->start_offsets,
+                                (space_allocated * 2) * sizeof(MPI_Count));
+                  ss->num_repeats = (MPI_Count*) s_realloc(ss->num_repeats,
+                                (space_allocated * 2) * sizeof(MPI_Count));
                   space_allocated *= 2;
                }
 
@@ -381,11 +412,11 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
                } else {
                   //We need to move everything over by one.
                   memmove(ss->num_repeats + second_block, ss->num_repeats + second_block + 1, 
-                        ss->num_blocks - second_block - 1);
+                        (ss->num_blocks - second_block - 1) * sizeof(MPI_Count));
                   memmove(ss->start_offsets + second_block, ss->start_offsets + second_block + 1, 
-                        ss->num_blocks - second_block - 1);
+                        (ss->num_blocks - second_block - 1) * sizeof(MPI_Count));
                   memmove(ss->end_offsets + second_block, ss->end_offsets + second_block + 1, 
-                        ss->num_blocks - second_block - 1);
+                        (ss->num_blocks - second_block - 1) * sizeof(MPI_Count));
                   ss->num_blocks--;
                }
             } 
@@ -417,9 +448,9 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
                
                //Move everything over to remove j
                memmove(ss->start_offsets + j, ss->start_offsets + j + 1, 
-                     (ss->num_blocks - j - 1) * sizeof(int));
+                     (ss->num_blocks - j - 1) * sizeof(MPI_Count));
                memmove(ss->end_offsets + j, ss->end_offsets + j + 1, 
-                     (ss->num_blocks - j - 1) * sizeof(int));
+                     (ss->num_blocks - j - 1) * sizeof(MPI_Count));
                ss->num_blocks--;
             }
          }
@@ -429,12 +460,12 @@ void __fenix_data_subset_simplify_regions(Fenix_Data_subset* ss){
    }
 
    if(space_allocated > ss->num_blocks){
-      ss->end_offsets = (int*) s_realloc(ss->end_offsets,
-                    ss->num_blocks * sizeof(int));
-      ss->start_offsets = (int*) s_realloc(ss->start_offsets,
-                    ss->num_blocks * sizeof(int));
-      ss->num_repeats = (int*) s_realloc(ss->num_repeats,
-                    ss->num_blocks * sizeof(int));
+      ss->end_offsets = (MPI_Count*) s_realloc(ss->end_offsets,
+                    ss->num_blocks * sizeof(MPI_Count));
+      ss->start_offsets = (MPI_Count*) s_realloc(ss->start_offsets,
+                    ss->num_blocks * sizeof(MPI_Count));
+      ss->num_repeats = (MPI_Count*) s_realloc(ss->num_repeats,
+                    ss->num_blocks * sizeof(MPI_Count));
    }
 
 }
@@ -470,17 +501,17 @@ void __fenix_data_subset_merge(Fenix_Data_subset* first_subset, Fenix_Data_subse
       __fenix_data_subset_init(output->num_blocks, output);
       output->specifier = __FENIX_SUBSET_CREATE;
       
-      memcpy(output->num_repeats, first_subset->num_repeats, first_subset->num_blocks * sizeof(int));
+      memcpy(output->num_repeats, first_subset->num_repeats, first_subset->num_blocks * sizeof(MPI_Count));
       memcpy(output->num_repeats+first_subset->num_blocks, second_subset->num_repeats, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
 
-      memcpy(output->start_offsets, first_subset->start_offsets, first_subset->num_blocks * sizeof(int));
+      memcpy(output->start_offsets, first_subset->start_offsets, first_subset->num_blocks * sizeof(MPI_Count));
       memcpy(output->start_offsets+first_subset->num_blocks, second_subset->start_offsets, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
       
-      memcpy(output->end_offsets, first_subset->end_offsets, first_subset->num_blocks * sizeof(int));
+      memcpy(output->end_offsets, first_subset->end_offsets, first_subset->num_blocks * sizeof(MPI_Count));
       memcpy(output->end_offsets+first_subset->num_blocks, second_subset->end_offsets, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
    
       //Now we have all of the regions, so we just need to simplify them.
       __fenix_data_subset_simplify_regions(output); 
@@ -503,14 +534,14 @@ void __fenix_data_subset_merge(Fenix_Data_subset* first_subset, Fenix_Data_subse
 
       int index = 0;
       for(int i = 0; i < first_subset->num_blocks; i++){
-         for(int j = 0; j <= first_subset->num_repeats[i]; j++){
+         for(MPI_Count j = 0; j <= first_subset->num_repeats[i]; j++){
             output->start_offsets[index] = j*first_subset->stride + first_subset->start_offsets[i];
             output->end_offsets[index] = j*first_subset->stride + first_subset->end_offsets[i];
             index++;
          }
       }
       for(int i = 0; i < second_subset->num_blocks; i++){
-         for(int j = 0; j <= second_subset->num_repeats[i]; j++){
+         for(MPI_Count j = 0; j <= second_subset->num_repeats[i]; j++){
             output->start_offsets[index] = j*second_subset->stride + second_subset->start_offsets[i];
             output->end_offsets[index] = j*second_subset->stride + second_subset->end_offsets[i];
             index++;
@@ -545,21 +576,21 @@ void __fenix_data_subset_merge_inplace(Fenix_Data_subset* first_subset, Fenix_Da
          first_subset->stride == second_subset->stride){
       //Output is just a CREATE type with combined descriptors. 
       //Start by making a list of all descriptors, then merge any with overlaps.
-      first_subset->num_repeats = (int*)s_realloc(first_subset->num_repeats, 
-            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(int));
-      first_subset->start_offsets = (int*)s_realloc(first_subset->start_offsets, 
-            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(int));
-      first_subset->end_offsets = (int*)s_realloc(first_subset->end_offsets, 
-            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(int));
+      first_subset->num_repeats = (MPI_Count*) s_realloc(first_subset->num_repeats, 
+            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(MPI_Count));
+      first_subset->start_offsets = (MPI_Count*) s_realloc(first_subset->start_offsets, 
+            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(MPI_Count));
+      first_subset->end_offsets = (MPI_Count*) s_realloc(first_subset->end_offsets, 
+            (first_subset->num_blocks + second_subset->num_blocks)*sizeof(MPI_Count));
 
       memcpy(first_subset->num_repeats+first_subset->num_blocks, second_subset->num_repeats, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
 
       memcpy(first_subset->start_offsets+first_subset->num_blocks, second_subset->start_offsets, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
       
       memcpy(first_subset->end_offsets+first_subset->num_blocks, second_subset->end_offsets, 
-            second_subset->num_blocks * sizeof(int));
+            second_subset->num_blocks * sizeof(MPI_Count));
       
       first_subset->num_blocks = first_subset->num_blocks 
          + second_subset->num_blocks;
@@ -580,15 +611,15 @@ void __fenix_data_subset_merge_inplace(Fenix_Data_subset* first_subset, Fenix_Da
          }
       }
 
-      first_subset->num_repeats = (int*)s_realloc(first_subset->num_repeats, new_num_blocks*sizeof(int));
-      first_subset->start_offsets = (int*)s_realloc(first_subset->start_offsets, new_num_blocks*sizeof(int));
-      first_subset->end_offsets = (int*)s_realloc(first_subset->end_offsets, new_num_blocks*sizeof(int));
+      first_subset->num_repeats = (MPI_Count*) s_realloc(first_subset->num_repeats, new_num_blocks*sizeof(MPI_Count));
+      first_subset->start_offsets = (MPI_Count*) s_realloc(first_subset->start_offsets, new_num_blocks*sizeof(MPI_Count));
+      first_subset->end_offsets = (MPI_Count*) s_realloc(first_subset->end_offsets, new_num_blocks*sizeof(MPI_Count));
 
       //work backwards to prevent overwriting current data.
 
       int index = new_num_blocks-1;
       for(int i = second_subset->num_blocks-1; i >= 0; i--){
-         for(int j = 0; j <= second_subset->num_repeats[i]; j++){
+         for(MPI_Count j = 0; j <= second_subset->num_repeats[i]; j++){
             first_subset->start_offsets[index] = j*second_subset->stride 
                + second_subset->start_offsets[i];
             first_subset->end_offsets[index] = j*second_subset->stride 
@@ -598,7 +629,7 @@ void __fenix_data_subset_merge_inplace(Fenix_Data_subset* first_subset, Fenix_Da
          }
       }
       for(int i = first_subset->num_blocks-1; i >= 0; i--){
-         for(int j = 0; j <= first_subset->num_repeats[i]; j++){
+         for(MPI_Count j = 0; j <= first_subset->num_repeats[i]; j++){
             first_subset->start_offsets[index] = j*first_subset->stride 
                + first_subset->start_offsets[i];
             first_subset->end_offsets[index] = j*first_subset->stride 
@@ -617,24 +648,8 @@ void __fenix_data_subset_merge_inplace(Fenix_Data_subset* first_subset, Fenix_Da
 }
 
 
-void __fenix_data_subset_copy_data(Fenix_Data_subset* ss, void* dest, void* src, size_t data_type_size, size_t max_size){
-   if(ss->specifier == __FENIX_SUBSET_FULL){
-      memcpy(dest, src, max_size*data_type_size);  
-   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
-      for(int i = 0; i < ss->num_blocks; i++){
-         //Inclusive both directions, so add 1.
-         int length = ss->end_offsets[i]-ss->start_offsets[i] + 1;
-        
-         for(int j = 0; j <= ss->num_repeats[i]; j++){
-            int start = ss->start_offsets[i] + j*ss->stride;
-            memcpy( ((uint8_t*)dest) + start*data_type_size, ((uint8_t*)src) + start*data_type_size, length*data_type_size);
-         }
-      }
-   }
-}
-
-int __fenix_data_subset_data_size(Fenix_Data_subset* ss, size_t max_size){
-   int size;
+size_t __fenix_data_subset_data_size(Fenix_Data_subset* ss, size_t max_size){
+   size_t size;
 
    if(ss->specifier == __FENIX_SUBSET_FULL){
       size = max_size;
@@ -650,104 +665,332 @@ int __fenix_data_subset_data_size(Fenix_Data_subset* ss, size_t max_size){
    return size;
 }
 
+//Whether two subsets were specified the same way, block for block.
+int __fenix_data_subset_equal(Fenix_Data_subset* a, Fenix_Data_subset* b){
+   if(a->specifier != b->specifier) return 0;
+   if(a->specifier == __FENIX_SUBSET_FULL || a->specifier == __FENIX_SUBSET_EMPTY) return 1;
+   if(a->num_blocks != b->num_blocks || a->stride != b->stride) return 0;
+   size_t bytes = a->num_blocks*sizeof(MPI_Count);
+   return memcmp(a->start_offsets, b->start_offsets, bytes) == 0 &&
+      memcmp(a->end_offsets, b->end_offsets, bytes) == 0 &&
+      memcmp(a->num_repeats, b->num_repeats, bytes) == 0;
+}
+
 int __fenix_data_subset_is_full(Fenix_Data_subset *ss, size_t data_length){
    //Assumes a "simplified" subset which has all mergeable regions merged.
    return (ss->specifier == __FENIX_SUBSET_FULL) || 
       ( (ss->start_offsets[0] == 0) && (ss->end_offsets[0] == data_length-1) );
 }
 
+//Steps through the blocks of a non-full, non-empty subset in increasing offset
+//order. current_repetition must start zeroed (one entry per block). Returns 0 once
+//every block has been visited.
+static int __fenix_data_subset_next_block(Fenix_Data_subset* ss, MPI_Count* current_repetition,
+      MPI_Count* start, MPI_Count* length){
+   MPI_Count lowest_index = -1;
+   int lowest_block = -1;
+   for(int i = 0; i < ss->num_blocks; i++){
+      if(current_repetition[i] <= ss->num_repeats[i]){
+         if(lowest_index == -1 || 
+               (lowest_index > ss->start_offsets[i]+ss->stride*current_repetition[i])){
+            lowest_index = ss->start_offsets[i] + ss->stride*current_repetition[i];
+            lowest_block = i;
+         }
+      }
+   }
+   if(lowest_block == -1) return 0;
+
+   *start = lowest_index;
+   *length = ss->end_offsets[lowest_block]-ss->start_offsets[lowest_block]+1;
+   current_repetition[lowest_block]++;
+   return 1;
+}
+
+//How __fenix_data_subset_copy_blocks lays out the two sides of the copy.
+#define __FENIX_SUBSET_COPY_IN_PLACE 0   // Both buffers hold each element at its offset
+#define __FENIX_SUBSET_COPY_PACK     1   // dest is the in-order packed form of src
+#define __FENIX_SUBSET_COPY_UNPACK   2   // src is the in-order packed form of dest
+
+//Copies the blocks of a non-full, non-empty subset. Subsets with enough data are
+//gathered into one segment list, so the copy threads share their many blocks.
+static void __fenix_data_subset_copy_blocks(Fenix_Data_subset* ss, void* dest, void* src,
+      size_t type_size, size_t max_size, int how, int streaming){
+   int parallel = __fenix_copy_is_parallel(__fenix_data_subset_data_size(ss, max_size)*type_size);
+   fenix_copy_segment_t* segments = NULL;
+   int num_segments = 0;
+   if(parallel){
+      size_t capacity = 0;
+      for(int i = 0; i < ss->num_blocks; i++) capacity += ss->num_repeats[i] + 1;
+      segments = (fenix_copy_segment_t*) s_malloc(capacity * sizeof(fenix_copy_segment_t));
+   }
+
+   MPI_Count* current_repetition = (MPI_Count*) s_calloc(ss->num_blocks, sizeof(MPI_Count));
+   size_t packed = 0;
+   MPI_Count start, length;
+   int block = 0;
+   while(1){
+      //In-place copies need no particular order, so skip the search for the next block.
+      if(how == __FENIX_SUBSET_COPY_IN_PLACE){
+         while(block < ss->num_blocks && current_repetition[block] > ss->num_repeats[block]) block++;
+         if(block == ss->num_blocks) break;
+         start = ss->start_offsets[block] + ss->stride*current_repetition[block];
+         length = ss->end_offsets[block] - ss->start_offsets[block] + 1;
+         current_repetition[block]++;
+      } else if(!__fenix_data_subset_next_block(ss, current_repetition, &start, &length)){
+         break;
+      }
+
+      uint8_t* to = (uint8_t*)dest + (how == __FENIX_SUBSET_COPY_PACK ? (MPI_Count)packed : start)*type_size;
+      uint8_t* from = (uint8_t*)src + (how == __FENIX_SUBSET_COPY_UNPACK ? (MPI_Count)packed : start)*type_size;
+      if(parallel){
+         segments[num_segments].dest = to;
+         segments[num_segments].src = from;
+         segments[num_segments].bytes = length*type_size;
+         num_segments++;
+      } else {
+         __fenix_copy(to, from, length*type_size, streaming);
+      }
+      packed += length;
+   }
+
+   if(parallel) __fenix_copy_segments(segments, num_segments, streaming);
+   free(segments);
+   free(current_repetition);
+}
+
+//Snapshot writes stream past the cache, as they are only read back on recovery.
+void __fenix_data_subset_copy_data(Fenix_Data_subset* ss, void* dest, void* src, size_t data_type_size, size_t max_size){
+   if(ss->specifier == __FENIX_SUBSET_FULL){
+      __fenix_copy(dest, src, max_size*data_type_size, 1);
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      __fenix_data_subset_copy_blocks(ss, dest, src, data_type_size, max_size,
+            __FENIX_SUBSET_COPY_IN_PLACE, 1);
+   }
+}
+
 //Makes an array with the in-order contents of subset ss of src.
 //size is updated to the size of the serialized array, which is returned as the function's return.
 //User's responsibility to free the returned array.
 void* __fenix_data_subset_serialize(Fenix_Data_subset* ss, void* src, size_t type_size, size_t max_size, size_t* size){
-   
-   void* dest;
-   
+   *size = __fenix_data_subset_data_size(ss, max_size);
+   if(*size == 0) return NULL;
+
+   void* dest = malloc(type_size * (*size));
+   __fenix_data_subset_serialize_into(ss, src, dest, type_size, max_size);
+   return dest;
+}
+
+//As serialize, into dest which has room for __fenix_data_subset_data_size elements.
+void __fenix_data_subset_serialize_into(Fenix_Data_subset* ss, void* src, void* dest,
+      size_t type_size, size_t max_size){
+   //The packed data is about to be sent, so it is left in cache.
+   if(ss->specifier == __FENIX_SUBSET_FULL){
+      __fenix_copy(dest, src, type_size*max_size, 0);
+
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY) {
+      __fenix_data_subset_copy_blocks(ss, dest, src, type_size, max_size,
+            __FENIX_SUBSET_COPY_PACK, 0);
+   }
+}
+
+void __fenix_data_subset_deserialize(Fenix_Data_subset* ss, void* src, void* dest, size_t max_size, size_t type_size){
    if(ss->specifier == __FENIX_SUBSET_FULL){
-      dest = malloc(type_size*max_size);
+      __fenix_copy(dest, src, type_size*max_size, 1);
+      
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      __fenix_data_subset_copy_blocks(ss, dest, src, type_size, max_size,
+            __FENIX_SUBSET_COPY_UNPACK, 1);
+   }
 
-      memcpy(dest, src, type_size*max_size);
+}
 
-      *size = max_size;
+//One-sided counterpart of deserialize: puts the serialized contents src of ss
+//where deserialize would place them, relative to target_base in target's memory
+//exposed through win. The caller provides the access epoch.
+void __fenix_data_subset_put(Fenix_Data_subset* ss, void* src, size_t type_size,
+      size_t max_size, int target, MPI_Aint target_base, MPI_Win win){
+   if(ss->specifier == __FENIX_SUBSET_FULL){
+      MPI_Put(src, type_size*max_size, MPI_BYTE, target, target_base, type_size*max_size,
+            MPI_BYTE, win);
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      MPI_Count* current_repetition = (MPI_Count*) s_calloc(ss->num_blocks, sizeof(MPI_Count));
+      size_t restored = 0;
+      MPI_Count start, length;
+      while(__fenix_data_subset_next_block(ss, current_repetition, &start, &length)){
+         MPI_Put(((uint8_t*)src)+restored*type_size, type_size*length, MPI_BYTE, target,
+               MPI_Aint_add(target_base, start*type_size), type_size*length, MPI_BYTE, win);
+         restored += length;
+      }
+      free(current_repetition);
+   }
+}
 
-   } else if(ss->specifier == __FENIX_SUBSET_EMPTY) {
+//Drops the parts of ss at or past element max_size, e.g. regions stored before
+//a member was shrunk. The result is simplified.
+void __fenix_data_subset_clip(Fenix_Data_subset* ss, size_t max_size){
+   if(ss->specifier == __FENIX_SUBSET_FULL || ss->specifier == __FENIX_SUBSET_EMPTY) return;
 
-      dest = NULL;
-      size = 0;
+   MPI_Count max = (MPI_Count)max_size;
+   int new_num_blocks = 0, needs_clip = 0;
+   for(int i = 0; i < ss->num_blocks; i++){
+      for(MPI_Count j = 0; j <= ss->num_repeats[i]; j++){
+         if(ss->start_offsets[i] + j*ss->stride < max) new_num_blocks++;
+         if(ss->end_offsets[i] + j*ss->stride >= max) needs_clip = 1;
+      }
+   }
+   if(!needs_clip) return;
 
-   } else {
-      //First, count up the number of entries to find a size.
-      *size = __fenix_data_subset_data_size(ss, max_size);
+   if(new_num_blocks == 0){
+      ss->specifier = __FENIX_SUBSET_EMPTY;
+      return;
+   }
 
-      dest = malloc(type_size * (*size));
-      
-      int* current_repetition = (int*) s_calloc(ss->num_blocks, sizeof(int));
-      //We need to be sure to go in the right order.
-      int stored = 0;
-      while(stored < *size){
-         int lowest_index = -1;
-         int lowest_block = -1;
-         for(int i = 0; i < ss->num_blocks; i++){
-            if(current_repetition[i] <= ss->num_repeats[i]){
-               if(lowest_index == -1 || 
-                     (lowest_index > ss->start_offsets[i]+ss->stride*current_repetition[i])){
-                  lowest_index = ss->start_offsets[i] + ss->stride*current_repetition[i];
-                  lowest_block = i;
-               }
-            }
-         }
-         
-         memcpy(((uint8_t*)dest)+stored*type_size, ((uint8_t*)src)+lowest_index*type_size, 
-               type_size*(ss->end_offsets[lowest_block]-ss->start_offsets[lowest_block]+1) );
-         stored += ss->end_offsets[lowest_block]-ss->start_offsets[lowest_block]+1;
-         current_repetition[lowest_block]++;
+   Fenix_Data_subset clipped;
+   __fenix_data_subset_init(new_num_blocks, &clipped);
+   int index = 0;
+   for(int i = 0; i < ss->num_blocks; i++){
+      for(MPI_Count j = 0; j <= ss->num_repeats[i]; j++){
+         MPI_Count start = ss->start_offsets[i] + j*ss->stride;
+         MPI_Count end = ss->end_offsets[i] + j*ss->stride;
+         if(start >= max) continue;
+         clipped.start_offsets[index] = start;
+         clipped.end_offsets[index] = end < max ? end : max - 1;
+         index++;
       }
+   }
+   clipped.stride = 0;
+   clipped.specifier = __FENIX_SUBSET_CREATEV;
 
-      free(current_repetition);
+   __fenix_data_subset_free(ss);
+   *ss = clipped;
+   __fenix_data_subset_simplify_regions(ss);
+}
+
+//The _user variants below are the same operations, but with the user's side of the
+//copy laid out as described by layout rather than packed. Storage on the Fenix side
+//is always packed, element i at i*layout->size.
+void __fenix_data_subset_copy_from_user(Fenix_Data_subset* ss, void* dest, void* src,
+      fenix_data_layout_t* layout, size_t max_size){
+   if(layout->contiguous){
+      //Nothing to pack, so this is the local snapshot copy of copy_data.
+      __fenix_data_subset_copy_data(ss, dest, src, layout->size, max_size);
+   } else if(ss->specifier == __FENIX_SUBSET_FULL){
+      __fenix_data_layout_pack(layout, dest, src, 0, max_size);
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      for(int i = 0; i < ss->num_blocks; i++){
+         MPI_Count length = ss->end_offsets[i]-ss->start_offsets[i] + 1;
+         for(MPI_Count j = 0; j <= ss->num_repeats[i]; j++){
+            MPI_Count start = ss->start_offsets[i] + j*ss->stride;
+            __fenix_data_layout_pack(layout, ((uint8_t*)dest) + start*layout->size, src,
+                  start, length);
+         }
+      }
+   }
+}
 
+void __fenix_data_subset_copy_to_user(Fenix_Data_subset* ss, void* dest, void* src,
+      fenix_data_layout_t* layout, size_t max_size){
+   if(ss->specifier == __FENIX_SUBSET_FULL){
+      __fenix_data_layout_unpack(layout, dest, src, 0, max_size);
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      for(int i = 0; i < ss->num_blocks; i++){
+         MPI_Count length = ss->end_offsets[i]-ss->start_offsets[i] + 1;
+         for(MPI_Count j = 0; j <= ss->num_repeats[i]; j++){
+            MPI_Count start = ss->start_offsets[i] + j*ss->stride;
+            if(start >= (MPI_Count)max_size) continue;
+            __fenix_data_layout_unpack(layout, dest, ((uint8_t*)src) + start*layout->size,
+                  start, (start + length > (MPI_Count)max_size) ? (MPI_Count)max_size - start : length);
+         }
+      }
    }
+}
 
+void* __fenix_data_subset_serialize_user(Fenix_Data_subset* ss, void* src,
+      fenix_data_layout_t* layout, size_t max_size, size_t* size){
+   *size = __fenix_data_subset_data_size(ss, max_size);
+   if(*size == 0) return NULL;
 
+   void* dest = malloc(layout->size * (*size));
+   __fenix_data_subset_serialize_user_into(ss, src, dest, layout, max_size);
    return dest;
 }
 
-void __fenix_data_subset_deserialize(Fenix_Data_subset* ss, void* src, void* dest, size_t max_size, size_t type_size){
+//As serialize_user, into dest which has room for __fenix_data_subset_data_size elements.
+void __fenix_data_subset_serialize_user_into(Fenix_Data_subset* ss, void* src, void* dest,
+      fenix_data_layout_t* layout, size_t max_size){
    if(ss->specifier == __FENIX_SUBSET_FULL){
-      memcpy(dest, src, type_size*max_size);
-      
+      __fenix_data_layout_pack(layout, dest, src, 0, max_size);
    } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
-      //First, count up the number of entries to find a size.
-      int size = __fenix_data_subset_data_size(ss, max_size);
-    
-      int* current_repetition = (int*) s_calloc(ss->num_blocks, sizeof(int));
-      //We need to be sure to go in the right order.
-      int restored = 0;
-      while(restored < size){
-         int lowest_index = -1;
-         int lowest_block = -1;
-         for(int i = 0; i < ss->num_blocks; i++){
-            if(current_repetition[i] <= ss->num_repeats[i]){
-               if(lowest_index == -1 || 
-                     (lowest_index > ss->start_offsets[i]+ss->stride*current_repetition[i])){
-                  lowest_index = ss->start_offsets[i] + ss->stride*current_repetition[i];
-                  lowest_block = i;
-               }
-            }
-         }
-         
-         memcpy(((uint8_t*)dest)+lowest_index*type_size, ((uint8_t*)src)+restored*type_size, 
-               type_size*(ss->end_offsets[lowest_block]-ss->start_offsets[lowest_block]+1) );
-         restored += ss->end_offsets[lowest_block]-ss->start_offsets[lowest_block]+1;
-         current_repetition[lowest_block]++;
+      MPI_Count* current_repetition = (MPI_Count*) s_calloc(ss->num_blocks, sizeof(MPI_Count));
+      size_t stored = 0;
+      MPI_Count start, length;
+      while(__fenix_data_subset_next_block(ss, current_repetition, &start, &length)){
+         __fenix_data_layout_pack(layout, ((uint8_t*)dest) + stored*layout->size, src,
+               start, length);
+         stored += length;
       }
+      free(current_repetition);
+   }
+}
 
+void __fenix_data_subset_deserialize_user(Fenix_Data_subset* ss, void* src, void* dest,
+      fenix_data_layout_t* layout, size_t max_size){
+   if(ss->specifier == __FENIX_SUBSET_FULL){
+      __fenix_data_layout_unpack(layout, dest, src, 0, max_size);
+   } else if(ss->specifier != __FENIX_SUBSET_EMPTY){
+      MPI_Count* current_repetition = (MPI_Count*) s_calloc(ss->num_blocks, sizeof(MPI_Count));
+      size_t restored = 0;
+      MPI_Count start, length;
+      while(__fenix_data_subset_next_block(ss, current_repetition, &start, &length)){
+         if(start < (MPI_Count)max_size){
+            __fenix_data_layout_unpack(layout, dest, ((uint8_t*)src) + restored*layout->size,
+                  start, (start + length > (MPI_Count)max_size) ? (MPI_Count)max_size - start : length);
+         }
+         restored += length;
+      }
       free(current_repetition);
    }
+}
 
+//CRC32C of the packed contents of subset ss of user buffer src, clipped to max_size
+//elements. Contiguous layouts are summed in place, so nothing is copied.
+uint32_t __fenix_data_subset_checksum_user(Fenix_Data_subset* ss, void* src,
+      fenix_data_layout_t* layout, size_t max_size){
+   uint32_t crc = 0;
+   if(ss->specifier == __FENIX_SUBSET_EMPTY || max_size == 0) return crc;
+
+   void* scratch = NULL;
+   MPI_Count scratch_length = 0;
+   MPI_Count* current_repetition = NULL;
+   MPI_Count max = (MPI_Count)max_size;
+   MPI_Count start = 0, length = max;
+   int more = 1;
+   if(ss->specifier != __FENIX_SUBSET_FULL){
+      current_repetition = (MPI_Count*) s_calloc(ss->num_blocks, sizeof(MPI_Count));
+      more = __fenix_data_subset_next_block(ss, current_repetition, &start, &length);
+   }
+   while(more && start < max){
+      if(start + length > max) length = max - start;
+      if(layout->contiguous){
+         crc = __fenix_crc32c(crc, ((uint8_t*)src) + start*layout->size, length*layout->size);
+      } else {
+         if(length > scratch_length){
+            scratch = s_realloc(scratch, length*layout->size);
+            scratch_length = length;
+         }
+         __fenix_data_layout_pack(layout, scratch, src, start, length);
+         crc = __fenix_crc32c(crc, scratch, length*layout->size);
+      }
+      more = current_repetition != NULL &&
+         __fenix_data_subset_next_block(ss, current_repetition, &start, &length);
+   }
+   free(scratch);
+   free(current_repetition);
+   return crc;
 }
 
 void __fenix_data_subset_send(Fenix_Data_subset* ss, int dest, int tag, MPI_Comm comm){
-   int* toSend = (int*)malloc(sizeof(int) * (3 + 3*ss->num_blocks));
+   MPI_Count* toSend = (MPI_Count*)malloc(sizeof(MPI_Count) * (3 + 3*ss->num_blocks));
    toSend[0] = ss->num_blocks;
    
    for(int i = 0; i < ss->num_blocks; i++){
@@ -759,7 +1002,7 @@ void __fenix_data_subset_send(Fenix_Data_subset* ss, int dest, int tag, MPI_Comm
    toSend[1+3*ss->num_blocks] = ss->stride;
    toSend[2+3*ss->num_blocks] = ss->specifier;
 
-   MPI_Send((void*)toSend, 3*ss->num_blocks + 3, MPI_INT, dest, tag, comm); 
+   MPI_Send((void*)toSend, 3*ss->num_blocks + 3, MPI_COUNT, dest, tag, comm); 
    free(toSend);
 }
 
@@ -768,10 +1011,10 @@ void __fenix_data_subset_recv(Fenix_Data_subset* ss, int src, int tag, MPI_Comm
    MPI_Probe(src, tag, comm, &status);
 
    int size;
-   MPI_Get_count(&status, MPI_INT, &size);
+   MPI_Get_count(&status, MPI_COUNT, &size);
 
-   int *recvd = (int*)malloc(sizeof(int) * size);
-   MPI_Recv((void*)recvd, size, MPI_INT, src, tag, comm, NULL);
+   MPI_Count *recvd = (MPI_Count*)malloc(sizeof(MPI_Count) * size);
+   MPI_Recv((void*)recvd, size, MPI_COUNT, src, tag, comm, NULL);
 
    __fenix_data_subset_init(recvd[0], ss);
    for(int i = 0; i < ss->num_blocks; i++){
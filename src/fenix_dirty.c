@@ -0,0 +1,336 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix_dirty.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//Linux sets a page's soft-dirty bit when it is written, and clears the bits of
+//the whole process when 4 is written to clear_refs. pagemap has an 8 byte
+//entry per page, the bit being one of its flags. Since a clear is process
+//wide, the bits of every tracked buffer are gathered before each one.
+#define __FENIX_DIRTY_PAGEMAP_BIT 55
+#define __FENIX_DIRTY_READ_PAGES 512
+
+struct __fenix_dirty {
+    void *data;               // The buffer tracked
+    size_t bytes;
+    int datatype_size;
+    uintptr_t first_page;     // Page number of the buffer's first page
+    size_t num_pages;
+    unsigned char *written;   // Per page, written since the last store
+    int baseline;             // The snapshots hold all of the buffer
+    struct __fenix_dirty *next;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    int pagemap;              // -1 without soft-dirty bits
+    int clear_refs;
+    size_t page_size;
+    fenix_dirty_t *tracked;
+} __fenix_dirty = { PTHREAD_MUTEX_INITIALIZER, -1, -1, 0, NULL };
+
+#if defined(__linux__)
+//Marks the pages of dirty whose bits are set.
+static int __fenix_dirty_gather(fenix_dirty_t *dirty)
+{
+    uint64_t entries[__FENIX_DIRTY_READ_PAGES];
+    for (size_t page = 0; page < dirty->num_pages; page += __FENIX_DIRTY_READ_PAGES) {
+        size_t pages = dirty->num_pages - page;
+        if (pages > __FENIX_DIRTY_READ_PAGES) pages = __FENIX_DIRTY_READ_PAGES;
+        off_t offset = (off_t) ((dirty->first_page + page) * sizeof(uint64_t));
+        if (pread(__fenix_dirty.pagemap, entries, pages * sizeof(uint64_t), offset) !=
+            (ssize_t) (pages * sizeof(uint64_t))) {
+            return 0;
+        }
+        for (size_t i = 0; i < pages; i++) {
+            if ((entries[i] >> __FENIX_DIRTY_PAGEMAP_BIT) & 1) dirty->written[page + i] = 1;
+        }
+    }
+    return 1;
+}
+
+//Gathers every tracked buffer's bits, then clears them. With the lock held.
+static int __fenix_dirty_collect()
+{
+    int gathered = 1;
+    for (fenix_dirty_t *dirty = __fenix_dirty.tracked; dirty != NULL; dirty = dirty->next) {
+        if (!__fenix_dirty_gather(dirty)) {
+            //Without its bits the buffer has to be stored in full.
+            dirty->baseline = 0;
+            gathered = 0;
+        }
+    }
+    if (write(__fenix_dirty.clear_refs, "4", 1) != 1) gathered = 0;
+    return gathered;
+}
+#endif
+
+/**
+ * @brief Opens the kernel's soft-dirty interface. Without it, or on kernels
+ *        that accept the clear but never set the bits, every store is full.
+ *        Returns whether stores can be narrowed to the pages written.
+ */
+int __fenix_dirty_init()
+{
+#if defined(__linux__)
+    pthread_mutex_lock(&__fenix_dirty.lock);
+    if (__fenix_dirty.pagemap == -1) {
+        __fenix_dirty.page_size = (size_t) sysconf(_SC_PAGESIZE);
+        int pagemap = open("/proc/self/pagemap", O_RDONLY);
+        int clear_refs = open("/proc/self/clear_refs", O_WRONLY);
+
+        //A page written right after a clear has to show up as written.
+        fenix_dirty_t probe;
+        memset(&probe, 0, sizeof(probe));
+        probe.num_pages = 1;
+        probe.written = (unsigned char *) s_calloc(1, 1);
+        volatile char *page = (volatile char *) s_malloc(2 * __fenix_dirty.page_size);
+        page[0] = 1;
+        volatile char *aligned = (volatile char *)
+            (((uintptr_t) page + __fenix_dirty.page_size) & ~(__fenix_dirty.page_size - 1));
+        probe.first_page = (uintptr_t) aligned / __fenix_dirty.page_size;
+
+        __fenix_dirty.pagemap = pagemap;
+        if (pagemap != -1 && clear_refs != -1 && write(clear_refs, "4", 1) == 1) {
+            aligned[0] = 1;
+            __fenix_dirty_gather(&probe);
+        }
+        if (probe.written[0]) {
+            __fenix_dirty.clear_refs = clear_refs;
+        } else {
+            if (pagemap != -1) close(pagemap);
+            if (clear_refs != -1) close(clear_refs);
+            __fenix_dirty.pagemap = -1;
+        }
+        free((void *) page);
+        free(probe.written);
+    }
+    int supported = __fenix_dirty.pagemap != -1;
+    pthread_mutex_unlock(&__fenix_dirty.lock);
+    return supported;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Collective over comm. Decides what a full store of a buffer has to
+ *        store: the blocks of elements with pages written since its last
+ *        store on any rank, or everything when some rank can't tell or the
+ *        ranks' counts differ. Returns 1 and fills subset, to be freed by the
+ *        caller, in the first case, 0 in the second. A NULL data or a buffer
+ *        other than the one tracked before is stored in full.
+ * @param dirty          The buffer's tracking, created on first use
+ * @param data
+ * @param count
+ * @param datatype_size
+ * @param comm
+ * @param subset
+ */
+int __fenix_dirty_subset(fenix_dirty_t **dirty, void *data, size_t count, int datatype_size,
+                         MPI_Comm comm, Fenix_Data_subset *subset)
+{
+    size_t bytes = count * datatype_size;
+    int ready = 0;
+    size_t num_pages = 0;
+    uintptr_t first_page = 0;
+    unsigned char *written = NULL;
+
+#if defined(__linux__)
+    pthread_mutex_lock(&__fenix_dirty.lock);
+    if (__fenix_dirty.pagemap != -1 && data != NULL && bytes > 0) {
+        size_t page_size = __fenix_dirty.page_size;
+        if (*dirty == NULL) {
+            *dirty = (fenix_dirty_t *) s_calloc(1, sizeof(fenix_dirty_t));
+            (*dirty)->next = __fenix_dirty.tracked;
+            __fenix_dirty.tracked = *dirty;
+        }
+        fenix_dirty_t *tracking = *dirty;
+        if (tracking->data != data || tracking->bytes != bytes ||
+            tracking->datatype_size != datatype_size) {
+            tracking->data = data;
+            tracking->bytes = bytes;
+            tracking->datatype_size = datatype_size;
+            tracking->first_page = (uintptr_t) data / page_size;
+            tracking->num_pages = ((uintptr_t) data + bytes - 1) / page_size -
+                                  tracking->first_page + 1;
+            free(tracking->written);
+            tracking->written = (unsigned char *) s_calloc(tracking->num_pages, 1);
+            tracking->baseline = 0;
+        }
+
+        //Taken over now, later writes count towards the next store.
+        ready = __fenix_dirty_collect() && tracking->baseline;
+        num_pages = tracking->num_pages;
+        first_page = tracking->first_page;
+        written = (unsigned char *) s_malloc(num_pages);
+        memcpy(written, tracking->written, num_pages);
+        memset(tracking->written, 0, num_pages);
+        tracking->baseline = 1;
+    }
+    pthread_mutex_unlock(&__fenix_dirty.lock);
+#endif
+
+    //Blocks of about a page of elements, the same on every rank.
+    long long per_block = (long long) ((__fenix_dirty.page_size + datatype_size - 1) /
+                                       (datatype_size > 0 ? datatype_size : 1));
+    long long agree[5] = { !ready, (long long) count, -(long long) count,
+                           per_block, -per_block };
+    MPI_Allreduce(MPI_IN_PLACE, agree, 5, MPI_LONG_LONG, MPI_MAX, comm);
+    int narrowed = agree[0] == 0 && agree[1] == -agree[2] && agree[3] == -agree[4];
+
+    if (narrowed) {
+        size_t num_blocks = (count + per_block - 1) / per_block;
+        size_t block_bytes = per_block * datatype_size;
+        unsigned char *blocks = (unsigned char *) s_calloc(num_blocks, 1);
+        for (size_t page = 0; page < num_pages; page++) {
+            if (!written[page]) continue;
+            uintptr_t start = (first_page + page) * __fenix_dirty.page_size;
+            uintptr_t end = start + __fenix_dirty.page_size;
+            if (start < (uintptr_t) data) start = (uintptr_t) data;
+            if (end > (uintptr_t) data + bytes) end = (uintptr_t) data + bytes;
+            for (size_t block = (start - (uintptr_t) data) / block_bytes;
+                 block <= (end - 1 - (uintptr_t) data) / block_bytes; block++) {
+                blocks[block] = 1;
+            }
+        }
+        MPI_Allreduce(MPI_IN_PLACE, blocks, (int) num_blocks, MPI_UNSIGNED_CHAR, MPI_BOR, comm);
+
+        int num_runs = 0;
+        MPI_Count *starts = (MPI_Count *) s_malloc((num_blocks / 2 + 1) * sizeof(MPI_Count));
+        MPI_Count *ends = (MPI_Count *) s_malloc((num_blocks / 2 + 1) * sizeof(MPI_Count));
+        for (size_t block = 0; block < num_blocks; block++) {
+            if (!blocks[block]) continue;
+            size_t last = block;
+            while (last + 1 < num_blocks && blocks[last + 1]) last++;
+            starts[num_runs] = (MPI_Count) (block * per_block);
+            ends[num_runs] = (MPI_Count) ((last + 1) * per_block < count ?
+                                          (last + 1) * per_block : count) - 1;
+            num_runs++;
+            block = last;
+        }
+
+        if (num_runs > 0) {
+            __fenix_data_subset_createv_c(num_runs, starts, ends, subset);
+        } else {
+            __fenix_data_subset_init(1, subset);
+            subset->specifier = __FENIX_SUBSET_EMPTY;
+        }
+        free(starts);
+        free(ends);
+        free(blocks);
+    }
+
+    free(written);
+    return narrowed;
+}
+
+/**
+ * @brief Has the next store of the buffer tracked be full, since its
+ *        snapshots no longer hold what it held at its last store.
+ * @param dirty
+ */
+void __fenix_dirty_forget(fenix_dirty_t *dirty)
+{
+    pthread_mutex_lock(&__fenix_dirty.lock);
+    if (dirty != NULL) dirty->baseline = 0;
+    pthread_mutex_unlock(&__fenix_dirty.lock);
+}
+
+/**
+ * @brief Stops tracking a buffer.
+ * @param dirty
+ */
+void __fenix_dirty_release(fenix_dirty_t **dirty)
+{
+    if (*dirty == NULL) return;
+
+    pthread_mutex_lock(&__fenix_dirty.lock);
+    fenix_dirty_t **link = &__fenix_dirty.tracked;
+    while (*link != NULL && *link != *dirty) link = &((*link)->next);
+    if (*link != NULL) *link = (*dirty)->next;
+    pthread_mutex_unlock(&__fenix_dirty.lock);
+
+    free((*dirty)->written);
+    free(*dirty);
+    *dirty = NULL;
+}
+
+/**
+ * @brief Closes the soft-dirty interface.
+ */
+void __fenix_dirty_finalize()
+{
+#if defined(__linux__)
+    pthread_mutex_lock(&__fenix_dirty.lock);
+    if (__fenix_dirty.pagemap != -1) {
+        close(__fenix_dirty.pagemap);
+        close(__fenix_dirty.clear_refs);
+        __fenix_dirty.pagemap = -1;
+        __fenix_dirty.clear_refs = -1;
+    }
+    pthread_mutex_unlock(&__fenix_dirty.lock);
+#endif
+}
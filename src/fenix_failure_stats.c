@@ -0,0 +1,157 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix_failure_stats.h"
+#include "fenix_ext.h"
+#include "fenix_util.h"
+#include <mpi.h>
+
+//The stats file is a couple of "key value" lines so that it can be
+//inspected or seeded by hand:
+//    failures <total failures observed>
+//    exposure <total seconds of runtime observed>
+
+static void __fenix_failure_stats_load(fenix_failure_stats_t *stats)
+{
+    FILE *file = fopen(stats->path, "r");
+    if (file == NULL) return;
+
+    char key[64];
+    double value;
+    while (fscanf(file, "%63s %lf", key, &value) == 2) {
+        if (strcmp(key, "failures") == 0) {
+            stats->prior_failures = (int) value;
+        } else if (strcmp(key, "exposure") == 0) {
+            stats->prior_exposure = value;
+        }
+    }
+    fclose(file);
+}
+
+void __fenix_failure_stats_init(fenix_failure_stats_t *stats, const char *path,
+                                double default_mtbf, MPI_Comm comm)
+{
+    stats->run_start = MPI_Wtime();
+    stats->last_failure = stats->run_start;
+    stats->interarrival_sum = 0;
+    stats->failures = 0;
+    stats->prior_exposure = 0;
+    stats->prior_failures = 0;
+    stats->default_mtbf = default_mtbf > 0 ? default_mtbf : __FENIX_DEFAULT_MTBF;
+    stats->path = NULL;
+
+    if (path == NULL) return;
+    stats->path = strdup(path);
+
+    //Only one rank touches the file system, everyone else gets a copy.
+    double history[2] = {0, 0};
+    if (__fenix_get_current_rank(comm) == 0) {
+        __fenix_failure_stats_load(stats);
+        history[0] = stats->prior_exposure;
+        history[1] = stats->prior_failures;
+    }
+    PMPI_Bcast(history, 2, MPI_DOUBLE, 0, comm);
+    stats->prior_exposure = history[0];
+    stats->prior_failures = (int) history[1];
+}
+
+void __fenix_failure_stats_record(fenix_failure_stats_t *stats)
+{
+    double now = MPI_Wtime();
+    stats->interarrival_sum += now - stats->last_failure;
+    stats->last_failure = now;
+    stats->failures++;
+
+    if (fenix.options.verbose == 2) {
+        verbose_print("failure %d, inter-arrival: %f, mtbf estimate: %f\n",
+                      stats->failures, stats->interarrival_sum / stats->failures,
+                      __fenix_failure_stats_mtbf(stats));
+    }
+
+    //Save right away, we may not make it to Fenix_Finalize.
+    __fenix_failure_stats_save(stats);
+}
+
+double __fenix_failure_stats_mtbf(fenix_failure_stats_t *stats)
+{
+    //Failures are treated as a Poisson process, so the estimate is total
+    //exposure over failure count. The default MTBF is counted as one extra
+    //failure-free interval so the estimate is sane before any failures.
+    double exposure = stats->prior_exposure + (MPI_Wtime() - stats->run_start);
+    int failures = stats->prior_failures + stats->failures;
+    return (exposure + stats->default_mtbf) / (failures + 1);
+}
+
+void __fenix_failure_stats_save(fenix_failure_stats_t *stats)
+{
+    if (stats->path == NULL || __fenix_get_current_rank(fenix.world) != 0) return;
+
+    FILE *file = fopen(stats->path, "w");
+    if (file == NULL) {
+        debug_print("ERROR Fenix: unable to write failure stats file <%s>\n", stats->path);
+        return;
+    }
+    fprintf(file, "failures %d\n", stats->prior_failures + stats->failures);
+    fprintf(file, "exposure %f\n", stats->prior_exposure + (MPI_Wtime() - stats->run_start));
+    fclose(file);
+}
+
+void __fenix_failure_stats_destroy(fenix_failure_stats_t *stats)
+{
+    __fenix_failure_stats_save(stats);
+    free(stats->path);
+    stats->path = NULL;
+}
@@ -0,0 +1,260 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix.h"
+#include "fenix_lossy.h"
+#include "fenix_util.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+//Values are coded in blocks of __FENIX_LOSSY_BLOCK. Each value is predicted
+//from the ones decoded before it, either as the last one or on the line
+//through the last two, and the difference is quantized to a multiple of twice
+//the bound. Smooth fields then leave small integers, which are zigzagged and
+//bit-packed at the width of the block's largest. A block starts with a byte
+//holding that width and the predictor, or __FENIX_LOSSY_RAW for a block stored
+//as is because some value of it could not be kept within the bound.
+#define __FENIX_LOSSY_BLOCK 32
+#define __FENIX_LOSSY_RAW 0xFF
+#define __FENIX_LOSSY_LINEAR 0x40
+#define __FENIX_LOSSY_MAX_CODE ((int64_t) 1 << 31)
+
+//The two values decoded last, which predict the next one.
+typedef struct {
+    double last;
+    double before;
+} fenix_lossy_history_t;
+
+static double __fenix_lossy_load(const void *src, size_t i, int type)
+{
+    return type == __FENIX_LOSSY_DOUBLE ? ((const double *) src)[i] : ((const float *) src)[i];
+}
+
+//What the element type keeps of a value.
+static double __fenix_lossy_round(double value, int type)
+{
+    return type == __FENIX_LOSSY_DOUBLE ? value : (double) (float) value;
+}
+
+//The value a code decodes to. Encoding carries on from exactly this value,
+//so both ends compute it here.
+static double __fenix_lossy_decoded(const fenix_lossy_history_t *history, int linear,
+                                    int64_t code, int type, double bound)
+{
+    double predicted = linear ? 2 * history->last - history->before : history->last;
+    return __fenix_lossy_round(predicted + code * 2 * bound, type);
+}
+
+static void __fenix_lossy_push(fenix_lossy_history_t *history, double value)
+{
+    history->before = history->last;
+    history->last = value;
+}
+
+//Quantizes a block with one predictor. Returns the width its codes need, or
+//-1 if a value can't be kept within the bound.
+static int __fenix_lossy_quantize(const void *src, size_t first, size_t n, int type,
+                                  double bound, int linear, fenix_lossy_history_t history,
+                                  uint32_t *codes)
+{
+    uint32_t widest = 0;
+    for (size_t i = 0; i < n; i++) {
+        double value = __fenix_lossy_load(src, first + i, type);
+        double predicted = __fenix_lossy_decoded(&history, linear, 0, type, bound);
+        double steps = nearbyint((value - predicted) / (2 * bound));
+        if (!isfinite(steps) || fabs(steps) >= __FENIX_LOSSY_MAX_CODE) return -1;
+
+        int64_t code = (int64_t) steps;
+        double decoded = __fenix_lossy_decoded(&history, linear, code, type, bound);
+        if (!(fabs(decoded - value) <= bound)) return -1;
+
+        codes[i] = (uint32_t) (((uint64_t) code << 1) ^ (uint64_t) (code >> 63));
+        widest |= codes[i];
+        __fenix_lossy_push(&history, decoded);
+    }
+
+    int width = 0;
+    while (width < 32 && (widest >> width) != 0) width++;
+    return width;
+}
+
+/**
+ * @brief Encodes count floats or doubles so that each decodes to within bound
+ *        of its value. Returns the stream, which the caller frees.
+ * @param src
+ * @param count
+ * @param type    __FENIX_LOSSY_FLOAT or __FENIX_LOSSY_DOUBLE
+ * @param bound   Greater than zero
+ * @param bytes   Set to the stream's length
+ */
+void *__fenix_lossy_encode(const void *src, size_t count, int type, double bound,
+                           size_t *bytes)
+{
+    size_t value_size = type == __FENIX_LOSSY_DOUBLE ? sizeof(double) : sizeof(float);
+    size_t num_blocks = (count + __FENIX_LOSSY_BLOCK - 1) / __FENIX_LOSSY_BLOCK;
+    uint8_t *stream = (uint8_t *) s_malloc(num_blocks + count * value_size + 1);
+    uint8_t *out = stream;
+
+    fenix_lossy_history_t history = { 0, 0 };
+    uint32_t codes[2][__FENIX_LOSSY_BLOCK];
+    for (size_t first = 0; first < count; first += __FENIX_LOSSY_BLOCK) {
+        size_t n = count - first < __FENIX_LOSSY_BLOCK ? count - first : __FENIX_LOSSY_BLOCK;
+        int widths[2];
+        for (int linear = 0; linear < 2; linear++) {
+            widths[linear] = __fenix_lossy_quantize(src, first, n, type, bound, linear, history,
+                                                    codes[linear]);
+        }
+        int linear = widths[1] != -1 && (widths[0] == -1 || widths[1] < widths[0]);
+        int width = widths[linear];
+
+        //A packed block is never larger than its values.
+        if (width == -1 || (size_t) width * n > 8 * value_size * n) {
+            *out++ = __FENIX_LOSSY_RAW;
+            memcpy(out, (const uint8_t *) src + first * value_size, n * value_size);
+            out += n * value_size;
+            for (size_t i = 0; i < n; i++) {
+                __fenix_lossy_push(&history, __fenix_lossy_load(src, first + i, type));
+            }
+            continue;
+        }
+
+        *out++ = (uint8_t) (width | (linear ? __FENIX_LOSSY_LINEAR : 0));
+        uint64_t pending = 0;
+        int pending_bits = 0;
+        for (size_t i = 0; i < n; i++) {
+            pending |= (uint64_t) codes[linear][i] << pending_bits;
+            pending_bits += width;
+            while (pending_bits >= 8) {
+                *out++ = (uint8_t) pending;
+                pending >>= 8;
+                pending_bits -= 8;
+            }
+        }
+        if (pending_bits > 0) *out++ = (uint8_t) pending;
+
+        //Carry on from the values as they will be decoded.
+        for (size_t i = 0; i < n; i++) {
+            int64_t code = (int64_t) (codes[linear][i] >> 1) ^ -(int64_t) (codes[linear][i] & 1);
+            __fenix_lossy_push(&history, __fenix_lossy_decoded(&history, linear, code, type, bound));
+        }
+    }
+
+    *bytes = out - stream;
+    return stream;
+}
+
+/**
+ * @brief Decodes count values from a stream __fenix_lossy_encode made with
+ *        the same type and bound. Returns FENIX_SUCCESS, or
+ *        FENIX_ERROR_INVALID_ATTRIBUTE_VALUE if the stream is cut short.
+ * @param stream
+ * @param bytes
+ * @param dest
+ * @param count
+ * @param type
+ * @param bound
+ */
+int __fenix_lossy_decode(const void *stream, size_t bytes, void *dest, size_t count,
+                         int type, double bound)
+{
+    size_t value_size = type == __FENIX_LOSSY_DOUBLE ? sizeof(double) : sizeof(float);
+    const uint8_t *in = (const uint8_t *) stream;
+    const uint8_t *end = in + bytes;
+
+    fenix_lossy_history_t history = { 0, 0 };
+    for (size_t first = 0; first < count; first += __FENIX_LOSSY_BLOCK) {
+        size_t n = count - first < __FENIX_LOSSY_BLOCK ? count - first : __FENIX_LOSSY_BLOCK;
+        if (in >= end) return FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+        uint8_t header = *in++;
+
+        if (header == __FENIX_LOSSY_RAW) {
+            if ((size_t) (end - in) < n * value_size) return FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+            memcpy((uint8_t *) dest + first * value_size, in, n * value_size);
+            in += n * value_size;
+            for (size_t i = 0; i < n; i++) {
+                __fenix_lossy_push(&history, __fenix_lossy_load(dest, first + i, type));
+            }
+            continue;
+        }
+
+        int width = header & ~__FENIX_LOSSY_LINEAR;
+        int linear = (header & __FENIX_LOSSY_LINEAR) != 0;
+        if ((size_t) (end - in) < (width * n + 7) / 8) return FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+
+        uint64_t pending = 0;
+        int pending_bits = 0;
+        for (size_t i = 0; i < n; i++) {
+            while (pending_bits < width) {
+                pending |= (uint64_t) *in++ << pending_bits;
+                pending_bits += 8;
+            }
+            uint32_t zigzag = width == 0 ? 0 : (uint32_t) (pending & ((((uint64_t) 1) << width) - 1));
+            pending >>= width;
+            pending_bits -= width;
+
+            int64_t code = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+            double value = __fenix_lossy_decoded(&history, linear, code, type, bound);
+            if (type == __FENIX_LOSSY_DOUBLE) {
+                ((double *) dest)[first + i] = value;
+            } else {
+                ((float *) dest)[first + i] = (float) value;
+            }
+            __fenix_lossy_push(&history, value);
+        }
+    }
+    return FENIX_SUCCESS;
+}
@@ -53,10 +53,13 @@
 // ************************************************************************
 //@HEADER
 */
+#include "fenix-config.h"
 #include "fenix_process_recovery.h"
 #include "fenix_comm_list.h"
+#include "fenix_progress.h"
 #include <mpi.h>
 #include <assert.h>
+#include <sched.h>
 #include "fenix_ext.h"
 
 static inline 
@@ -74,3 +77,70 @@ int __fenix_notify_newcomm(int ret, MPI_Comm *newcomm)
 
    return ret;
 }
+
+#ifdef FENIX_PMPI_PROGRESS
+/* 
+ * Blocking waits drive Fenix's in-flight stores while the app's own
+ * operation is incomplete. With nothing posted, or a progress thread doing
+ * the driving, they go straight to the PMPI call.
+ */
+
+/* One turn of a wait: drive Fenix's operations, then give up the core, which
+ * on an oversubscribed node may belong to the rank we are waiting for. */
+static inline void __fenix_wait_turn()
+{
+   __fenix_progress_poll();
+   sched_yield();
+}
+
+int MPI_Wait(MPI_Request *request, MPI_Status *status)
+{
+   if (__fenix_progress_idle()) return PMPI_Wait(request, status);
+
+   int flag = 0;
+   int ret;
+   while ((ret = PMPI_Test(request, &flag, status)) == MPI_SUCCESS && !flag) {
+      __fenix_wait_turn();
+   }
+   return ret;
+}
+
+int MPI_Waitall(int count, MPI_Request array_of_requests[], MPI_Status array_of_statuses[])
+{
+   if (__fenix_progress_idle()) {
+      return PMPI_Waitall(count, array_of_requests, array_of_statuses);
+   }
+
+   int flag = 0;
+   int ret;
+   while ((ret = PMPI_Testall(count, array_of_requests, &flag, array_of_statuses)) == MPI_SUCCESS
+            && !flag) {
+      __fenix_wait_turn();
+   }
+   return ret;
+}
+
+int MPI_Waitany(int count, MPI_Request array_of_requests[], int *index, MPI_Status *status)
+{
+   if (__fenix_progress_idle()) {
+      return PMPI_Waitany(count, array_of_requests, index, status);
+   }
+
+   int flag = 0;
+   int ret;
+   while ((ret = PMPI_Testany(count, array_of_requests, index, &flag, status)) == MPI_SUCCESS
+            && !flag) {
+      __fenix_wait_turn();
+   }
+   return ret;
+}
+
+int MPI_Barrier(MPI_Comm comm)
+{
+   //Every rank has to make the same kind of barrier call, blocking and
+   //non-blocking ones don't match. So a rank with stores in flight finishes
+   //them first, its partners progress their side inside their own barrier.
+   while (!__fenix_progress_idle()) __fenix_wait_turn();
+   return PMPI_Barrier(comm);
+}
+#endif
@@ -62,8 +62,14 @@
 #include "fenix_process_recovery.h"
 #include "fenix_data_group.h"
 #include "fenix_data_recovery.h"
+#include "fenix_data_request.h"
 #include "fenix_opt.h"
 #include "fenix_util.h"
+#include "fenix_progress.h"
+#include "fenix_copy.h"
+#include "fenix_standby.h"
+#include "fenix_dirty.h"
+#include "fenix_warning.h"
 #include <mpi.h>
 #include <mpi-ext.h>
 
@@ -90,9 +96,17 @@ int __fenix_preinit(int *role, MPI_Comm comm, MPI_Comm *new_comm, int *argc, cha
     fenix.recover_environment = jump_environment;
     fenix.role = FENIX_ROLE_INITIAL_RANK;
     fenix.fail_world_size = 0;
-    fenix.ignore_errs = 0;
+    __fenix_set_ignore_errs(0);
     fenix.resume_mode = __FENIX_RESUME_AT_INIT;
     fenix.repair_result = 0;
+    fenix.memory_budget = 0;
+    fenix.reprotect_bytes = __FENIX_DEFAULT_REPROTECT_BYTES;
+    fenix.imr_rma = 0;
+    fenix.hot_standby = 0;
+    fenix.dirty_tracking = 0;
+    fenix.warning_rebalance = 0;
+    fenix.sdc_callback = NULL;
+    fenix.sdc_callback_data = NULL;
     fenix.ret_role = role;
     fenix.ret_error = error;
 
@@ -109,6 +123,13 @@ int __fenix_preinit(int *role, MPI_Comm comm, MPI_Comm *new_comm, int *argc, cha
 
     MPI_Op_create((MPI_User_function *) __fenix_ranks_agree, 1, &fenix.agree_op);
 
+    char *failure_stats_file = NULL;
+    double default_mtbf = 0;
+    int progress_core = __FENIX_PROGRESS_OFF;
+    int copy_threads = 1;
+    int warning_signal = __FENIX_WARNING_NO_SIGNAL;
+    char *warning_file = NULL;
+
     /* Check the values in info */
     if (info != MPI_INFO_NULL) {
         char value[MPI_MAX_INFO_VAL + 1];
@@ -157,14 +178,112 @@ int __fenix_preinit(int *role, MPI_Comm comm, MPI_Comm *new_comm, int *argc, cha
                 fenix.print_unhandled = 0;
             }
         }
+
+        MPI_Info_get(info, "FENIX_FAILURE_STATS_FILE", vallen, value, &flag);
+        if (flag == 1) {
+            failure_stats_file = strdup(value);
+        }
+
+        MPI_Info_get(info, "FENIX_MTBF", vallen, value, &flag);
+        if (flag == 1) {
+            default_mtbf = atof(value);
+        }
+
+        MPI_Info_get(info, "FENIX_MEMORY_BUDGET", vallen, value, &flag);
+        if (flag == 1) {
+            fenix.memory_budget = strtoull(value, NULL, 10);
+        }
+
+        MPI_Info_get(info, "FENIX_REPROTECT_BYTES", vallen, value, &flag);
+        if (flag == 1) {
+            fenix.reprotect_bytes = strtoull(value, NULL, 10);
+        }
+
+        MPI_Info_get(info, "FENIX_IMR_TRANSPORT", vallen, value, &flag);
+        if (flag == 1) {
+            //RMA puts partner stores in place, SENDRECV (default) exchanges them.
+            fenix.imr_rma = strcmp(value, "RMA") == 0;
+        }
+
+        MPI_Info_get(info, "FENIX_HOT_STANDBY", vallen, value, &flag);
+        if (flag == 1) {
+            //ON keeps the spares supplied with the snapshots of the ranks they would replace.
+            fenix.hot_standby = strcmp(value, "ON") == 0;
+        }
+
+        MPI_Info_get(info, "FENIX_DIRTY_TRACKING", vallen, value, &flag);
+        if (flag == 1) {
+            //ON has the kernel's soft-dirty bits tell which pages a store has to copy.
+            fenix.dirty_tracking = strcmp(value, "ON") == 0;
+        }
+
+        MPI_Info_get(info, "FENIX_WARNING_SIGNAL", vallen, value, &flag);
+        if (flag == 1) {
+            //A health monitor warns of an imminent failure with SIGUSR1, SIGUSR2 or
+            //the signal numbered.
+            if (strcmp(value, "SIGUSR1") == 0) {
+                warning_signal = SIGUSR1;
+            } else if (strcmp(value, "SIGUSR2") == 0) {
+                warning_signal = SIGUSR2;
+            } else if (strcmp(value, "OFF") != 0) {
+                warning_signal = atoi(value);
+            }
+        }
+
+        MPI_Info_get(info, "FENIX_WARNING_FILE", vallen, value, &flag);
+        if (flag == 1) {
+            //Or by creating or touching this file.
+            warning_file = strdup(value);
+        }
+
+        MPI_Info_get(info, "FENIX_WARNING_REBALANCE", vallen, value, &flag);
+        if (flag == 1) {
+            //ON has a warned rank push its snapshots to its hot standby at once.
+            fenix.warning_rebalance = strcmp(value, "ON") == 0;
+        }
+
+        MPI_Info_get(info, "FENIX_PROGRESS_THREAD", vallen, value, &flag);
+        if (flag == 1) {
+            //ON starts an unpinned thread, a number pins it to that core.
+            if (strcmp(value, "ON") == 0) {
+                progress_core = __FENIX_PROGRESS_UNPINNED;
+            } else if (strcmp(value, "OFF") != 0) {
+                progress_core = atoi(value);
+            }
+        }
+
+        MPI_Info_get(info, "FENIX_COPY_THREADS", vallen, value, &flag);
+        if (flag == 1) {
+            copy_threads = atoi(value);
+        }
     }
 
+    __fenix_failure_stats_init(&fenix.failure_stats, failure_stats_file,
+                               default_mtbf, fenix.world);
+    free(failure_stats_file);
+
     if (fenix.spare_ranks >= __fenix_get_world_size(comm)) {
         debug_print("Fenix: <%d> spare ranks requested are unavailable\n",
                     fenix.spare_ranks);
     }
 
+    int provided;
+    MPI_Query_thread(&provided);
+    fenix.thread_multiple = provided == MPI_THREAD_MULTIPLE;
+
     fenix.data_recovery = __fenix_data_recovery_init();
+    __fenix_progress_init(progress_core);
+    __fenix_copy_init(copy_threads);
+    __fenix_warning_init(warning_signal, warning_file);
+    free(warning_file);
+    if (fenix.warning_rebalance && !fenix.hot_standby && fenix.options.verbose == 59) {
+        verbose_print("rank: %d, no hot standby to rebalance warned ranks onto\n",
+                      __fenix_get_current_rank(fenix.world));
+    }
+    if (fenix.dirty_tracking && !__fenix_dirty_init() && fenix.options.verbose == 57) {
+        verbose_print("rank: %d, no soft-dirty bits, full stores only\n",
+                      __fenix_get_current_rank(fenix.world));
+    }
 
     /*****************************************************/
     /* Note: fenix.new_world is only valid for the   */
@@ -207,8 +326,15 @@ int __fenix_preinit(int *role, MPI_Comm comm, MPI_Comm *new_comm, int *argc, cha
         int a;
         int myrank;
         MPI_Status mpi_status;
-        ret = PMPI_Recv(&a, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, fenix.world,
-                        &mpi_status); // listen for a failure
+        ret = PMPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, fenix.world,
+                         &mpi_status); // listen for a failure
+        if (ret == MPI_SUCCESS && mpi_status.MPI_TAG == __FENIX_STANDBY_TAG) {
+            ret = __fenix_standby_recv(&mpi_status);
+            if (ret == MPI_SUCCESS) continue;
+        } else if (ret == MPI_SUCCESS) {
+            ret = PMPI_Recv(&a, 1, MPI_INT, mpi_status.MPI_SOURCE, mpi_status.MPI_TAG,
+                            fenix.world, &mpi_status);
+        }
         if (ret == MPI_SUCCESS) {
             if (fenix.options.verbose == 0) {
                 verbose_print("Finalize the program; rank: %d, role: %d\n",
@@ -287,6 +413,11 @@ int __fenix_repair_ranks()
     int flag_g_world_freed = 0;
     MPI_Comm world_without_failures;
 
+    /* In-flight data movement is on the old communicators, stop driving it */
+    __fenix_progress_abandon_all();
+    __fenix_standby_abandon();
+    __fenix_data_release_held();
+
     while (!repair_success) {
         repair_success = 1;
         ret = MPIX_Comm_shrink(fenix.world, &world_without_failures);
@@ -513,12 +644,14 @@ int __fenix_repair_ranks()
 
             if (current_rank >= active_ranks) { // reorder ranks
                 int rank_offset = ((world_size - 1) - current_rank);
-                if (rank_offset < fenix.fail_world_size) {
+                int new_rank = __fenix_standby_assign(rank_offset, fenix.fail_world,
+                                                      fenix.fail_world_size, fenix.spare_ranks);
+                if (new_rank != -1) {
                     if (fenix.options.verbose == 2) {
                         verbose_print("reorder ranks; current_rank: %d -> new_rank: %d\n",
-                                      current_rank, fenix.fail_world[rank_offset]);
+                                      current_rank, new_rank);
                     }
-                    current_rank = fenix.fail_world[rank_offset];
+                    current_rank = new_rank;
                 }
             }
 
@@ -580,6 +713,9 @@ int __fenix_repair_ranks()
   }
 */
     }
+
+    __fenix_failure_stats_record(&fenix.failure_stats);
+
     return rt_code;
 }
 
@@ -656,7 +792,10 @@ void __fenix_finalize()
     fenix.finalized = 1;
     
     //We don't want to handle failures in here as normally, we just want to continue trying to finalize.
-    fenix.ignore_errs = 1;
+    __fenix_set_ignore_errs(1);
+
+    /* The spares must have every snapshot copy before they are told to finalize */
+    __fenix_standby_finalize();
 
     int ret = MPI_Barrier( fenix.new_world );
     if (ret != MPI_SUCCESS) {
@@ -680,11 +819,20 @@ void __fenix_finalize()
         }
     }
 
-    ret = MPI_Barrier(fenix.world);
+    /* Matches the spare ranks' barrier, which doesn't go through Fenix's own */
+    ret = PMPI_Barrier(fenix.world);
     if (ret != MPI_SUCCESS) {
         __fenix_finalize();
         return;
     }
+
+    __fenix_progress_finalize();
+    __fenix_copy_finalize();
+    __fenix_dirty_finalize();
+    __fenix_warning_finalize();
+
+    /* Persist failure history for the next run */
+    __fenix_failure_stats_destroy( &fenix.failure_stats );
     
     MPI_Op_free( &fenix.agree_op );
     MPI_Comm_set_errhandler( fenix.world, MPI_ERRORS_ARE_FATAL );
@@ -700,6 +848,7 @@ void __fenix_finalize()
 
     /* Free data recovery interface */
     __fenix_data_recovery_destroy( fenix.data_recovery );
+    __fenix_request_finalize();
 
     fenix.fenix_init_flag = 0;
 }
@@ -709,6 +858,13 @@ void __fenix_finalize_spare()
     fenix.fenix_init_flag = 0;
     int ret = PMPI_Barrier(fenix.world);
     if (ret != MPI_SUCCESS) { debug_print("MPI_Barrier: %d\n", ret); } 
+
+    __fenix_progress_finalize();
+    __fenix_copy_finalize();
+    __fenix_dirty_finalize();
+    __fenix_warning_finalize();
+    __fenix_standby_finalize();
+    __fenix_failure_stats_destroy(&fenix.failure_stats);
  
     MPI_Op_free(&fenix.agree_op);
     MPI_Comm_set_errhandler(fenix.world, MPI_ERRORS_ARE_FATAL);
@@ -733,7 +889,8 @@ void __fenix_test_MPI(MPI_Comm *pcomm, int *pret, ...)
     int ret_repair;
     int index;
     int ret = *pret;
-    if(!fenix.fenix_init_flag || __fenix_spare_rank() == 1 || fenix.ignore_errs) {
+    if(!fenix.fenix_init_flag || __fenix_spare_rank() == 1 || __fenix_ignore_errs() ||
+          __fenix_progress_on_thread()) {
         return;
     }
 
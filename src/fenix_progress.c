@@ -0,0 +1,361 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#define _GNU_SOURCE
+#include "fenix_progress.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include <mpi.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+//Posted operations sit on one list guarded by one lock. A posted operation's
+//requests are only touched with the lock held, by the progress thread or by
+//whichever app thread is driving them, so the owner only looks at the done
+//flag until it takes an operation back.
+static struct {
+    fenix_progress_op_t *head;
+    pthread_mutex_t lock;
+    pthread_cond_t posted;
+    pthread_t thread;
+    int running;
+    int stopping;
+} __fenix_progress = { .head = NULL, .lock = PTHREAD_MUTEX_INITIALIZER,
+                        .posted = PTHREAD_COND_INITIALIZER };
+
+static _Thread_local int __fenix_progress_is_thread = 0;
+
+//How long the thread sleeps between sweeps while operations are pending.
+#define __FENIX_PROGRESS_INTERVAL_NS 20000
+
+//Posted operations not yet seen to complete, read without the lock by
+//__fenix_progress_idle to keep the check cheap.
+static volatile int __fenix_progress_pending = 0;
+
+static void __fenix_progress_count()
+{
+    int pending = 0;
+    for (fenix_progress_op_t *op = __fenix_progress.head; op != NULL; op = op->next) {
+        pending += !op->done;
+    }
+    __fenix_progress_pending = pending;
+}
+
+static void __fenix_progress_unlink(fenix_progress_op_t *op)
+{
+    fenix_progress_op_t **link = &__fenix_progress.head;
+    while (*link != NULL && *link != op) link = &((*link)->next);
+    if (*link == op) *link = op->next;
+    op->posted = 0;
+    op->next = NULL;
+    __fenix_progress_count();
+}
+
+//Errors are only recorded here; the owner raises them when it collects the
+//operation, since Fenix's recovery cannot run with the lock held.
+static void __fenix_progress_advance(fenix_progress_op_t *op)
+{
+    MPI_Status *statuses = (MPI_Status *) s_malloc(op->count * sizeof(MPI_Status));
+    int flag = 0;
+    int ret = MPI_Testall(op->count, op->requests, &flag, statuses);
+    if (ret == MPI_ERR_IN_STATUS) {
+        for (int i = 0; i < op->count; i++) {
+            if (statuses[i].MPI_ERROR != MPI_SUCCESS && statuses[i].MPI_ERROR != MPI_ERR_PENDING) {
+                MPI_Error_class(statuses[i].MPI_ERROR, &(op->error));
+                break;
+            }
+        }
+    } else if (ret != MPI_SUCCESS) {
+        MPI_Error_class(ret, &(op->error));
+    }
+    op->done = flag || op->error != MPI_SUCCESS;
+    free(statuses);
+}
+
+//Advances an operation from an app thread, which stands in for the progress
+//thread meanwhile so that a failure is recorded rather than recovered from.
+static void __fenix_progress_drive(fenix_progress_op_t *op)
+{
+    int was_thread = __fenix_progress_is_thread;
+    __fenix_progress_is_thread = 1;
+    __fenix_progress_advance(op);
+    __fenix_progress_is_thread = was_thread;
+}
+
+static void *__fenix_progress_main(void *arg)
+{
+    (void) arg;
+    __fenix_progress_is_thread = 1;
+
+    pthread_mutex_lock(&__fenix_progress.lock);
+    while (!__fenix_progress.stopping) {
+        int pending = 0;
+        for (fenix_progress_op_t *op = __fenix_progress.head; op != NULL; op = op->next) {
+            if (!op->done) __fenix_progress_advance(op);
+            pending += !op->done;
+        }
+        __fenix_progress_pending = pending;
+
+        if (pending == 0) {
+            pthread_cond_wait(&__fenix_progress.posted, &__fenix_progress.lock);
+        } else {
+            struct timespec interval = { 0, __FENIX_PROGRESS_INTERVAL_NS };
+            pthread_mutex_unlock(&__fenix_progress.lock);
+            nanosleep(&interval, NULL);
+            pthread_mutex_lock(&__fenix_progress.lock);
+        }
+    }
+    pthread_mutex_unlock(&__fenix_progress.lock);
+    return NULL;
+}
+
+/**
+ * @brief Starts the progress thread, bound to core unless it is
+ *        __FENIX_PROGRESS_UNPINNED. Falls back to progressing from Fenix calls
+ *        if MPI cannot be called from a second thread.
+ * @param core
+ */
+void __fenix_progress_init(int core)
+{
+    if (core == __FENIX_PROGRESS_OFF || __fenix_progress.running) return;
+
+    int provided;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_MULTIPLE) {
+        debug_print("Fenix progress thread needs MPI_THREAD_MULTIPLE, progressing from Fenix calls instead%s\n", "");
+        return;
+    }
+
+    __fenix_progress.stopping = 0;
+    if (pthread_create(&__fenix_progress.thread, NULL, __fenix_progress_main, NULL) != 0) {
+        debug_print("Unable to start the Fenix progress thread%s\n", "");
+        return;
+    }
+    __fenix_progress.running = 1;
+
+#ifdef __linux__
+    if (core >= 0) {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        CPU_SET(core, &cores);
+        if (pthread_setaffinity_np(__fenix_progress.thread, sizeof(cores), &cores) != 0) {
+            debug_print("Unable to pin the Fenix progress thread to core %d\n", core);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Stops the progress thread. Operations still posted stay posted and
+ *        are driven by their owner's wait.
+ */
+void __fenix_progress_finalize()
+{
+    if (!__fenix_progress.running) return;
+
+    pthread_mutex_lock(&__fenix_progress.lock);
+    __fenix_progress.stopping = 1;
+    pthread_cond_signal(&__fenix_progress.posted);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+
+    pthread_join(__fenix_progress.thread, NULL);
+    __fenix_progress.running = 0;
+}
+
+/**
+ * @brief Whether the caller is the progress thread, or an app thread
+ *        driving posted operations, which must not enter failure recovery.
+ */
+int __fenix_progress_on_thread()
+{
+    return __fenix_progress_is_thread;
+}
+
+/**
+ * @brief Hands started requests over to be driven to completion.
+ * @param op
+ * @param requests
+ * @param count
+ * @param comm
+ */
+void __fenix_progress_post(fenix_progress_op_t *op, MPI_Request *requests, int count,
+                           MPI_Comm comm)
+{
+    op->requests = requests;
+    op->count = count;
+    op->done = 0;
+    op->error = MPI_SUCCESS;
+    op->comm = comm;
+
+    pthread_mutex_lock(&__fenix_progress.lock);
+    op->next = __fenix_progress.head;
+    __fenix_progress.head = op;
+    op->posted = 1;
+    __fenix_progress_pending++;
+    pthread_cond_signal(&__fenix_progress.posted);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+}
+
+//Takes a completed operation back, raising a failure it ran into through the
+//communicator's error handler as if the app thread had seen it.
+static int __fenix_progress_collect(fenix_progress_op_t *op)
+{
+    pthread_mutex_lock(&__fenix_progress.lock);
+    __fenix_progress_unlink(op);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+
+    if (op->error != MPI_SUCCESS) {
+        MPI_Comm_call_errhandler(op->comm, op->error);
+        return op->error;
+    }
+    return MPI_SUCCESS;
+}
+
+/**
+ * @brief Checks for completion of a posted operation, which is taken back
+ *        from the engine once it completes.
+ * @param op
+ * @param flag
+ */
+int __fenix_progress_test(fenix_progress_op_t *op, int *flag)
+{
+    *flag = 1;
+    if (!op->posted) return MPI_SUCCESS;
+
+    if (__fenix_progress.running) {
+        pthread_mutex_lock(&__fenix_progress.lock);
+        *flag = op->done;
+        pthread_mutex_unlock(&__fenix_progress.lock);
+    } else {
+        pthread_mutex_lock(&__fenix_progress.lock);
+        if (!op->done) __fenix_progress_drive(op);
+        *flag = op->done;
+        pthread_mutex_unlock(&__fenix_progress.lock);
+    }
+
+    return *flag ? __fenix_progress_collect(op) : MPI_SUCCESS;
+}
+
+/**
+ * @brief Blocks until a posted operation completes, taking it back.
+ * @param op
+ */
+int __fenix_progress_wait(fenix_progress_op_t *op)
+{
+    if (!op->posted) return MPI_SUCCESS;
+
+    pthread_mutex_lock(&__fenix_progress.lock);
+    int done = op->done;
+    __fenix_progress_unlink(op);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+
+    if (op->error != MPI_SUCCESS) {
+        MPI_Comm_call_errhandler(op->comm, op->error);
+        return op->error;
+    }
+    return done ? MPI_SUCCESS : MPI_Waitall(op->count, op->requests, MPI_STATUSES_IGNORE);
+}
+
+/**
+ * @brief Drops an operation without completing it, e.g. because its
+ *        communicator is being repaired.
+ * @param op
+ */
+void __fenix_progress_abandon(fenix_progress_op_t *op)
+{
+    if (!op->posted) return;
+
+    pthread_mutex_lock(&__fenix_progress.lock);
+    __fenix_progress_unlink(op);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+}
+
+/**
+ * @brief Drops every posted operation, before failure recovery.
+ */
+void __fenix_progress_abandon_all()
+{
+    pthread_mutex_lock(&__fenix_progress.lock);
+    while (__fenix_progress.head != NULL) __fenix_progress_unlink(__fenix_progress.head);
+    pthread_mutex_unlock(&__fenix_progress.lock);
+}
+
+/**
+ * @brief Whether there is nothing for the app thread to drive, either because
+ *        nothing is posted or because the progress thread drives it.
+ */
+int __fenix_progress_idle()
+{
+    return __fenix_progress.running || __fenix_progress_pending == 0;
+}
+
+/**
+ * @brief Tests each posted operation once from an app thread, for when
+ *        there is no progress thread. Failures are raised when the operation's
+ *        owner collects it. Another thread already polling is left to it.
+ */
+void __fenix_progress_poll()
+{
+    if (__fenix_progress_idle()) return;
+    if (pthread_mutex_trylock(&__fenix_progress.lock) != 0) return;
+
+    for (fenix_progress_op_t *op = __fenix_progress.head; op != NULL; op = op->next) {
+        if (!op->done) __fenix_progress_drive(op);
+    }
+    __fenix_progress_count();
+    pthread_mutex_unlock(&__fenix_progress.lock);
+}
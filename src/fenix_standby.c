@@ -0,0 +1,406 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix_standby.h"
+#include "fenix_progress.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include "fenix_ext.h"
+#include <pthread.h>
+#include <string.h>
+
+//Active ranks trickle each snapshot they commit to the spare most likely to
+//replace them, spare i of the world's last spares standing in for the
+//active ranks whose rank is i modulo the number of spares. A spare that takes
+//over then already holds most of the snapshots it has to restore.
+
+//A copy on its way to this rank's spare.
+typedef struct __fenix_standby_send {
+    int groupid;
+    int memberid;
+    void *message;
+    MPI_Request request;
+    fenix_progress_op_t op;
+    struct __fenix_standby_send *next;
+} fenix_standby_send_t;
+
+//A copy a spare holds for the active rank that sent it.
+typedef struct __fenix_standby_copy {
+    int source;
+    fenix_standby_header_t *header;    // Followed by the parts
+    uint64_t fingerprints[2];
+    uint32_t crcs[2];
+    struct __fenix_standby_copy *next;
+} fenix_standby_copy_t;
+
+static struct {
+    pthread_mutex_t lock;
+    fenix_standby_send_t *sends;
+    fenix_standby_copy_t *copies;
+} __fenix_standby = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL };
+
+//Takes back the sends that have completed. They are tested without the lock,
+//since a failed one enters recovery through the world's error handler.
+static void __fenix_standby_reap()
+{
+    pthread_mutex_lock(&__fenix_standby.lock);
+    fenix_standby_send_t *sends = __fenix_standby.sends;
+    __fenix_standby.sends = NULL;
+    pthread_mutex_unlock(&__fenix_standby.lock);
+
+    fenix_standby_send_t *pending = NULL;
+    while (sends != NULL) {
+        fenix_standby_send_t *send = sends;
+        sends = send->next;
+
+        int flag;
+        __fenix_progress_test(&(send->op), &flag);
+        if (flag) {
+            free(send->message);
+            free(send);
+        } else {
+            send->next = pending;
+            pending = send;
+        }
+    }
+
+    pthread_mutex_lock(&__fenix_standby.lock);
+    while (pending != NULL) {
+        fenix_standby_send_t *send = pending;
+        pending = send->next;
+        send->next = __fenix_standby.sends;
+        __fenix_standby.sends = send;
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+}
+
+/**
+ * @brief World rank of the spare that shadows this rank, or -1 if hot
+ *        standby is off, there are no spares left or this is a spare.
+ */
+int __fenix_standby_target()
+{
+    if (!fenix.hot_standby || fenix.spare_ranks <= 0 || __fenix_spare_rank() == 1) {
+        return -1;
+    }
+    int rank = __fenix_get_current_rank(fenix.world);
+    return __fenix_get_world_size(fenix.world) - 1 - rank % fenix.spare_ranks;
+}
+
+/**
+ * @brief Whether a member's next snapshot can be sent to the spare. Copies
+ *        are low priority, so one still on its way makes the member skip
+ *        snapshots rather than queue them.
+ * @param groupid
+ * @param memberid
+ */
+int __fenix_standby_ready(int groupid, int memberid)
+{
+    if (__fenix_standby_target() == -1) return 0;
+    __fenix_standby_reap();
+
+    int ready = 1;
+    pthread_mutex_lock(&__fenix_standby.lock);
+    for (fenix_standby_send_t *send = __fenix_standby.sends; send != NULL; send = send->next) {
+        if (send->groupid == groupid && send->memberid == memberid) ready = 0;
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+    return ready;
+}
+
+/**
+ * @brief Starts sending a snapshot's parts to the spare, in the background.
+ * @param header
+ * @param parts
+ */
+void __fenix_standby_send(fenix_standby_header_t *header, void *parts[2])
+{
+    int target = __fenix_standby_target();
+    if (target == -1) return;
+
+    size_t bytes = sizeof(fenix_standby_header_t) + header->bytes[0] + header->bytes[1];
+    fenix_standby_send_t *send = (fenix_standby_send_t *) s_calloc(1, sizeof(fenix_standby_send_t));
+    send->groupid = header->groupid;
+    send->memberid = header->memberid;
+    send->message = s_malloc(bytes);
+    memcpy(send->message, header, sizeof(fenix_standby_header_t));
+    memcpy((char *) send->message + sizeof(fenix_standby_header_t), parts[0], header->bytes[0]);
+    memcpy((char *) send->message + sizeof(fenix_standby_header_t) + header->bytes[0], parts[1],
+           header->bytes[1]);
+
+    MPI_Isend(send->message, (int) bytes, MPI_BYTE, target, __FENIX_STANDBY_TAG, fenix.world,
+              &(send->request));
+    __fenix_progress_post(&(send->op), &(send->request), 1, fenix.world);
+
+    pthread_mutex_lock(&__fenix_standby.lock);
+    send->next = __fenix_standby.sends;
+    __fenix_standby.sends = send;
+    pthread_mutex_unlock(&__fenix_standby.lock);
+}
+
+/**
+ * @brief Receives a copy a spare has probed, keeping it in place of the
+ *        sender's oldest copy of that member once it holds as many snapshots
+ *        as the sender's group does.
+ * @param status
+ */
+int __fenix_standby_recv(MPI_Status *status)
+{
+    int bytes;
+    MPI_Get_count(status, MPI_BYTE, &bytes);
+    fenix_standby_header_t *header = (fenix_standby_header_t *) s_malloc(bytes);
+    int ret = PMPI_Recv(header, bytes, MPI_BYTE, status->MPI_SOURCE, __FENIX_STANDBY_TAG,
+                        fenix.world, MPI_STATUS_IGNORE);
+    if (ret != MPI_SUCCESS) {
+        free(header);
+        return ret;
+    }
+
+    fenix_standby_copy_t *copy = (fenix_standby_copy_t *) s_calloc(1, sizeof(fenix_standby_copy_t));
+    copy->source = status->MPI_SOURCE;
+    copy->header = header;
+    char *part = (char *) (header + 1);
+    copy->fingerprints[0] = __fenix_fingerprint(part, header->bytes[0]);
+    copy->fingerprints[1] = __fenix_fingerprint(part + header->bytes[0], header->bytes[1]);
+    copy->crcs[0] = __fenix_crc32c(0, part, header->bytes[0]);
+    copy->crcs[1] = __fenix_crc32c(0, part + header->bytes[0], header->bytes[1]);
+
+    pthread_mutex_lock(&__fenix_standby.lock);
+    int held = 0;
+    fenix_standby_copy_t **oldest = NULL;
+    for (fenix_standby_copy_t **link = &__fenix_standby.copies; *link != NULL;
+         link = &((*link)->next)) {
+        fenix_standby_header_t *other = (*link)->header;
+        if ((*link)->source != copy->source || other->groupid != header->groupid ||
+            other->memberid != header->memberid) {
+            continue;
+        }
+        held++;
+        if (oldest == NULL || other->timestamp < (*oldest)->header->timestamp) oldest = link;
+    }
+    if (oldest != NULL && held >= header->keep) {
+        fenix_standby_copy_t *evicted = *oldest;
+        *oldest = evicted->next;
+        free(evicted->header);
+        free(evicted);
+    }
+    copy->next = __fenix_standby.copies;
+    __fenix_standby.copies = copy;
+    pthread_mutex_unlock(&__fenix_standby.lock);
+
+    if (fenix.options.verbose == 56) {
+        verbose_print("spare: %d, source: %d, group: %d, member: %d, timestamp: %d, bytes: %d\n",
+                      __fenix_get_current_rank(fenix.world), copy->source, header->groupid,
+                      header->memberid, header->timestamp, bytes);
+    }
+    return MPI_SUCCESS;
+}
+
+/**
+ * @brief Looks up the copy of a member's snapshot this rank received while
+ *        it was the spare of the rank it replaced.
+ * @param groupid
+ * @param memberid
+ * @param timestamp
+ * @param bytes        Expected size of each part
+ * @param parts        Set to the parts, which stay owned by the cache
+ * @param fingerprints Set to the parts' fingerprints
+ * @param crcs         Set to the parts' CRC32C, which callers check along with
+ *                     the fingerprints before trusting a part to be unchanged
+ */
+int __fenix_standby_find(int groupid, int memberid, int timestamp, size_t bytes[2],
+                         void *parts[2], uint64_t fingerprints[2], uint32_t crcs[2])
+{
+    int retval = -1;
+    int source = __fenix_get_current_rank(fenix.world);
+
+    pthread_mutex_lock(&__fenix_standby.lock);
+    for (fenix_standby_copy_t *copy = __fenix_standby.copies; copy != NULL; copy = copy->next) {
+        fenix_standby_header_t *header = copy->header;
+        if (copy->source == source && header->groupid == groupid &&
+            header->memberid == memberid && header->timestamp == timestamp &&
+            header->bytes[0] == bytes[0] && header->bytes[1] == bytes[1]) {
+            parts[0] = (char *) (header + 1);
+            parts[1] = (char *) (header + 1) + header->bytes[0];
+            fingerprints[0] = copy->fingerprints[0];
+            fingerprints[1] = copy->fingerprints[1];
+            crcs[0] = copy->crcs[0];
+            crcs[1] = copy->crcs[1];
+            retval = FENIX_SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+    return retval;
+}
+
+/**
+ * @brief Frees the copies of a member once it has been restored.
+ * @param groupid
+ * @param memberid
+ */
+void __fenix_standby_drop(int groupid, int memberid)
+{
+    pthread_mutex_lock(&__fenix_standby.lock);
+    fenix_standby_copy_t **link = &__fenix_standby.copies;
+    while (*link != NULL) {
+        fenix_standby_copy_t *copy = *link;
+        if (copy->header->groupid == groupid && copy->header->memberid == memberid) {
+            *link = copy->next;
+            free(copy->header);
+            free(copy);
+        } else {
+            link = &(copy->next);
+        }
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+}
+
+/**
+ * @brief The rank the spare at rank_offset from the end of the world takes
+ *        over, or -1 if it stays a spare. Each failed rank goes to the spare
+ *        that shadows it if that spare is free, the rest to the free spares
+ *        in order. Without hot standby spares are used in order.
+ * @param rank_offset
+ * @param fail_world      Failed ranks, in increasing order
+ * @param fail_world_size
+ * @param spare_ranks     Spares before the repair, at least fail_world_size
+ */
+int __fenix_standby_assign(int rank_offset, int *fail_world, int fail_world_size,
+                           int spare_ranks)
+{
+    if (!fenix.hot_standby) {
+        return rank_offset < fail_world_size ? fail_world[rank_offset] : -1;
+    }
+
+    int *assigned = (int *) s_malloc(spare_ranks * sizeof(int));
+    int *placed = (int *) s_calloc(fail_world_size, sizeof(int));
+    for (int spare = 0; spare < spare_ranks; spare++) assigned[spare] = -1;
+
+    for (int index = 0; index < fail_world_size; index++) {
+        int shadow = fail_world[index] % spare_ranks;
+        if (assigned[shadow] == -1) {
+            assigned[shadow] = fail_world[index];
+            placed[index] = 1;
+        }
+    }
+    int spare = 0;
+    for (int index = 0; index < fail_world_size; index++) {
+        if (placed[index]) continue;
+        while (assigned[spare] != -1) spare++;
+        assigned[spare] = fail_world[index];
+    }
+
+    int rank = assigned[rank_offset];
+    free(assigned);
+    free(placed);
+    return rank;
+}
+
+/**
+ * @brief Forgets the copies still being sent, which are on the world
+ *        communicator that is being repaired.
+ */
+void __fenix_standby_abandon()
+{
+    pthread_mutex_lock(&__fenix_standby.lock);
+    while (__fenix_standby.sends != NULL) {
+        fenix_standby_send_t *send = __fenix_standby.sends;
+        __fenix_standby.sends = send->next;
+        __fenix_progress_abandon(&(send->op));
+        free(send->message);
+        free(send);
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+}
+
+/**
+ * @brief Completes the copies still being sent. Every member is then ready
+ *        for its next snapshot to be sent.
+ */
+void __fenix_standby_flush()
+{
+    pthread_mutex_lock(&__fenix_standby.lock);
+    fenix_standby_send_t *sends = __fenix_standby.sends;
+    __fenix_standby.sends = NULL;
+    pthread_mutex_unlock(&__fenix_standby.lock);
+
+    while (sends != NULL) {
+        fenix_standby_send_t *send = sends;
+        sends = send->next;
+        __fenix_progress_wait(&(send->op));
+        free(send->message);
+        free(send);
+    }
+}
+
+/**
+ * @brief Completes the copies still being sent, so that the spares have
+ *        them before they are told to finalize, and frees the ones held.
+ */
+void __fenix_standby_finalize()
+{
+    __fenix_standby_flush();
+
+    pthread_mutex_lock(&__fenix_standby.lock);
+    while (__fenix_standby.copies != NULL) {
+        fenix_standby_copy_t *copy = __fenix_standby.copies;
+        __fenix_standby.copies = copy->next;
+        free(copy->header);
+        free(copy);
+    }
+    pthread_mutex_unlock(&__fenix_standby.lock);
+}
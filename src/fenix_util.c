@@ -57,6 +57,14 @@
 #include "fenix_opt.h"
 #include "fenix_process_recovery.h"
 #include "fenix_util.h"
+#include <pthread.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define __FENIX_CRC32C_X86 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
 /**
  * @brief
@@ -163,6 +171,268 @@ int __fenix_mpi_test(MPI_Request *request) {
   return flag;
 }
 
+//Byte-count wrappers for transfers which may exceed INT_MAX bytes.
+//MPI 4 has native large-count calls, older MPIs get the data in chunks of
+//at most __FENIX_MAX_MSG_BYTES. A zero byte transfer still sends one message
+//so that message matching is the same as a plain MPI call.
+static int __fenix_num_chunks(size_t bytes) {
+  return bytes == 0 ? 1 : (int)((bytes - 1) / __FENIX_MAX_MSG_BYTES + 1);
+}
+
+static int __fenix_chunk_size(size_t bytes, int chunk) {
+  size_t remaining = bytes - (size_t)chunk * __FENIX_MAX_MSG_BYTES;
+  return (int)(remaining < __FENIX_MAX_MSG_BYTES ? remaining : __FENIX_MAX_MSG_BYTES);
+}
+
+int __fenix_mpi_send_bytes(const void *buf, size_t bytes, int dest, int tag, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+  return MPI_Send_c(buf, (MPI_Count)bytes, MPI_BYTE, dest, tag, comm);
+#else
+  int result = MPI_SUCCESS;
+  int chunks = __fenix_num_chunks(bytes);
+  for (int chunk = 0; chunk < chunks && result == MPI_SUCCESS; chunk++) {
+    result = MPI_Send((const char *)buf + (size_t)chunk * __FENIX_MAX_MSG_BYTES,
+                      __fenix_chunk_size(bytes, chunk), MPI_BYTE, dest, tag, comm);
+  }
+  return result;
+#endif
+}
+
+int __fenix_mpi_recv_bytes(void *buf, size_t bytes, int src, int tag, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+  return MPI_Recv_c(buf, (MPI_Count)bytes, MPI_BYTE, src, tag, comm, MPI_STATUS_IGNORE);
+#else
+  int result = MPI_SUCCESS;
+  int chunks = __fenix_num_chunks(bytes);
+  for (int chunk = 0; chunk < chunks && result == MPI_SUCCESS; chunk++) {
+    result = MPI_Recv((char *)buf + (size_t)chunk * __FENIX_MAX_MSG_BYTES,
+                      __fenix_chunk_size(bytes, chunk), MPI_BYTE, src, tag, comm,
+                      MPI_STATUS_IGNORE);
+  }
+  return result;
+#endif
+}
+
+int __fenix_mpi_sendrecv_bytes(const void *sendbuf, size_t sendbytes, int dest, int sendtag,
+                               void *recvbuf, size_t recvbytes, int src, int recvtag,
+                               MPI_Comm comm) {
+#if MPI_VERSION >= 4
+  return MPI_Sendrecv_c(sendbuf, (MPI_Count)sendbytes, MPI_BYTE, dest, sendtag,
+                        recvbuf, (MPI_Count)recvbytes, MPI_BYTE, src, recvtag, comm,
+                        MPI_STATUS_IGNORE);
+#else
+  //The two directions may need a different number of chunks, so once one
+  //side runs out it talks to MPI_PROC_NULL.
+  int result = MPI_SUCCESS;
+  int send_chunks = __fenix_num_chunks(sendbytes);
+  int recv_chunks = __fenix_num_chunks(recvbytes);
+  int chunks = send_chunks > recv_chunks ? send_chunks : recv_chunks;
+  for (int chunk = 0; chunk < chunks && result == MPI_SUCCESS; chunk++) {
+    int sending = chunk < send_chunks, receiving = chunk < recv_chunks;
+    result = MPI_Sendrecv(
+        (const char *)sendbuf + (sending ? (size_t)chunk * __FENIX_MAX_MSG_BYTES : 0),
+        sending ? __fenix_chunk_size(sendbytes, chunk) : 0, MPI_BYTE,
+        sending ? dest : MPI_PROC_NULL, sendtag,
+        (char *)recvbuf + (receiving ? (size_t)chunk * __FENIX_MAX_MSG_BYTES : 0),
+        receiving ? __fenix_chunk_size(recvbytes, chunk) : 0, MPI_BYTE,
+        receiving ? src : MPI_PROC_NULL, recvtag, comm, MPI_STATUS_IGNORE);
+  }
+  return result;
+#endif
+}
+
+int __fenix_mpi_reduce_bytes(const void *sendbuf, void *recvbuf, size_t bytes, MPI_Op op,
+                             int root, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+  return MPI_Reduce_c(sendbuf, recvbuf, (MPI_Count)bytes, MPI_BYTE, op, root, comm);
+#else
+  int result = MPI_SUCCESS;
+  int chunks = __fenix_num_chunks(bytes);
+  for (int chunk = 0; chunk < chunks && result == MPI_SUCCESS; chunk++) {
+    size_t offset = (size_t)chunk * __FENIX_MAX_MSG_BYTES;
+    result = MPI_Reduce((const char *)sendbuf + offset, (char *)recvbuf + offset,
+                        __fenix_chunk_size(bytes, chunk), MPI_BYTE, op, root, comm);
+  }
+  return result;
+#endif
+}
+
+//Persistent counterpart of __fenix_mpi_sendrecv_bytes. Makes the requests, at most
+//__fenix_mpi_sendrecv_init_count() of them, and returns how many were made. The
+//exchange happens whenever they are started together. MPI_Startall may start
+//them in any order, so each chunk goes with its own tag, the given one plus the
+//chunk's index, rather than relying on messages not overtaking each other.
+int __fenix_mpi_sendrecv_init_count(size_t sendbytes, size_t recvbytes) {
+#if MPI_VERSION >= 4
+  return 2;
+#else
+  return __fenix_num_chunks(sendbytes) + __fenix_num_chunks(recvbytes);
+#endif
+}
+
+int __fenix_mpi_sendrecv_init_bytes(const void *sendbuf, size_t sendbytes, int dest, int sendtag,
+                                    void *recvbuf, size_t recvbytes, int src, int recvtag,
+                                    MPI_Comm comm, MPI_Request *requests) {
+#if MPI_VERSION >= 4
+  MPI_Send_init_c(sendbuf, (MPI_Count)sendbytes, MPI_BYTE, dest, sendtag, comm, requests);
+  MPI_Recv_init_c(recvbuf, (MPI_Count)recvbytes, MPI_BYTE, src, recvtag, comm, requests + 1);
+  return 2;
+#else
+  int made = 0;
+  for (int chunk = 0; chunk < __fenix_num_chunks(sendbytes); chunk++) {
+    MPI_Send_init((const char *)sendbuf + (size_t)chunk * __FENIX_MAX_MSG_BYTES,
+                  __fenix_chunk_size(sendbytes, chunk), MPI_BYTE, dest, sendtag + chunk, comm,
+                  requests + made++);
+  }
+  for (int chunk = 0; chunk < __fenix_num_chunks(recvbytes); chunk++) {
+    MPI_Recv_init((char *)recvbuf + (size_t)chunk * __FENIX_MAX_MSG_BYTES,
+                  __fenix_chunk_size(recvbytes, chunk), MPI_BYTE, src, recvtag + chunk, comm,
+                  requests + made++);
+  }
+  return made;
+#endif
+}
+
+int __fenix_mpi_reduce_local_bytes(const void *inbuf, void *inoutbuf, size_t bytes, MPI_Op op) {
+#if MPI_VERSION >= 4
+  return MPI_Reduce_local_c(inbuf, inoutbuf, (MPI_Count)bytes, MPI_BYTE, op);
+#else
+  int result = MPI_SUCCESS;
+  int chunks = __fenix_num_chunks(bytes);
+  for (int chunk = 0; chunk < chunks && result == MPI_SUCCESS; chunk++) {
+    size_t offset = (size_t)chunk * __FENIX_MAX_MSG_BYTES;
+    result = MPI_Reduce_local((const char *)inbuf + offset, (char *)inoutbuf + offset,
+                              __fenix_chunk_size(bytes, chunk), MPI_BYTE, op);
+  }
+  return result;
+#endif
+}
+
+//64-bit finalizer from MurmurHash3.
+static uint64_t __fenix_mix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * @brief       Content fingerprint of a block of bytes. Not cryptographic and
+ *              different blocks can collide, so callers deciding two blocks
+ *              are equal must also compare their CRC32C.
+ * @param buf
+ * @param bytes
+ */
+uint64_t __fenix_fingerprint(const void *buf, size_t bytes) {
+  const unsigned char *p = (const unsigned char *) buf;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t) bytes;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p + i, sizeof(uint64_t));
+    h = (h ^ __fenix_mix64(word)) * 0x9e3779b97f4a7c15ULL;
+    h = (h << 31) | (h >> 33);
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, p + i, bytes - i);
+  return __fenix_mix64(h ^ __fenix_mix64(tail ^ 0x5851f42d4c957f2dULL));
+}
+
+//Software CRC32C (Castagnoli polynomial, reflected), sliced 8 bytes at a time.
+//The table is filled once, whichever thread checksums first.
+static uint32_t __fenix_crc32c_table[8][256];
+static pthread_once_t __fenix_crc32c_table_once = PTHREAD_ONCE_INIT;
+
+static void __fenix_crc32c_init_table(void) {
+  for (int i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0x82f63b78U & (0U - (crc & 1)));
+    }
+    __fenix_crc32c_table[0][i] = crc;
+  }
+  for (int i = 0; i < 256; i++) {
+    for (int slice = 1; slice < 8; slice++) {
+      uint32_t prev = __fenix_crc32c_table[slice - 1][i];
+      __fenix_crc32c_table[slice][i] = (prev >> 8) ^ __fenix_crc32c_table[0][prev & 0xff];
+    }
+  }
+}
+
+static uint32_t __fenix_crc32c_sw(uint32_t crc, const unsigned char *p, size_t len) {
+  pthread_once(&__fenix_crc32c_table_once, __fenix_crc32c_init_table);
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    word ^= crc;
+    crc = __fenix_crc32c_table[7][word & 0xff] ^
+          __fenix_crc32c_table[6][(word >> 8) & 0xff] ^
+          __fenix_crc32c_table[5][(word >> 16) & 0xff] ^
+          __fenix_crc32c_table[4][(word >> 24) & 0xff] ^
+          __fenix_crc32c_table[3][(word >> 32) & 0xff] ^
+          __fenix_crc32c_table[2][(word >> 40) & 0xff] ^
+          __fenix_crc32c_table[1][(word >> 48) & 0xff] ^
+          __fenix_crc32c_table[0][word >> 56];
+  }
+  for (; len > 0; len--, p++) {
+    crc = (crc >> 8) ^ __fenix_crc32c_table[0][(crc ^ *p) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__FENIX_CRC32C_X86)
+__attribute__((target("sse4.2")))
+static uint32_t __fenix_crc32c_hw(uint32_t crc, const unsigned char *p, size_t len) {
+  uint64_t crc64 = crc;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = (uint32_t) crc64;
+  for (; len > 0; len--, p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return crc;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+static uint32_t __fenix_crc32c_hw(uint32_t crc, const unsigned char *p, size_t len) {
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc = __crc32cd(crc, word);
+  }
+  for (; len > 0; len--, p++) {
+    crc = __crc32cb(crc, *p);
+  }
+  return crc;
+}
+#endif
+
+/**
+ * @brief     CRC32C of a block of bytes, using the CPU's crc32 instruction
+ *            when it has one.
+ * @param crc CRC of the preceding bytes, 0 to start.
+ * @param buf
+ * @param len
+ */
+uint32_t __fenix_crc32c(uint32_t crc, const void *buf, size_t len) {
+  const unsigned char *p = (const unsigned char *) buf;
+  crc = ~crc;
+#if defined(__FENIX_CRC32C_X86)
+  //Only reads what libgcc found at startup, so it is cheap and thread safe.
+  crc = __builtin_cpu_supports("sse4.2") ? __fenix_crc32c_hw(crc, p, len)
+                                         : __fenix_crc32c_sw(crc, p, len);
+#elif defined(__ARM_FEATURE_CRC32)
+  crc = __fenix_crc32c_hw(crc, p, len);
+#else
+  crc = __fenix_crc32c_sw(crc, p, len);
+#endif
+  return ~crc;
+}
+
 int __fenix_get_fenix_default_rank_separation( MPI_Comm comm  )
 {
   int size = - 1;
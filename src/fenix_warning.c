@@ -0,0 +1,178 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Rob Van der Wijngaart, and Michael Heroux
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include "fenix.h"
+#include "fenix_warning.h"
+#include "fenix_opt.h"
+#include "fenix_util.h"
+#include <signal.h>
+#include <string.h>
+#include <sys/stat.h>
+
+//A health monitor warns this rank that its node is about to fail, either with
+//a signal or by touching a file. The handler only counts the signals, and the
+//file is looked at from Fenix's own calls, so that the checkpoint the warning
+//asks for is taken at the app's next safe point.
+
+static struct {
+    volatile sig_atomic_t raised;  // Signals received
+    sig_atomic_t taken;            // Signals already acted upon
+    int signum;
+    struct sigaction previous;
+    char *file;
+    int file_seen;                 // The file existed when last looked at
+    struct timespec file_mtime;    // And was last touched then
+} __fenix_warning = { .raised = 0, .taken = 0, .signum = __FENIX_WARNING_NO_SIGNAL };
+
+static void __fenix_warning_handler(int signum)
+{
+    (void) signum;
+    __fenix_warning.raised++;
+}
+
+//Whether the file is there, and when it was last touched.
+static int __fenix_warning_stat(struct timespec *mtime)
+{
+    struct stat st;
+    if (__fenix_warning.file == NULL || stat(__fenix_warning.file, &st) != 0) return 0;
+    mtime->tv_sec = st.st_mtim.tv_sec;
+    mtime->tv_nsec = st.st_mtim.tv_nsec;
+    return 1;
+}
+
+static int __fenix_warning_file_changed(int *seen, struct timespec *mtime)
+{
+    *seen = __fenix_warning_stat(mtime);
+    return *seen && (!__fenix_warning.file_seen
+                     || mtime->tv_sec != __fenix_warning.file_mtime.tv_sec
+                     || mtime->tv_nsec != __fenix_warning.file_mtime.tv_nsec);
+}
+
+/**
+ * @brief Starts listening for failure warnings. A file that is already there
+ *        only warns once it is touched again. Returns FENIX_SUCCESS, or
+ *        FENIX_ERROR_INVALID_ATTRIBUTE_VALUE if the signal can't be caught.
+ * @param signum Signal that warns, or __FENIX_WARNING_NO_SIGNAL.
+ * @param file   File whose creation or touch warns, or NULL.
+ */
+int __fenix_warning_init(int signum, const char *file)
+{
+    int retval = FENIX_SUCCESS;
+
+    if (signum != __FENIX_WARNING_NO_SIGNAL) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = __fenix_warning_handler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(signum, &action, &__fenix_warning.previous) == 0) {
+            __fenix_warning.signum = signum;
+        } else {
+            debug_print("ERROR Fenix_Init: signal <%d> can't warn of failures\n", signum);
+            retval = FENIX_ERROR_INVALID_ATTRIBUTE_VALUE;
+        }
+    }
+
+    if (file != NULL) {
+        __fenix_warning.file = strdup(file);
+        __fenix_warning.file_seen = __fenix_warning_stat(&__fenix_warning.file_mtime);
+    }
+    return retval;
+}
+
+/**
+ * @brief Whether a warning arrived that hasn't been taken yet.
+ */
+int __fenix_warning_pending()
+{
+    int seen;
+    struct timespec mtime;
+    return __fenix_warning.raised != __fenix_warning.taken
+           || __fenix_warning_file_changed(&seen, &mtime);
+}
+
+/**
+ * @brief Takes the warnings that arrived so far, returning whether there were
+ *        any. Later ones are pending again.
+ */
+int __fenix_warning_take()
+{
+    sig_atomic_t raised = __fenix_warning.raised;
+    int warned = raised != __fenix_warning.taken;
+    __fenix_warning.taken = raised;
+
+    int seen;
+    struct timespec mtime;
+    if (__fenix_warning_file_changed(&seen, &mtime)) warned = 1;
+    __fenix_warning.file_seen = seen;
+    __fenix_warning.file_mtime = mtime;
+    return warned;
+}
+
+/**
+ * @brief Gives the signal back to its previous handler.
+ */
+void __fenix_warning_finalize()
+{
+    if (__fenix_warning.signum != __FENIX_WARNING_NO_SIGNAL) {
+        sigaction(__fenix_warning.signum, &__fenix_warning.previous, NULL);
+        __fenix_warning.signum = __FENIX_WARNING_NO_SIGNAL;
+    }
+    free(__fenix_warning.file);
+    __fenix_warning.file = NULL;
+    __fenix_warning.raised = 0;
+    __fenix_warning.taken = 0;
+}
@@ -59,3 +59,18 @@
 fenix_t fenix = {
     .fenix_init_flag = 0
 };
+
+//Threads toggle this around their own MPI calls, so each keeps its own.
+static _Thread_local int __fenix_ignoring_errs = 0;
+
+int __fenix_ignore_errs()
+{
+    return __fenix_ignoring_errs;
+}
+
+int __fenix_set_ignore_errs(int ignore)
+{
+    int old = __fenix_ignoring_errs;
+    __fenix_ignoring_errs = ignore;
+    return old;
+}
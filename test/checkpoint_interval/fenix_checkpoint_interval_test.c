@@ -0,0 +1,154 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//Run with the number of failures earlier runs are said to have seen in a
+//minute, which decides whether a checkpoint is due shortly after the last.
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  int prior_failures = argc > 1 ? atoi(argv[1]) : 0;
+  int world_rank;
+  MPI_Comm_rank(world_comm, &world_rank);
+
+  //Seed the stats file Fenix loads its failure history from.
+  char stats_file[64];
+  snprintf(stats_file, sizeof(stats_file), "fenix_checkpoint_interval_stats_%d", prior_failures);
+  if(world_rank == 0){
+    FILE* file = fopen(stats_file, "w");
+    fprintf(file, "failures %d\nexposure 60\n", prior_failures);
+    fclose(file);
+  }
+  MPI_Barrier(world_comm);
+
+  //Without history, one failure per hour.
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_MTBF", "3600");
+  MPI_Info_set(info, "FENIX_FAILURE_STATS_FILE", stats_file);
+
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, info, &error);
+
+  int rank, size;
+  MPI_Comm_rank(new_comm, &rank);
+  MPI_Comm_size(new_comm, &size);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 1, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int data[1024];
+  for(int i = 0; i < 1024; i++) data[i] = rank*i;
+  Fenix_Data_member_create(1, 7, data, 1024, MPI_INT);
+
+  //Without any measurement, Fenix should ask for a checkpoint.
+  int should;
+  if(Fenix_Data_group_should_checkpoint(1, &should) != FENIX_SUCCESS || !should){
+    printf("Rank %d FAILURE: expected a checkpoint before any were measured\n", rank);
+    error = 1;
+  }
+
+  Fenix_Data_member_store(1, 7, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  //A tiny checkpoint is not due again within 10ms with an MTBF near an hour,
+  //but is with a million failures a minute, an MTBF of under 4ms.
+  usleep(10000);
+  int expected = prior_failures >= 1000000;
+  if(Fenix_Data_group_should_checkpoint(1, &should) != FENIX_SUCCESS || should != expected){
+    printf("Rank %d FAILURE: checkpoint advice %d after %d prior failures, expected %d\n",
+           rank, should, prior_failures, expected);
+    error = 1;
+  }
+
+  if(Fenix_Data_group_should_checkpoint(2, &should) != FENIX_ERROR_INVALID_GROUPID){
+    printf("Rank %d FAILURE: unknown group accepted\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+
+  //The history is written back with this run's exposure added.
+  if(rank == 0){
+    int failures = -1;
+    double exposure = -1;
+    FILE* file = fopen(stats_file, "r");
+    if(file == NULL || fscanf(file, "failures %d\nexposure %lf", &failures, &exposure) != 2 ||
+       failures != prior_failures || exposure < 60){
+      printf("FAILURE: stats file holds %d failures and %f s, expected %d and over 60 s\n",
+             failures, exposure, prior_failures);
+      error = 1;
+    }
+    if(file != NULL) fclose(file);
+    remove(stats_file);
+  }
+
+  MPI_Info_free(&info);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,167 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROWS 8
+#define COLS 6
+#define COLUMN 2
+#define NUM_PARTICLES 10
+
+typedef struct {
+  int id;
+  double value;
+  char tag;
+} particle_t;
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 1, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  //One column of a row-major matrix.
+  double matrix[ROWS][COLS];
+  MPI_Datatype column_type;
+  MPI_Type_vector(ROWS, 1, COLS, MPI_DOUBLE, &column_type);
+  MPI_Type_commit(&column_type);
+
+  //The value field of an array of structs.
+  particle_t particles[NUM_PARTICLES];
+  MPI_Datatype field_type, value_type;
+  int one = 1;
+  MPI_Aint value_offset = offsetof(particle_t, value);
+  MPI_Datatype double_type = MPI_DOUBLE;
+  MPI_Type_create_struct(1, &one, &value_offset, &double_type, &field_type);
+  MPI_Type_create_resized(field_type, 0, sizeof(particle_t), &value_type);
+  MPI_Type_commit(&value_type);
+  MPI_Type_free(&field_type);
+
+  for(int i = 0; i < ROWS; i++)
+    for(int j = 0; j < COLS; j++) matrix[i][j] = rank*100 + i*COLS + j;
+  for(int i = 0; i < NUM_PARTICLES; i++){
+    particles[i].id = i;
+    particles[i].value = rank + i*0.5;
+    particles[i].tag = 'a' + i;
+  }
+
+  Fenix_Data_member_create(1, 1, &matrix[0][COLUMN], 1, column_type);
+  Fenix_Data_member_create(1, 2, particles, NUM_PARTICLES, value_type);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_member_store(1, 2, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  //Update some of the particles, then checkpoint just those.
+  Fenix_Data_subset subset;
+  Fenix_Data_subset_create(1, 2, 5, 1, &subset);
+  for(int i = 2; i <= 5; i++) particles[i].value = -i;
+  Fenix_Data_member_store(1, 2, subset);
+  Fenix_Data_commit(1, NULL);
+  Fenix_Data_subset_delete(&subset);
+
+  //Clobber everything; restore must only write the bytes the datatypes describe.
+  for(int i = 0; i < ROWS; i++)
+    for(int j = 0; j < COLS; j++) matrix[i][j] = -1;
+  for(int i = 0; i < NUM_PARTICLES; i++){
+    particles[i].id = -1;
+    particles[i].value = -1;
+    particles[i].tag = 0;
+  }
+
+  Fenix_Data_member_restore(1, 1, &matrix[0][COLUMN], 1, FENIX_TIME_STAMP_MAX, NULL);
+  Fenix_Data_member_restore(1, 2, particles, NUM_PARTICLES, FENIX_TIME_STAMP_MAX, NULL);
+
+  for(int i = 0; i < ROWS; i++){
+    for(int j = 0; j < COLS; j++){
+      double expected = (j == COLUMN) ? rank*100 + i*COLS + j : -1;
+      if(matrix[i][j] != expected){
+        printf("Rank %d FAILURE: matrix[%d][%d] is %f, expected %f\n", rank, i, j,
+               matrix[i][j], expected);
+        error = 1;
+      }
+    }
+  }
+  for(int i = 0; i < NUM_PARTICLES; i++){
+    double expected = (i >= 2 && i <= 5) ? -i : rank + i*0.5;
+    if(particles[i].value != expected || particles[i].id != -1 || particles[i].tag != 0){
+      printf("Rank %d FAILURE: particle %d is {%d, %f, %d}, expected {-1, %f, 0}\n", rank, i,
+             particles[i].id, particles[i].value, particles[i].tag, expected);
+      error = 1;
+    }
+  }
+
+  Fenix_Finalize();
+  MPI_Type_free(&column_type);
+  MPI_Type_free(&value_type);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,144 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//Enough pages that a few written ones leave most of the member unchanged.
+#define COUNT (64*1024)
+#define STEPS 8
+
+int rank;
+int error = 0;
+int *expected;
+
+//Each step writes one stretch of the member, a different one on every rank.
+void step(int *data, int version) {
+  int stride = COUNT/STEPS;
+  int start = ((version + rank) % STEPS) * stride;
+  for(int i = start; i < start + stride/4; i++) data[i] = expected[i] = version*COUNT + i;
+}
+
+void check_restore(int version, const char *when) {
+  int *restored = (int *) malloc(COUNT * sizeof(int));
+  int ret = Fenix_Data_member_restore(1, 1, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(ret != FENIX_SUCCESS || restored[i] != expected[i]){
+      printf("Rank %d FAILURE: restore %s after step %d returned %d, element %d is %d not %d\n",
+             rank, when, version, ret, i, restored[i], expected[i]);
+      error = 1;
+      break;
+    }
+  }
+  free(restored);
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_DIRTY_TRACKING", "ON");
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, info, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  //A shallow group gives up snapshots holding data the newer ones don't.
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  expected = (int *) malloc(COUNT * sizeof(int));
+  for(int i = 0; i < COUNT; i++) data[i] = expected[i] = rank*COUNT + i;
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  int time_stamp;
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(0, "of the first store");
+
+  for(int version = 1; version <= 2*STEPS && !error; version++){
+    step(data, version);
+    Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+    //Stores within a commit interval add up too.
+    if(version % 3 == 0){
+      step(data, version + 1000);
+      Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+    }
+    Fenix_Data_commit(1, &time_stamp);
+    check_restore(version, "of a full store");
+  }
+
+  //A restore writes the member's buffer, the next store stores that too.
+  Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  step(data, 3*STEPS);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(3*STEPS, "after restoring into the member");
+
+  Fenix_Finalize();
+  free(data);
+  free(expected);
+  MPI_Info_free(&info);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
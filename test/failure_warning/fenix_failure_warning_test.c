@@ -0,0 +1,195 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define COUNT 1000
+#define WARNED 1
+
+int rank;
+int error = 0;
+
+void check_safe_point(int expected, const char *when) {
+  int checkpointed = -1;
+  int ret = Fenix_Data_safe_point(&checkpointed);
+  if(ret != FENIX_SUCCESS || checkpointed != expected){
+    printf("Rank %d FAILURE: safe point %s returned %d, checkpointed %d\n",
+           rank, when, ret, checkpointed);
+    error = 1;
+  }
+}
+
+void check_restore(int *data, int version, const char *when) {
+  int *restored = (int *) malloc(COUNT * sizeof(int));
+  int ret = Fenix_Data_member_restore(1, 1, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(ret != FENIX_SUCCESS || restored[i] != i + 1000*rank + version){
+      printf("Rank %d FAILURE: restore %s returned %d, element %d is %d\n",
+             rank, when, ret, i, restored[i]);
+      error = 1;
+      break;
+    }
+  }
+  free(restored);
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  //Every rank watches the same file, as the ranks of a node would.
+  char file[64];
+  int pid = getpid();
+  MPI_Bcast(&pid, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  snprintf(file, sizeof(file), "fenix_failure_warning.%d", pid);
+
+  //The warned rank's spare is sent its snapshots before the safe point returns.
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_WARNING_SIGNAL", "SIGUSR1");
+  MPI_Info_set(info, "FENIX_WARNING_FILE", file);
+  MPI_Info_set(info, "FENIX_WARNING_REBALANCE", "ON");
+  MPI_Info_set(info, "FENIX_HOT_STANDBY", "ON");
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 1, 0, info, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+  //A member without a buffer is left to the app.
+  Fenix_Data_member_create(1, 2, NULL, COUNT, MPI_INT);
+  for(int i = 0; i < COUNT; i++) data[i] = i + 1000*rank;
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  check_safe_point(0, "without a warning");
+
+  //A signal to one rank checkpoints every rank, with what the buffers hold now.
+  for(int i = 0; i < COUNT; i++) data[i] = i + 1000*rank + 1;
+  if(rank == WARNED) raise(SIGUSR1);
+  MPI_Barrier(new_comm);
+  Fenix_Data_group_should_checkpoint(1, &flag);
+  if(!flag){
+    printf("Rank %d FAILURE: a warning didn't advise a checkpoint\n", rank);
+    error = 1;
+  }
+  check_safe_point(1, "after a signal");
+  check_safe_point(0, "after the signal was acted upon");
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  check_restore(data, 1, "after a signal");
+
+  //So does creating the file, and touching it again.
+  for(int i = 0; i < COUNT; i++) data[i] = i + 1000*rank + 2;
+  if(rank == 0){
+    FILE *touched = fopen(file, "w");
+    fclose(touched);
+  }
+  MPI_Barrier(new_comm);
+  check_safe_point(1, "after the file was created");
+  check_restore(data, 2, "after the file was created");
+
+  for(int i = 0; i < COUNT; i++) data[i] = i + 1000*rank + 3;
+  if(rank == 0){
+    //Set apart from the creation, which may fall in the same clock tick.
+    struct timespec times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    utimensat(AT_FDCWD, file, times, 0);
+  }
+  MPI_Barrier(new_comm);
+  check_safe_point(1, "after the file was touched");
+  check_safe_point(0, "after the touch was acted upon");
+  check_restore(data, 3, "after the file was touched");
+
+  //A member some rank lacks, as a recovered rank may not have recreated it
+  //yet, is left to the app without throwing off the members every rank has.
+  Fenix_Data_group_create(2, new_comm, 0, 4, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  int *extra = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(2, 1, data, COUNT, MPI_INT);
+  if(rank != WARNED) Fenix_Data_member_create(2, 3, extra, COUNT, MPI_INT);
+  for(int i = 0; i < COUNT; i++) data[i] = i + 1000*rank + 4;
+  if(rank == WARNED) raise(SIGUSR1);
+  MPI_Barrier(new_comm);
+  check_safe_point(1, "with a member some rank lacks");
+  int *restored = (int *) malloc(COUNT * sizeof(int));
+  int ret = Fenix_Data_member_restore(2, 1, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  if(ret != FENIX_SUCCESS || restored[COUNT-1] != COUNT-1 + 1000*rank + 4){
+    printf("Rank %d FAILURE: restore with a member some rank lacks returned %d\n", rank, ret);
+    error = 1;
+  }
+  free(restored);
+
+  MPI_Barrier(new_comm);
+  if(rank == 0) unlink(file);
+
+  Fenix_Finalize();
+  free(extra);
+  free(data);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,191 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <fenix-config.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 1000
+
+int rank;
+int error = 0;
+
+void fill(int *data, int version) {
+  for(int i = 0; i < COUNT; i++) data[i] = rank*100000 + version*COUNT + i;
+}
+
+void check_restore(int group_id, int version, const char *when) {
+  int *restored = (int *) malloc(COUNT * sizeof(int));
+  int ret = Fenix_Data_member_restore(group_id, 1, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  if(ret != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore %s returned %d\n", rank, when, ret);
+    error = 1;
+  }
+  for(int i = 0; i < COUNT && ret == FENIX_SUCCESS; i++){
+    if(restored[i] != rank*100000 + version*COUNT + i){
+      printf("Rank %d FAILURE: restore %s has version %d, expected %d\n", rank, when,
+             (restored[i] - rank*100000 - i)/COUNT, version);
+      error = 1;
+      break;
+    }
+  }
+  free(restored);
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 3, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  int time_stamp;
+  fill(data, 0);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+
+  //Until the agreement completes, the previous snapshot is the restore target.
+  //Without MPIX_Comm_iagree the commit is made right away.
+  fill(data, 1);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Request request;
+  int icommit_stamp = -1;
+  Fenix_Data_icommit(1, &icommit_stamp, &request);
+#ifdef FENIX_HAVE_MPIX_COMM_IAGREE
+  check_restore(1, 0, "during icommit");
+#endif
+
+  int done = 0;
+  while(!done){
+    if(Fenix_Data_test(request, &done) != FENIX_SUCCESS && done){
+      printf("Rank %d FAILURE: icommit failed\n", rank);
+      error = 1;
+    }
+  }
+  if(icommit_stamp != time_stamp + 1){
+    printf("Rank %d FAILURE: icommit gave timestamp %d after %d\n", rank, icommit_stamp, time_stamp);
+    error = 1;
+  }
+  check_restore(1, 1, "after icommit");
+
+  //The next store completes the commit before it overwrites the new snapshot.
+  fill(data, 2);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  int barrier_stamp = -1;
+  Fenix_Data_icommit_barrier(1, &barrier_stamp, &request);
+  fill(data, 3);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  if(Fenix_Data_wait(request) != FENIX_SUCCESS || barrier_stamp != icommit_stamp + 1){
+    printf("Rank %d FAILURE: icommit_barrier gave timestamp %d\n", rank, barrier_stamp);
+    error = 1;
+  }
+  check_restore(1, 2, "after icommit_barrier");
+
+  //Restoring discarded the uncommitted store.
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(1, 3, "after the last commit");
+
+  //A data barrier completes the istores nobody waited for, here and at the
+  //partners, in mirrored and parity groups alike.
+  int size;
+  MPI_Comm_size(new_comm, &size);
+  int parity[3] = {5, 1, size};
+  Fenix_Data_group_create(2, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, parity, &flag);
+  Fenix_Data_member_create(2, 1, data, COUNT, MPI_INT);
+  for(int version = 4; version < 6; version++){
+    fill(data, version);
+    Fenix_Data_member_istore(1, 1, FENIX_DATA_SUBSET_FULL, &request);
+    Fenix_Data_member_store(2, 1, FENIX_DATA_SUBSET_FULL);
+    if(Fenix_Data_barrier(1) != FENIX_SUCCESS || Fenix_Data_barrier(2) != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: barrier of version %d failed\n", rank, version);
+      error = 1;
+    }
+    done = 0;
+    Fenix_Data_test(request, &done);
+    if(!done){
+      printf("Rank %d FAILURE: istore of version %d still pending after the barrier\n", rank,
+             version);
+      error = 1;
+    }
+    Fenix_Data_commit(1, NULL);
+    Fenix_Data_commit(2, NULL);
+  }
+  check_restore(1, 5, "after a barrier");
+  check_restore(2, 5, "of the parity group after a barrier");
+
+  if(Fenix_Data_barrier(3) != FENIX_ERROR_INVALID_GROUPID){
+    printf("Rank %d FAILURE: barrier on a missing group succeeded\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(data);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
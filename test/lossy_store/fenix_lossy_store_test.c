@@ -0,0 +1,163 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 10000
+#define BOUND 1e-6
+
+int rank;
+int error = 0;
+
+//Smooth stretches with a noisy one and a jump in between.
+double field(int i, int version) {
+  if(i >= COUNT/2 && i < COUNT/2 + 100) return ((i*2654435761u + rank + version) % 1000) / 999.0;
+  return sin(0.001*i + rank + version) + (i > 3*COUNT/4 ? 1000 : 0);
+}
+
+void check_restore(int group_id, void *expected, int is_double, double bound, const char *when) {
+  void *restored = malloc(COUNT * sizeof(double));
+  int ret = Fenix_Data_member_restore(group_id, 1, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    double got = is_double ? ((double *) restored)[i] : ((float *) restored)[i];
+    double want = is_double ? ((double *) expected)[i] : ((float *) expected)[i];
+    if(ret != FENIX_SUCCESS || !(fabs(got - want) <= bound)){
+      printf("Rank %d FAILURE: restore %s returned %d, element %d is %.12g not %.12g\n",
+             rank, when, ret, i, got, want);
+      error = 1;
+      break;
+    }
+  }
+  free(restored);
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  //Partner-only groups restore from the partner's copy, which is the lossy one.
+  int policy[3] = {FENIX_DATA_POLICY_IMR_PARTNER_ONLY, 1, 0};
+  int flag;
+  double bound = BOUND;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  double *data = (double *) malloc(COUNT * sizeof(double));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_DOUBLE);
+  Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_ERROR_BOUND, &bound, &flag);
+
+  int time_stamp;
+  for(int version = 0; version < 3 && !error; version++){
+    for(int i = 0; i < COUNT; i++) data[i] = field(i, version);
+    Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+    Fenix_Data_commit(1, &time_stamp);
+    check_restore(1, data, 1, BOUND, "of doubles");
+  }
+
+  //Subsets are coded as the elements they hold.
+  for(int i = 0; i < COUNT; i++) data[i] = field(i, 5);
+  Fenix_Data_subset subset;
+  Fenix_Data_subset_create(4, 100, 199, 1000, &subset);
+  Fenix_Data_member_store(1, 1, subset);
+  Fenix_Data_commit(1, &time_stamp);
+  double *expected = (double *) malloc(COUNT * sizeof(double));
+  for(int i = 0; i < COUNT; i++) expected[i] = (i % 1000 >= 100 && i % 1000 < 200 && i < 4000) ? data[i] : field(i, 2);
+  check_restore(1, expected, 1, BOUND, "of a subset");
+  Fenix_Data_subset_delete(&subset);
+
+  float *single = (float *) malloc(COUNT * sizeof(float));
+  Fenix_Data_member_create(1, 2, single, COUNT, MPI_FLOAT);
+  Fenix_Data_member_attr_set(1, 2, FENIX_DATA_MEMBER_ATTRIBUTE_ERROR_BOUND, &bound, &flag);
+  for(int i = 0; i < COUNT; i++) single[i] = (float) field(i, 0);
+  Fenix_Data_member_store(1, 2, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+  void *restored = malloc(COUNT * sizeof(float));
+  int ret = Fenix_Data_member_restore(1, 2, restored, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(ret != FENIX_SUCCESS || !(fabs(((float *) restored)[i] - single[i]) <= BOUND)){
+      printf("Rank %d FAILURE: restore of floats returned %d, element %d is off\n", rank, ret, i);
+      error = 1;
+      break;
+    }
+  }
+  free(restored);
+
+  //Only floating-point members of RAID-1 groups can be stored lossily.
+  int *integers = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 3, integers, COUNT, MPI_INT);
+  if(Fenix_Data_member_attr_set(1, 3, FENIX_DATA_MEMBER_ATTRIBUTE_ERROR_BOUND, &bound, &flag) !=
+     FENIX_ERROR_INVALID_ATTRIBUTE_VALUE){
+    printf("Rank %d FAILURE: an integer member took an error bound\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(data);
+  free(expected);
+  free(single);
+  free(integers);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,127 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 1000
+#define BLOCK 64
+#define SHARED 600
+
+//The first SHARED elements are the same on every rank, the rest differ.
+static int value(int rank, int version, int i){
+  return i < SHARED ? version*COUNT + i : rank*100000 + version*COUNT + i;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  //Partner-only RAID-1 restores our data from the partner's copy, so the
+  //restore shows whether deduplicated blocks were rebuilt correctly.
+  int policy[3] = {FENIX_DATA_POLICY_IMR_PARTNER_ONLY, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 1, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int data[COUNT];
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+  int block = BLOCK;
+  Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_DEDUP_BLOCK, &block, &flag);
+
+  for(int i = 0; i < COUNT; i++) data[i] = value(rank, 0, i);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  //A partial store whose serialized blocks don't line up with the first one.
+  Fenix_Data_subset subset;
+  Fenix_Data_subset_create(1, 100, 899, COUNT, &subset);
+  for(int i = 100; i < 900; i++) data[i] = value(rank, 1, i);
+  Fenix_Data_member_store(1, 1, subset);
+  Fenix_Data_subset_delete(&subset);
+  Fenix_Data_commit(1, NULL);
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  int ret = Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  if(ret != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore returned %d\n", rank, ret);
+    error = 1;
+  }
+  for(int i = 0; i < COUNT; i++){
+    int version = (i >= 100 && i < 900) ? 1 : 0;
+    if(data[i] != value(rank, version, i)){
+      printf("Rank %d FAILURE: restored element %d is %d, expected %d\n", rank, i, data[i],
+             value(rank, version, i));
+      error = 1;
+      break;
+    }
+  }
+
+  Fenix_Finalize();
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,146 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int resize(int **data, int count){
+  *data = (int *) realloc(*data, count*sizeof(int));
+  int flag;
+  Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_BUFFER, *data, &flag);
+  return Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_COUNT, &count, &flag);
+}
+
+static void fill(int *data, int count, int rank, int version){
+  for(int i = 0; i < count; i++) data[i] = rank*100000 + version*1000 + i;
+}
+
+static int check(int *data, int from, int to, int rank, int version){
+  int error = 0;
+  for(int i = from; i < to; i++){
+    if(data[i] != rank*100000 + version*1000 + i){
+      printf("Rank %d FAILURE: element %d is %d, expected version %d\n", rank, i, data[i], version);
+      error = 1;
+      break;
+    }
+  }
+  return error;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 4, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(100*sizeof(int));
+  fill(data, 100, rank, 0);
+  Fenix_Data_member_create(1, 1, data, 100, MPI_INT);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  //Grow well past the original buffers.
+  if(resize(&data, 300) != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: growing the member was rejected\n", rank);
+    error = 1;
+  }
+  fill(data, 300, rank, 1);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  //Shrink, and only checkpoint the smaller array.
+  resize(&data, 50);
+  fill(data, 50, rank, 2);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  fill(data, 50, rank, 9);
+  if(Fenix_Data_member_restore(1, 1, data, 50, FENIX_TIME_STAMP_MAX, NULL) != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore after shrinking was not complete\n", rank);
+    error = 1;
+  }
+  error |= check(data, 0, 50, rank, 2);
+
+  //Growing back again without a store: older snapshots keep their own extent,
+  //so the tail comes from the 300 element snapshot.
+  resize(&data, 300);
+  fill(data, 300, rank, 9);
+  if(Fenix_Data_member_restore(1, 1, data, 300, FENIX_TIME_STAMP_MAX, NULL) != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore after growing back was not complete\n", rank);
+    error = 1;
+  }
+  error |= check(data, 0, 50, rank, 2);
+  error |= check(data, 50, 300, rank, 1);
+
+  Fenix_Finalize();
+  free(data);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
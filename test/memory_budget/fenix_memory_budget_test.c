@@ -0,0 +1,177 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 1000
+//RAID-1 keeps our data and our partner's in each snapshot buffer, followed by
+//a checksum for each started 4 KiB.
+#define BUFFER_SIZE (2*COUNT*sizeof(int) + 2*sizeof(unsigned int))
+
+int rank;
+int error = 0;
+
+//Commits a version, after which the group must hold the snapshots of
+//versions newest down to oldest: the budget evicted everything older.
+static void checkpoint(int *data, int version, int oldest){
+  for(int i = 0; i < COUNT; i++) data[i] = rank*100000 + version*1000 + i;
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+
+  int snapshots = -1;
+  Fenix_Data_group_get_number_of_snapshots(1, &snapshots);
+  if(snapshots != version - oldest + 1){
+    printf("Rank %d FAILURE: %d snapshots after commit %d, expected %d\n", rank, snapshots,
+           version, version - oldest + 1);
+    error = 1;
+    return;
+  }
+  for(int position = 0; position < snapshots; position++){
+    int time_stamp = -1;
+    Fenix_Data_group_get_snapshot_at_position(1, position, &time_stamp);
+    if(time_stamp != version - position){
+      printf("Rank %d FAILURE: snapshot %d kept at position %d after commit %d\n", rank,
+             time_stamp, position, version);
+      error = 1;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  //Room for two committed snapshots plus the staging area.
+  char budget[32];
+  snprintf(budget, sizeof(budget), "%zu", 3*BUFFER_SIZE);
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_MEMORY_BUDGET", budget);
+
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, info, &error);
+
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 4, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int data[COUNT];
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  size_t usage, high_water;
+  Fenix_Data_group_get_memory_usage(1, &usage, &high_water);
+  if(usage != BUFFER_SIZE){
+    printf("Rank %d FAILURE: %zu bytes used after member create, expected %zu\n", rank,
+           usage, BUFFER_SIZE);
+    error = 1;
+  }
+
+  //Each commit past the first evicts the oldest snapshot.
+  checkpoint(data, 0, 0);
+  for(int version = 1; version < 6; version++) checkpoint(data, version, version - 1);
+  Fenix_Data_group_get_memory_usage(1, &usage, &high_water);
+  if(high_water > 3*BUFFER_SIZE){
+    printf("Rank %d FAILURE: high water %zu bytes with a %zu byte budget\n", rank, high_water,
+           3*BUFFER_SIZE);
+    error = 1;
+  }
+
+  //A tighter budget takes effect at the next commit, evicting both.
+  Fenix_Data_group_set_memory_budget(1, 2*BUFFER_SIZE);
+  checkpoint(data, 6, 6);
+  Fenix_Data_group_get_memory_usage(1, &usage, NULL);
+  if(usage > 2*BUFFER_SIZE){
+    printf("Rank %d FAILURE: %zu bytes used after lowering the budget\n", rank, usage);
+    error = 1;
+  }
+
+  //Ranks may set different budgets, or none; the tightest one decides for all.
+  Fenix_Data_group_set_memory_budget(1, rank == 0 ? 0 : 4*BUFFER_SIZE);
+  checkpoint(data, 7, 6);
+  checkpoint(data, 8, 6);
+  checkpoint(data, 9, 7);
+  Fenix_Data_group_set_memory_budget(1, rank == 0 ? 0 : 2*BUFFER_SIZE);
+  checkpoint(data, 10, 10);
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(data[i] != rank*100000 + 10*1000 + i){
+      printf("Rank %d FAILURE: restored element %d is %d\n", rank, i, data[i]);
+      error = 1;
+      break;
+    }
+  }
+
+  if(Fenix_Data_group_get_memory_usage(2, &usage, &high_water) != FENIX_ERROR_INVALID_GROUPID){
+    printf("Rank %d FAILURE: unknown group accepted\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  MPI_Info_free(&info);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
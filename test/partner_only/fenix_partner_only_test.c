@@ -0,0 +1,157 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define COUNT 1000
+#define HALF (COUNT/2)
+
+const int kKillID = 1;
+
+static int value(int rank, int version, int i){
+  return rank*100000 + version*COUNT + i;
+}
+
+//Checks the first half of data holds first_version and the rest second_version.
+static int check(int rank, int *data, int first_version, int second_version){
+  for(int i = 0; i < COUNT; i++){
+    if(data[i] != value(rank, i < HALF ? first_version : second_version, i)) return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  int old_rank;
+  MPI_Comm_rank(world_comm, &old_rank);
+
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 1, 0, MPI_INFO_NULL, &error);
+
+  int rank, size;
+  MPI_Comm_rank(new_comm, &rank);
+  MPI_Comm_size(new_comm, &size);
+
+  //Each rank's data is only kept by the next rank.
+  int policy[3] = {FENIX_DATA_POLICY_IMR_PARTNER_ONLY, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+
+  if(fenix_status == FENIX_ROLE_INITIAL_RANK){
+    Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+    //Timestamps 0 and 1 hold all of the member, 2 only its first half.
+    for(int version = 0; version < 3; version++){
+      for(int i = 0; i < COUNT; i++) data[i] = value(rank, version, i);
+      if(version < 2){
+        Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+      } else {
+        Fenix_Data_subset half;
+        Fenix_Data_subset_create(1, 0, HALF - 1, COUNT, &half);
+        Fenix_Data_member_store(1, 1, half);
+        Fenix_Data_subset_delete(&half);
+      }
+      Fenix_Data_commit(1, NULL);
+    }
+
+    if(old_rank == kKillID){
+      pid_t pid = getpid();
+      kill(pid, SIGTERM);
+    }
+    MPI_Barrier(new_comm);
+  } else {
+    //The killed rank kept the only copy of the previous rank's data.
+    int lost = rank == (kKillID + size - 1) % size;
+
+    //The newest data takes the newest snapshot and the one before it, which
+    //completes it. The replacement gets its data back like everyone else.
+    for(int i = 0; i < COUNT; i++) data[i] = -1;
+    int ret = Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+    if(lost ? ret == FENIX_SUCCESS : ret != FENIX_SUCCESS || !check(rank, data, 2, 1)){
+      fprintf(stderr, "Rank %d newest restore returned %d, element 0 is %d, element %d is %d\n",
+            rank, ret, data[0], COUNT - 1, data[COUNT - 1]);
+      error = 1;
+    }
+
+    //An older timestamp gets what was committed then, not what came after.
+    for(int i = 0; i < COUNT; i++) data[i] = -1;
+    ret = Fenix_Data_member_restore(1, 1, data, COUNT, 1, NULL);
+    if(lost ? ret == FENIX_SUCCESS : ret != FENIX_SUCCESS || !check(rank, data, 1, 1)){
+      fprintf(stderr, "Rank %d restore of timestamp 1 returned %d, element 0 is %d\n",
+            rank, ret, data[0]);
+      error = 1;
+    }
+  }
+
+  free(data);
+
+  Fenix_Finalize();
+  MPI_Finalize();
+
+  return error;
+}
@@ -0,0 +1,161 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 100000
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  int provided;
+  MPI_Comm world_comm, new_comm;
+
+  //Without MPI_THREAD_MULTIPLE Fenix progresses istores from its own calls instead.
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_PROGRESS_THREAD", "ON");
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, info, &error);
+  MPI_Info_free(&info);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int partner_only[3] = {11, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  Fenix_Data_group_create(2, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, partner_only, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  int *other = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+  Fenix_Data_member_create(1, 2, other, COUNT, MPI_INT);
+  Fenix_Data_member_create(2, 1, data, COUNT, MPI_INT);
+
+  for(int version = 0; version < 3; version++){
+    for(int i = 0; i < COUNT; i++){
+      data[i] = rank*1000000 + version*COUNT + i;
+      other[i] = -data[i];
+    }
+
+    Fenix_Request request, other_request;
+    Fenix_Data_member_istore(1, 1, FENIX_DATA_SUBSET_FULL, &request);
+    Fenix_Data_member_istore(1, 2, FENIX_DATA_SUBSET_FULL, &other_request);
+
+    //The local copy is already taken, so the app may move on to its next step.
+    for(int i = 0; i < COUNT; i++) other[i] = 0;
+
+    int done = 0;
+    while(!done){
+      if(Fenix_Data_test(request, &done) != FENIX_SUCCESS && done){
+        printf("Rank %d FAILURE: istore of version %d failed\n", rank, version);
+        error = 1;
+      }
+    }
+    if(Fenix_Data_wait(other_request) != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: wait for version %d failed\n", rank, version);
+      error = 1;
+    }
+    Fenix_Data_commit(1, NULL);
+
+    //A commit completes istores nobody waited for.
+    Fenix_Data_member_istore(2, 1, FENIX_DATA_SUBSET_FULL, &request);
+    Fenix_Data_commit(2, NULL);
+  }
+
+  for(int i = 0; i < COUNT; i++) data[i] = other[i] = -1;
+  int ret = Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  ret |= Fenix_Data_member_restore(1, 2, other, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  if(ret != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore returned %d\n", rank, ret);
+    error = 1;
+  }
+  for(int i = 0; i < COUNT; i++){
+    if(data[i] != rank*1000000 + 2*COUNT + i || other[i] != -data[i]){
+      printf("Rank %d FAILURE: restored element %d is %d and %d\n", rank, i, data[i], other[i]);
+      error = 1;
+      break;
+    }
+  }
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  ret = Fenix_Data_member_restore(2, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT && ret == FENIX_SUCCESS; i++){
+    if(data[i] != rank*1000000 + 2*COUNT + i){
+      printf("Rank %d FAILURE: partner-only element %d is %d\n", rank, i, data[i]);
+      error = 1;
+      break;
+    }
+  }
+  if(ret != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: partner-only restore returned %d\n", rank, ret);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(data);
+  free(other);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,161 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define COUNT 1000
+#define MEMBERS 3
+
+const int kKillID = 1;
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  int old_rank;
+  MPI_Comm_rank(world_comm, &old_rank);
+
+  //Rebuild at most one member per commit.
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_REPROTECT_BYTES", "1");
+
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 1, 0, info, &error);
+
+  int rank, size;
+  MPI_Comm_rank(new_comm, &rank);
+  MPI_Comm_size(new_comm, &size);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int* data[MEMBERS];
+  for(int m = 0; m < MEMBERS; m++){
+    data[m] = (int*) malloc(COUNT*sizeof(int));
+  }
+
+  if(fenix_status == FENIX_ROLE_INITIAL_RANK){
+    for(int m = 0; m < MEMBERS; m++){
+      for(int i = 0; i < COUNT; i++) data[m][i] = rank*MEMBERS*COUNT + m*COUNT + i;
+      Fenix_Data_member_create(1, m, data[m], COUNT, MPI_INT);
+      Fenix_Data_member_store(1, m, FENIX_DATA_SUBSET_FULL);
+    }
+    Fenix_Data_commit(1, NULL);
+
+    if(old_rank == kKillID){
+      pid_t pid = getpid();
+      kill(pid, SIGTERM);
+    }
+    MPI_Barrier(new_comm);
+  } else {
+    //Only restore the first member, the rest must be rebuilt by later commits.
+    Fenix_Data_member_restore(1, 0, data[0], COUNT, FENIX_TIME_STAMP_MAX, NULL);
+
+    int pending;
+    Fenix_Data_group_get_reprotect_pending(1, &pending);
+    if(pending != MEMBERS-1){
+      fprintf(stderr, "Rank %d expected %d members pending after restore, got %d\n",
+            rank, MEMBERS-1, pending);
+      error = 1;
+    }
+
+    int commits = 0;
+    while(pending > 0 && commits <= MEMBERS){
+      Fenix_Data_commit(1, NULL);
+      Fenix_Data_group_get_reprotect_pending(1, &pending);
+      commits++;
+    }
+    if(pending != 0){
+      fprintf(stderr, "Rank %d still has %d members pending after %d commits\n",
+            rank, pending, commits);
+      error = 1;
+    }
+
+    //Every member must be fully protected again, including on the replacement rank.
+    for(int m = 1; m < MEMBERS; m++){
+      for(int i = 0; i < COUNT; i++) data[m][i] = -1;
+      int ret = Fenix_Data_member_restore(1, m, data[m], COUNT, FENIX_TIME_STAMP_MAX, NULL);
+      int mismatches = 0;
+      for(int i = 0; i < COUNT; i++){
+        if(data[m][i] != rank*MEMBERS*COUNT + m*COUNT + i) mismatches++;
+      }
+      if(ret != FENIX_SUCCESS || mismatches){
+        fprintf(stderr, "Rank %d member %d restore returned %d with %d mismatches\n",
+              rank, m, ret, mismatches);
+        error = 1;
+      }
+    }
+  }
+
+  for(int m = 0; m < MEMBERS; m++){
+    free(data[m]);
+  }
+
+  Fenix_Finalize();
+  MPI_Finalize();
+
+  return error;
+}
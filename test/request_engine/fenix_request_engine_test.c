@@ -0,0 +1,205 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 50000
+#define MEMBERS 4
+
+static int value(int rank, int member, int version, int i){
+  return rank*1000000 + member*100000 + version*COUNT + i;
+}
+
+static void fill(int **data, int rank, int version){
+  for(int m = 0; m < MEMBERS; m++){
+    for(int i = 0; i < COUNT; i++) data[m][i] = value(rank, m, version, i);
+  }
+}
+
+static void istore_all(Fenix_Request *requests){
+  for(int m = 0; m < MEMBERS; m++){
+    Fenix_Data_member_istore(1, m, FENIX_DATA_SUBSET_FULL, requests + m);
+  }
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data[MEMBERS];
+  for(int m = 0; m < MEMBERS; m++){
+    data[m] = (int *) malloc(COUNT * sizeof(int));
+    Fenix_Data_member_create(1, m, data[m], COUNT, MPI_INT);
+  }
+  Fenix_Request requests[MEMBERS];
+
+  //Waitall completes every request and leaves the handles null.
+  fill(data, rank, 0);
+  istore_all(requests);
+  if(Fenix_Data_waitall(MEMBERS, requests) != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: waitall failed\n", rank);
+    error = 1;
+  }
+  for(int m = 0; m < MEMBERS; m++){
+    if(requests[m].slot != FENIX_REQUEST_NULL.slot){
+      printf("Rank %d FAILURE: waitall left request %d set\n", rank, m);
+      error = 1;
+    }
+  }
+  Fenix_Data_commit(1, NULL);
+
+  //Testany hands back each request exactly once, then reports none left.
+  fill(data, rank, 1);
+  istore_all(requests);
+  int seen[MEMBERS] = {0};
+  int completed = 0;
+  while(completed < MEMBERS){
+    int index;
+    if(Fenix_Data_testany(MEMBERS, requests, &index, &flag) != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: testany failed\n", rank);
+      error = 1;
+    }
+    if(index == MPI_UNDEFINED) continue;
+    if(index < 0 || index >= MEMBERS || seen[index]++){
+      printf("Rank %d FAILURE: testany returned index %d again\n", rank, index);
+      error = 1;
+      break;
+    }
+    completed++;
+  }
+  int index;
+  Fenix_Data_testany(MEMBERS, requests, &index, &flag);
+  if(!flag || index != MPI_UNDEFINED){
+    printf("Rank %d FAILURE: testany with no requests left gave flag %d index %d\n",
+           rank, flag, index);
+    error = 1;
+  }
+  Fenix_Data_commit(1, NULL);
+
+  //Testsome lists every request once across its calls.
+  fill(data, rank, 2);
+  istore_all(requests);
+  for(int m = 0; m < MEMBERS; m++) seen[m] = 0;
+  int outcount = 0;
+  while(outcount != MPI_UNDEFINED){
+    int indices[MEMBERS];
+    if(Fenix_Data_testsome(MEMBERS, requests, &outcount, indices) != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: testsome failed\n", rank);
+      error = 1;
+    }
+    for(int i = 0; i < outcount && outcount != MPI_UNDEFINED; i++){
+      if(seen[indices[i]]++){
+        printf("Rank %d FAILURE: testsome returned index %d again\n", rank, indices[i]);
+        error = 1;
+      }
+    }
+  }
+  for(int m = 0; m < MEMBERS; m++){
+    if(!seen[m]){
+      printf("Rank %d FAILURE: testsome never completed request %d\n", rank, m);
+      error = 1;
+    }
+  }
+
+  //A handle kept past completion refers to nothing, even once its slot is reused.
+  Fenix_Request stale;
+  Fenix_Data_member_istore(1, 0, FENIX_DATA_SUBSET_FULL, &stale);
+  Fenix_Data_wait(stale);
+  istore_all(requests);
+  if(Fenix_Data_test(stale, &flag) != FENIX_SUCCESS || !flag){
+    printf("Rank %d FAILURE: completed request is still pending\n", rank);
+    error = 1;
+  }
+  Fenix_Data_waitall(MEMBERS, requests);
+  Fenix_Data_commit(1, NULL);
+
+  for(int m = 0; m < MEMBERS; m++){
+    for(int i = 0; i < COUNT; i++) data[m][i] = -1;
+    int ret = Fenix_Data_member_restore(1, m, data[m], COUNT, FENIX_TIME_STAMP_MAX, NULL);
+    for(int i = 0; i < COUNT && ret == FENIX_SUCCESS; i++){
+      if(data[m][i] != value(rank, m, 2, i)){
+        printf("Rank %d FAILURE: member %d element %d is %d\n", rank, m, i, data[m][i]);
+        error = 1;
+        break;
+      }
+    }
+    if(ret != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: restore of member %d returned %d\n", rank, m, ret);
+      error = 1;
+    }
+  }
+
+  Fenix_Finalize();
+  for(int m = 0; m < MEMBERS; m++) free(data[m]);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
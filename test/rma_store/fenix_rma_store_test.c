@@ -0,0 +1,145 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define COUNT 3000
+
+static int value(int rank, int version, int i){
+  return rank*1000000 + version*COUNT + i;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "FENIX_IMR_TRANSPORT", "RMA");
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, info, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  //Group 1 keeps a local copy, group 2 only has what the partner put.
+  int flag;
+  int mirrored[3] = {1, 1, 0};
+  int partner_only[3] = {FENIX_DATA_POLICY_IMR_PARTNER_ONLY, 1, 0};
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, mirrored, &flag);
+  Fenix_Data_group_create(2, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, partner_only, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+  Fenix_Data_member_create(2, 1, data, COUNT, MPI_INT);
+
+  Fenix_Data_subset partial;
+  Fenix_Data_subset_create(3, 0, 99, 1000, &partial);
+  for(int version = 0; version < 3; version++){
+    for(int i = 0; i < COUNT; i++) data[i] = value(rank, version, i);
+    //Ranks reach their stores at different times, nobody waits for its partner.
+    usleep(((rank + version) % 3) * 20000);
+    Fenix_Data_member_store(1, 1, version == 0 ? FENIX_DATA_SUBSET_FULL : partial);
+    Fenix_Data_member_store(2, 1, FENIX_DATA_SUBSET_FULL);
+    Fenix_Data_commit(1, NULL);
+    Fenix_Data_commit(2, NULL);
+  }
+  Fenix_Data_subset_delete(&partial);
+
+  int repaired = -1;
+  for(int pass = 0; pass < 2; pass++){
+    if(Fenix_Data_group_scrub(1, &repaired) != FENIX_SUCCESS || repaired != 0){
+      printf("Rank %d FAILURE: scrub of put data repaired %d blocks\n", rank, repaired);
+      error = 1;
+    }
+  }
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    int version = (i % 1000 < 100) ? 2 : 0;
+    if(data[i] != value(rank, version, i)){
+      printf("Rank %d FAILURE: mirrored element %d is %d\n", rank, i, data[i]);
+      error = 1;
+      break;
+    }
+  }
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  Fenix_Data_member_restore(2, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(data[i] != value(rank, 2, i)){
+      printf("Rank %d FAILURE: partner-only element %d is %d\n", rank, i, data[i]);
+      error = 1;
+      break;
+    }
+  }
+
+  Fenix_Finalize();
+  free(data);
+  MPI_Info_free(&info);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,140 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 1000
+
+static int reports[3];
+static int wrong_reports;
+
+void sdc_detected(int group_id, int member_id, int kind, void *data) {
+  if(group_id != 1 || member_id != 1 || data != &reports) wrong_reports++;
+  reports[kind]++;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  Fenix_Data_sdc_callback_register(sdc_detected, &reports);
+
+  //The first half is the same on every rank, the second half is immutable.
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  for(int i = 0; i < COUNT; i++) data[i] = i < COUNT/2 ? i : rank*COUNT + i;
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  Fenix_Data_subset replicated, immutable;
+  Fenix_Data_subset_create(1, 0, COUNT/2 - 1, COUNT, &replicated);
+  Fenix_Data_subset_create(1, COUNT/2, COUNT - 1, COUNT, &immutable);
+  Fenix_Data_member_sdc_region(1, 1, FENIX_DATA_SDC_REPLICATED, replicated);
+  Fenix_Data_member_sdc_region(1, 1, FENIX_DATA_SDC_IMMUTABLE, immutable);
+  Fenix_Data_subset_delete(&replicated);
+  Fenix_Data_subset_delete(&immutable);
+
+  int ret = Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, NULL);
+  if(ret != FENIX_SUCCESS || reports[FENIX_DATA_SDC_REPLICATED] || reports[FENIX_DATA_SDC_IMMUTABLE]){
+    printf("Rank %d FAILURE: clean store returned %d\n", rank, ret);
+    error = 1;
+  }
+
+  //Rank 0 flips a replicated value, so both partners see the mismatch.
+  if(rank == 0) data[7] ^= 1;
+  ret = Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  if(ret != FENIX_WARNING_SDC_DETECTED || reports[FENIX_DATA_SDC_REPLICATED] != 1
+        || reports[FENIX_DATA_SDC_IMMUTABLE]){
+    printf("Rank %d FAILURE: replicated mismatch gave %d with %d reports\n", rank, ret,
+           reports[FENIX_DATA_SDC_REPLICATED]);
+    error = 1;
+  }
+  if(rank == 0) data[7] ^= 1;
+
+  //Only the rank whose immutable data changed notices.
+  if(rank == 1) data[COUNT - 3] = -1;
+  ret = Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  int expected = rank == 1 ? FENIX_WARNING_SDC_DETECTED : FENIX_SUCCESS;
+  if(ret != expected || reports[FENIX_DATA_SDC_IMMUTABLE] != (rank == 1)){
+    printf("Rank %d FAILURE: immutable change gave %d\n", rank, ret);
+    error = 1;
+  }
+
+  if(wrong_reports){
+    printf("Rank %d FAILURE: %d reports named the wrong member or data\n", rank, wrong_reports);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(data);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,186 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BLOCK 10
+#define BLOCKS 10
+#define COUNT (BLOCK*BLOCKS)
+#define COMMITS 9
+
+//Version 0 stores everything, each later version only rewrites its own block.
+static int expected(int rank, int version, int i){
+  int block = i / BLOCK;
+  int writer = (block >= 1 && block <= version) ? block : 0;
+  return rank*100000 + writer*1000 + i;
+}
+
+static int check(int *data, int rank, int version){
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  for(int i = 0; i < COUNT; i++){
+    if(data[i] != expected(rank, version, i)){
+      printf("Rank %d FAILURE: element %d of snapshot %d is %d, expected %d\n", rank, i,
+             version, data[i], expected(rank, version, i));
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  if(Fenix_Data_group_set_retention(1, 7, 1, 1) != FENIX_ERROR_INVALID_ATTRIBUTE_VALUE){
+    printf("Rank %d FAILURE: unknown retention policy accepted\n", rank);
+    error = 1;
+  }
+  //Keep every 4th snapshot on top of the latest one.
+  Fenix_Data_group_set_retention(1, FENIX_DATA_RETENTION_EVERY_NTH, 1, 4);
+
+  int data[COUNT];
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  for(int version = 0; version < COMMITS; version++){
+    Fenix_Data_subset subset;
+    if(version == 0){
+      for(int i = 0; i < COUNT; i++) data[i] = expected(rank, 0, i);
+      Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+    } else {
+      for(int i = version*BLOCK; i < (version+1)*BLOCK; i++) data[i] = expected(rank, version, i);
+      Fenix_Data_subset_create(1, version*BLOCK, (version+1)*BLOCK - 1, COUNT, &subset);
+      Fenix_Data_member_store(1, 1, subset);
+      Fenix_Data_subset_delete(&subset);
+    }
+    Fenix_Data_commit(1, NULL);
+  }
+
+  int snapshots = -1;
+  Fenix_Data_group_get_number_of_snapshots(1, &snapshots);
+  if(snapshots != 3){
+    printf("Rank %d FAILURE: %d snapshots kept, expected 3\n", rank, snapshots);
+    error = 1;
+  }
+
+  //Newest first: the latest commit, then the multiples of 4.
+  int kept[3] = {8, 4, 0};
+  for(int position = 0; position < 3; position++){
+    int time_stamp = -1;
+    Fenix_Data_group_get_snapshot_at_position(1, position, &time_stamp);
+    if(time_stamp != kept[position]){
+      printf("Rank %d FAILURE: snapshot at position %d is %d, expected %d\n", rank, position,
+             time_stamp, kept[position]);
+      error = 1;
+    }
+  }
+
+  //Dropped snapshots were folded into the next ones, so no block is missing.
+  error |= check(data, rank, COMMITS - 1);
+
+  //Exponential retention keeps the first snapshot and the newest, with gaps
+  //between the ones kept that never shrink going back in time.
+  Fenix_Data_group_create(2, new_comm, 0, 4, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  Fenix_Data_group_set_retention(2, FENIX_DATA_RETENTION_EXPONENTIAL, 1, 1);
+  int history[COUNT];
+  for(int i = 0; i < COUNT; i++) history[i] = rank*COUNT + i;
+  Fenix_Data_member_create(2, 1, history, COUNT, MPI_INT);
+  for(int version = 0; version < 16; version++){
+    Fenix_Data_member_store(2, 1, FENIX_DATA_SUBSET_FULL);
+    Fenix_Data_commit(2, NULL);
+
+    Fenix_Data_group_get_number_of_snapshots(2, &snapshots);
+    int time_stamps[5] = {-1, -1, -1, -1, -1};
+    for(int position = 0; position < snapshots && position < 5; position++){
+      Fenix_Data_group_get_snapshot_at_position(2, position, time_stamps + position);
+    }
+    int expected_snapshots = version < 5 ? version + 1 : 5;
+    int spaced = snapshots == expected_snapshots && time_stamps[0] == version &&
+                 time_stamps[snapshots - 1] == 0;
+    for(int position = 2; position < snapshots && spaced; position++){
+      spaced = time_stamps[position - 1] - time_stamps[position] >=
+               time_stamps[position - 2] - time_stamps[position - 1];
+    }
+    if(!spaced){
+      printf("Rank %d FAILURE: after commit %d kept %d snapshots: %d %d %d %d %d\n", rank,
+             version, snapshots, time_stamps[0], time_stamps[1], time_stamps[2],
+             time_stamps[3], time_stamps[4]);
+      error = 1;
+      break;
+    }
+  }
+
+  Fenix_Finalize();
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
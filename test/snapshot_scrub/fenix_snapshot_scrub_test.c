@@ -0,0 +1,172 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//Large enough for several checksum blocks per snapshot.
+#define COUNT 5000
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+
+  int rank;
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *data = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, data, COUNT, MPI_INT);
+
+  for(int version = 0; version < 3; version++){
+    for(int i = 0; i < COUNT; i++) data[i] = rank*1000000 + version*COUNT + i;
+    if(version == 0){
+      Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+    } else {
+      //Partial stores only refresh the checksums of the blocks they touch.
+      Fenix_Data_subset subset;
+      Fenix_Data_subset_create(4, 0, 99, 1200, &subset);
+      Fenix_Data_member_store(1, 1, subset);
+      Fenix_Data_subset_delete(&subset);
+    }
+    Fenix_Data_commit(1, NULL);
+  }
+
+  //Untouched snapshots check out and need no repair.
+  for(int pass = 0; pass < 3; pass++){
+    int repaired = -1;
+    int ret = Fenix_Data_group_scrub(1, &repaired);
+    if(ret != FENIX_SUCCESS || repaired != 0){
+      printf("Rank %d FAILURE: scrub pass %d returned %d with %d repairs\n", rank, pass, ret,
+             repaired);
+      error = 1;
+    }
+  }
+
+  for(int i = 0; i < COUNT; i++) data[i] = -1;
+  int ret = Fenix_Data_member_restore(1, 1, data, COUNT, FENIX_TIME_STAMP_MAX, NULL);
+  if(ret != FENIX_SUCCESS){
+    printf("Rank %d FAILURE: restore returned %d\n", rank, ret);
+    error = 1;
+  }
+  for(int i = 0; i < COUNT; i++){
+    int version = (i % 1200 < 100 && i < 4*1200) ? 2 : 0;
+    if(data[i] != rank*1000000 + version*COUNT + i){
+      printf("Rank %d FAILURE: restored element %d is %d\n", rank, i, data[i]);
+      error = 1;
+      break;
+    }
+  }
+
+  //A bit flip in a snapshot is found and repaired from the partner's copy.
+  //store_swap keeps the app's buffer as the snapshot, so writing to it after
+  //the commit stands in for the flip.
+  Fenix_Data_group_create(2, new_comm, 0, 1, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  int *swapped = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(2, 1, swapped, COUNT, MPI_INT);
+  for(int i = 0; i < COUNT; i++) swapped[i] = rank*1000000 + i;
+  int *buffer = swapped;
+  Fenix_Data_member_store_swap(2, 1, (void **) &buffer);
+  Fenix_Data_commit(2, NULL);
+  int *stored = buffer;
+  for(int i = 0; i < COUNT; i++) stored[i] = rank*1000000 + COUNT + i;
+  Fenix_Data_member_store_swap(2, 1, (void **) &buffer);
+  Fenix_Data_commit(2, NULL);
+  if(rank == 0) stored[10] ^= 1;
+
+  //Each pass checks one snapshot, two passes cover both.
+  int repaired = 0;
+  for(int pass = 0; pass < 2; pass++){
+    int pass_repaired = -1;
+    ret = Fenix_Data_group_scrub(2, &pass_repaired);
+    if(ret != FENIX_SUCCESS){
+      printf("Rank %d FAILURE: scrub pass %d of the flipped group returned %d\n", rank, pass, ret);
+      error = 1;
+    }
+    repaired += pass_repaired;
+  }
+  if(repaired != (rank == 0)){
+    printf("Rank %d FAILURE: %d repairs after a flip on rank 0\n", rank, repaired);
+    error = 1;
+  }
+  if(stored[10] != rank*1000000 + COUNT + 10){
+    printf("Rank %d FAILURE: flipped element is still %d\n", rank, stored[10]);
+    error = 1;
+  }
+
+  if(Fenix_Data_group_scrub(3, NULL) != FENIX_ERROR_INVALID_GROUPID){
+    printf("Rank %d FAILURE: unknown group accepted\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(data);
+  free(swapped);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -0,0 +1,192 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 1000
+
+int rank;
+int error = 0;
+
+void fill(int *data, int count, int version) {
+  for(int i = 0; i < count; i++) data[i] = rank*100000 + version*COUNT + i;
+}
+
+int holds(int *data, int count, int version) {
+  for(int i = 0; i < count; i++){
+    if(data[i] != rank*100000 + version*COUNT + i) return 0;
+  }
+  return 1;
+}
+
+void check_restore(int group_id, int time_stamp, int count, int version, const char *when) {
+  int *restored = (int *) malloc(count * sizeof(int));
+  int ret = Fenix_Data_member_restore(group_id, 1, restored, count, time_stamp, NULL);
+  if(ret != FENIX_SUCCESS || !holds(restored, count, version)){
+    printf("Rank %d FAILURE: restore %s returned %d, expected version %d, got %d\n", rank, when, ret,
+           version, (restored[0] - rank*100000)/COUNT);
+    error = 1;
+  }
+  free(restored);
+}
+
+int main(int argc, char **argv) {
+  int fenix_status;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 3, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+
+  int *own = (int *) malloc(COUNT * sizeof(int));
+  Fenix_Data_member_create(1, 1, own, COUNT, MPI_INT);
+
+  //The app's own buffer is copied and handed back a buffer from Fenix.
+  int time_stamp;
+  int *buffer = own;
+  fill(buffer, COUNT, 0);
+  if(Fenix_Data_member_store_swap(1, 1, (void **) &buffer) != FENIX_SUCCESS ||
+     buffer == NULL || buffer == own){
+    printf("Rank %d FAILURE: first store_swap didn't lend a buffer\n", rank);
+    error = 1;
+  }
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(1, FENIX_TIME_STAMP_MAX, COUNT, 0, "after copying the app's buffer");
+
+  //From then on buffers are traded, and the one stored stays readable.
+  for(int version = 1; version <= 4 && !error; version++){
+    int *stored = buffer;
+    fill(stored, COUNT, version);
+    if(Fenix_Data_member_store_swap(1, 1, (void **) &buffer) != FENIX_SUCCESS ||
+       buffer == stored){
+      printf("Rank %d FAILURE: store_swap %d kept the buffer\n", rank, version);
+      error = 1;
+    }
+    Fenix_Data_commit(1, &time_stamp);
+    if(!holds(stored, COUNT, version)){
+      printf("Rank %d FAILURE: stored buffer %d changed after the commit\n", rank, version);
+      error = 1;
+    }
+    check_restore(1, FENIX_TIME_STAMP_MAX, COUNT, version, "after a swap");
+  }
+
+  //Ordinary stores still copy from the member's buffer.
+  fill(own, COUNT, 5);
+  Fenix_Data_member_store(1, 1, FENIX_DATA_SUBSET_FULL);
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(1, FENIX_TIME_STAMP_MAX, COUNT, 5, "after a plain store");
+
+  //Growing the member leaves the buffer lent out with the app, still usable,
+  //but it can't be handed back once it's too small for the member.
+  int grown = 4*COUNT;
+  int *lent = buffer;
+  own = (int *) realloc(own, grown * sizeof(int));
+  Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_BUFFER, own, &flag);
+  Fenix_Data_member_attr_set(1, 1, FENIX_DATA_MEMBER_ATTRIBUTE_COUNT, &grown, &flag);
+  fill(lent, COUNT, 6);
+  if(!holds(lent, COUNT, 6)){
+    printf("Rank %d FAILURE: the lent buffer changed under the resize\n", rank);
+    error = 1;
+  }
+  if(Fenix_Data_member_store_swap(1, 1, (void **) &buffer) != FENIX_ERROR_INVALID_LOGIC_CALL ||
+     buffer != lent){
+    printf("Rank %d FAILURE: a lent buffer too small for the member was taken back\n", rank);
+    error = 1;
+  }
+
+  //Handing over the app's own buffer lends one of the new size, traded as before.
+  fill(own, grown, 7);
+  buffer = own;
+  if(Fenix_Data_member_store_swap(1, 1, (void **) &buffer) != FENIX_SUCCESS || buffer == own){
+    printf("Rank %d FAILURE: store_swap after the resize didn't lend a buffer\n", rank);
+    error = 1;
+  }
+  Fenix_Data_commit(1, &time_stamp);
+  check_restore(1, FENIX_TIME_STAMP_MAX, grown, 7, "after copying the resized buffer");
+  if(!error){
+    int *stored = buffer;
+    fill(stored, grown, 8);
+    Fenix_Data_member_store_swap(1, 1, (void **) &buffer);
+    Fenix_Data_commit(1, &time_stamp);
+    check_restore(1, FENIX_TIME_STAMP_MAX, grown, 8, "after a swap of the resized buffer");
+  }
+
+  //Partner-only groups keep no local snapshot for a buffer to become.
+  int partner_only[3] = {FENIX_DATA_POLICY_IMR_PARTNER_ONLY, 1, 0};
+  Fenix_Data_group_create(2, new_comm, 0, 2, FENIX_DATA_POLICY_IN_MEMORY_RAID, partner_only,
+                          &flag);
+  Fenix_Data_member_create(2, 1, own, COUNT, MPI_INT);
+  int *unchanged = own;
+  if(Fenix_Data_member_store_swap(2, 1, (void **) &unchanged) != FENIX_ERROR_INVALID_LOGIC_CALL ||
+     unchanged != own){
+    printf("Rank %d FAILURE: partner-only store_swap wasn't refused\n", rank);
+    error = 1;
+  }
+
+  Fenix_Finalize();
+  free(own);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}
@@ -3,21 +3,21 @@
 #include <fenix.h>
 void print_subset(Fenix_Data_subset *ss){
    printf("\tnum_blocks:\t %d\n", ss->num_blocks);
-   printf("\tstride:\t\t %d\n", ss->stride);
+   printf("\tstride:\t\t %lld\n", (long long)ss->stride);
    printf("\tspecifier:\t %d\n", ss->specifier);
    printf("\tstart_offsets:\t [");
    for(int i = 0; i < ss->num_blocks; i++){
-      printf( (i==0) ? "%d" : ", %d", ss->start_offsets[i]);
+      printf( (i==0) ? "%lld" : ", %lld", (long long)ss->start_offsets[i]);
    }
    printf("]\n");
    printf("\tend_offsets:\t [");
    for(int i = 0; i < ss->num_blocks; i++){
-      printf( (i==0) ? "%d" : ", %d", ss->end_offsets[i]);
+      printf( (i==0) ? "%lld" : ", %lld", (long long)ss->end_offsets[i]);
    }
    printf("]\n");
    printf("\tnum_repeats:\t [");
    for(int i = 0; i < ss->num_blocks; i++){
-      printf( (i==0) ? "%d" : ", %d", ss->num_repeats[i]);
+      printf( (i==0) ? "%lld" : ", %lld", (long long)ss->num_repeats[i]);
    }
    printf("]\n");
 }
@@ -0,0 +1,168 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//
+//            _|_|_|_|  _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//            _|        _|        _|_|    _|    _|      _|  _|
+//            _|_|_|    _|_|_|    _|  _|  _|    _|        _|
+//            _|        _|        _|    _|_|    _|      _|  _|
+//            _|        _|_|_|_|  _|      _|  _|_|_|  _|      _|
+//
+//
+//
+//
+// Copyright (C) 2016 Rutgers University and Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author Marc Gamell, Eric Valenzuela, Keita Teranishi, Manish Parashar,
+//        Michael Heroux, and Matthew Whitlock
+//
+// Questions? Contact Keita Teranishi (knteran@sandia.gov) and
+//                    Marc Gamell (mgamell@cac.rutgers.edu)
+//
+// ************************************************************************
+//@HEADER
+*/
+#include <fenix.h>
+#include <mpi.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//Each thread checkpoints its own members, as OpenMP threads owning a slice of
+//the app's state would. Timings are printed for 1, 2 and 4 threads.
+#define MEMBERS 4
+#define COUNT (1 << 20)
+#define STORES 8
+
+int rank;
+int *data[MEMBERS];
+int num_threads;
+int failed = 0;
+
+void *store_members(void *arg) {
+  int thread = (int)(size_t) arg;
+  for(int store = 0; store < STORES; store++){
+    for(int member = thread; member < MEMBERS; member += num_threads){
+      int ret;
+      if(store % 2 == 0){
+        ret = Fenix_Data_member_store(1, member, FENIX_DATA_SUBSET_FULL);
+      } else {
+        Fenix_Request request;
+        ret = Fenix_Data_member_istore(1, member, FENIX_DATA_SUBSET_FULL, &request);
+        if(ret == FENIX_SUCCESS) ret = Fenix_Data_wait(request);
+      }
+      if(ret != FENIX_SUCCESS){
+        printf("Rank %d FAILURE: store of member %d on thread %d returned %d\n",
+               rank, member, thread, ret);
+        failed = 1;
+      }
+    }
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  int error = 0;
+  int fenix_status;
+  int provided;
+  MPI_Comm world_comm, new_comm;
+
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  MPI_Comm_dup(MPI_COMM_WORLD, &world_comm);
+  Fenix_Init(&fenix_status, world_comm, &new_comm, &argc, &argv, 0, 0, MPI_INFO_NULL, &error);
+  MPI_Comm_rank(new_comm, &rank);
+
+  if(provided < MPI_THREAD_MULTIPLE){
+    if(rank == 0) printf("MPI_THREAD_MULTIPLE is not provided, skipping\n");
+    Fenix_Finalize();
+    MPI_Finalize();
+    return 0;
+  }
+
+  int policy[3] = {1, 1, 0};
+  int flag;
+  Fenix_Data_group_create(1, new_comm, 0, 0, FENIX_DATA_POLICY_IN_MEMORY_RAID, policy, &flag);
+  for(int member = 0; member < MEMBERS; member++){
+    data[member] = (int *) malloc(COUNT * sizeof(int));
+    Fenix_Data_member_create(1, member, data[member], COUNT, MPI_INT);
+  }
+
+  for(num_threads = 1; num_threads <= MEMBERS; num_threads *= 2){
+    for(int member = 0; member < MEMBERS; member++){
+      for(int i = 0; i < COUNT; i++) data[member][i] = rank*1000000 + member*100000 + num_threads + i;
+    }
+
+    pthread_t threads[MEMBERS];
+    MPI_Barrier(new_comm);
+    double start = MPI_Wtime();
+    for(int thread = 0; thread < num_threads; thread++){
+      pthread_create(threads + thread, NULL, store_members, (void *)(size_t) thread);
+    }
+    for(int thread = 0; thread < num_threads; thread++) pthread_join(threads[thread], NULL);
+    double elapsed = MPI_Wtime() - start;
+    Fenix_Data_commit(1, NULL);
+
+    double slowest;
+    MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, new_comm);
+    if(rank == 0){
+      printf("%d thread(s): %d stores of %d members in %.4f s, %.1f MB/s\n", num_threads, STORES,
+             MEMBERS, slowest, (double) STORES*MEMBERS*COUNT*sizeof(int) / slowest / 1e6);
+    }
+
+    for(int member = 0; member < MEMBERS; member++){
+      for(int i = 0; i < COUNT; i++) data[member][i] = -1;
+      int ret = Fenix_Data_member_restore(1, member, data[member], COUNT, FENIX_TIME_STAMP_MAX, NULL);
+      if(ret != FENIX_SUCCESS){
+        printf("Rank %d FAILURE: restore of member %d returned %d\n", rank, member, ret);
+        error = 1;
+      }
+      for(int i = 0; i < COUNT; i++){
+        if(data[member][i] != rank*1000000 + member*100000 + num_threads + i){
+          printf("Rank %d FAILURE: member %d element %d is %d with %d thread(s)\n", rank, member, i,
+                 data[member][i], num_threads);
+          error = 1;
+          break;
+        }
+      }
+    }
+  }
+  error |= failed;
+
+  Fenix_Finalize();
+  for(int member = 0; member < MEMBERS; member++) free(data[member]);
+  MPI_Finalize();
+
+  if(!error && rank == 0) printf("Passed\n");
+  return error;
+}